@@ -0,0 +1,74 @@
+/**
+ * @file
+ * @brief Passenger wait and journey times of a single car under each dispatch policy.
+ *
+ * Runs one car against the simulated plant on a virtual clock, with passengers travelling
+ * between random floors as described in traffic.h. Every policy is run on the same
+ * passengers. Run it with @c make bench_dispatch.
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "driver/sim.h"
+#include "elevator_fsm.h"
+#include "globals.h"
+#include "timer.h"
+#include "traffic.h"
+
+
+#define BENCH_DEFAULT_SECONDS 3600
+#define BENCH_TICK_NS (1000000000LL / CONTROL_RATE_HZ)
+
+
+static void bench_run(queue_policy_t policy, int passengers_per_hour, long long seconds) {
+    sim_use_virtual_clock();
+    if(hardware_init() != 0) {
+        fprintf(stderr, "Unable to initialize hardware\n");
+        exit(1);
+    }
+    elevator_data_t elevator_data = elevator_init();
+    elevator_data.policy = policy;
+
+    static traffic_t traffic;
+    traffic_init(&traffic, passengers_per_hour, 1, 0);
+
+    long long ticks = seconds * CONTROL_RATE_HZ;
+    for(long long tick = 0; tick < ticks; tick++) {
+        if(rand_r(&traffic.seed) % (3600LL * CONTROL_RATE_HZ) < passengers_per_hour) {
+            int origin = rand_r(&traffic.seed) % HARDWARE_NUMBER_OF_FLOORS;
+            traffic_add_passenger(&traffic, origin, (origin + 1 + rand_r(&traffic.seed) % (HARDWARE_NUMBER_OF_FLOORS - 1)) % HARDWARE_NUMBER_OF_FLOORS);
+        }
+
+        elevator_tick(&elevator_data);
+        traffic_step(&traffic);
+        sim_advance(BENCH_TICK_NS);
+    }
+
+    traffic_stats_t stats = traffic_summarize(&traffic);
+    printf("%5d/h  %-8s %6d passengers %6d arrived  wait mean %6.1f s  p95 %6.1f s  journey mean %6.1f s  p95 %6.1f s\n",
+           passengers_per_hour, queue_policy_name(policy), traffic.count, stats.delivered,
+           stats.wait_mean_s, stats.wait_p95_s, stats.journey_mean_s, stats.journey_p95_s);
+}
+
+
+int main(int argc, char** argv) {
+    static const int passenger_rates[] = { 30, 60, 120 };
+
+    long long seconds = (argc > 1) ? atoll(argv[1]) : BENCH_DEFAULT_SECONDS;
+    if(seconds <= 0) {
+        fprintf(stderr, "Usage: %s [simulated seconds]\n", argv[0]);
+        return 1;
+    }
+
+    timer_set_clock(sim_now_ns);
+    printf("%s, %d floors, %lld simulated seconds per run\n", BUILDING_NAME, HARDWARE_NUMBER_OF_FLOORS, seconds);
+
+    for(int i = 0; i < (int)(sizeof(passenger_rates) / sizeof(passenger_rates[0])); i++) {
+        for(int policy = 0; policy < QUEUE_POLICY_COUNT; policy++) {
+            bench_run(policy, passenger_rates[i], seconds);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,86 @@
+/**
+ * @file
+ * @brief Cost of one control cycle as a function of the number of floors.
+ *
+ * Runs the controller against the simulated plant on a virtual clock, pressing a random
+ * button once per simulated second, and times only @c elevator_tick(). Build and run it
+ * for every building with @c make bench_floors.
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "driver/sim.h"
+#include "elevator_fsm.h"
+#include "globals.h"
+#include "timer.h"
+
+
+#define BENCH_DEFAULT_TICKS 200000
+#define BENCH_PRESS_EVERY_TICKS CONTROL_RATE_HZ
+
+
+static long long bench_clock_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+
+static void bench_press_random_button() {
+    static const HardwareOrder types[] = { HARDWARE_ORDER_UP, HARDWARE_ORDER_INSIDE, HARDWARE_ORDER_DOWN };
+
+    int floor = rand() % HARDWARE_NUMBER_OF_FLOORS;
+    HardwareOrder order_type = types[rand() % 3];
+    // Hall calls that do not exist on the end floors become cab calls
+    if((floor == MIN_FLOOR && order_type == HARDWARE_ORDER_DOWN) ||
+       (floor == HARDWARE_NUMBER_OF_FLOORS - 1 && order_type == HARDWARE_ORDER_UP)) {
+        order_type = HARDWARE_ORDER_INSIDE;
+    }
+    sim_press_order(floor, order_type);
+}
+
+
+int main(int argc, char** argv) {
+    long long ticks = (argc > 1) ? atoll(argv[1]) : BENCH_DEFAULT_TICKS;
+    if(ticks <= 0) {
+        fprintf(stderr, "Usage: %s [ticks]\n", argv[0]);
+        return 1;
+    }
+
+    sim_use_virtual_clock();
+    timer_set_clock(sim_now_ns);
+    srand(1);
+
+    if(hardware_init() != 0) {
+        fprintf(stderr, "Unable to initialize hardware\n");
+        return 1;
+    }
+    elevator_data_t elevator_data = elevator_init();
+
+    long long busy_ns = 0;
+    long long floors_passed = 0;
+    int last_floor = elevator_data.last_floor;
+
+    for(long long tick = 0; tick < ticks; tick++) {
+        if(tick % BENCH_PRESS_EVERY_TICKS == 0) {
+            bench_press_random_button();
+        }
+
+        long long start_ns = bench_clock_ns();
+        elevator_tick(&elevator_data);
+        busy_ns += bench_clock_ns() - start_ns;
+
+        if(elevator_data.last_floor != last_floor) {
+            floors_passed++;
+            last_floor = elevator_data.last_floor;
+        }
+        sim_advance(1000000000LL / CONTROL_RATE_HZ);
+    }
+
+    printf("%-10s %4d floors: %8.1f ns/tick over %lld ticks, %lld floors passed\n",
+           BUILDING_NAME, HARDWARE_NUMBER_OF_FLOORS, (double)busy_ns / ticks, ticks, floors_passed);
+    return 0;
+}
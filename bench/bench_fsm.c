@@ -0,0 +1,302 @@
+/**
+ * @file
+ * @brief Transition rate of the generated FSM table against the hand-written switch it replaced.
+ *
+ * The controller is run against the simulated plant on a virtual clock with random button
+ * presses, stop button presses and obstructions, and every (state, event, guards) it sees is
+ * recorded. The recorded trace is then replayed through @c elevator_fsm_lookup() and through
+ * @c legacy_transition() , a copy of the decisions of the old nested switch, fall-through included.
+ * The replay fails if the two disagree on any step. Run it with @c make bench_fsm.
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "driver/sim.h"
+#include "elevator_fsm.h"
+#include "elevator_io.h"
+#include "globals.h"
+#include "timer.h"
+
+
+#define BENCH_DEFAULT_TICKS 2000000
+#define BENCH_REPLAYS 20
+#define BENCH_TICK_NS (1000000000LL / CONTROL_RATE_HZ)
+
+
+typedef struct{
+    uint8_t state;
+    uint8_t event;
+    uint8_t guard_mask;
+} bench_step_t;
+
+
+static long long bench_clock_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+
+/**
+ * @brief The decisions of elevator_update_state() before the table, with its side effects removed
+ */
+static elevator_transition_t legacy_transition(elevator_state_t state, elevator_event_t event, unsigned int guard_mask) {
+    elevator_transition_t result = { 0 };
+    int timer_done = (guard_mask & GUARD_TIMER_DONE) != 0;
+    int at_floor = (guard_mask & GUARD_AT_FLOOR) != 0;
+
+#define LEGACY_RETURN(next, action_) do { result.next_state = (next); result.action = (action_); return result; } while(0)
+
+    switch(state) {
+        case STATE_IDLE: {
+            switch(event) {
+                case EVENT_STOP_BUTTON_HIGH:
+                    LEGACY_RETURN(STATE_EMERGENCY, ACTION_EMERGENCY);
+
+                case EVENT_QUEUE_EMPTY:
+                    LEGACY_RETURN(STATE_IDLE, ACTION_DO_NOTHING);
+
+                case EVENT_QUEUE_NOT_EMPTY:
+                    if(guard_mask & GUARD_TARGET_FLOOR_ABOVE) {
+                        LEGACY_RETURN(STATE_MOVING_UP, ACTION_MOVE_UP);
+                    }
+                    if(guard_mask & GUARD_TARGET_FLOOR_EQUAL) {
+                        LEGACY_RETURN(STATE_DOOR_OPEN, ACTION_START_DOOR_TIMER);
+                    }
+                    if(guard_mask & GUARD_TARGET_FLOOR_BELOW) {
+                        LEGACY_RETURN(STATE_MOVING_DOWN, ACTION_MOVE_DOWN);
+                    }
+                    // Fall through
+                case EVENT_NO_EVENT:
+                    LEGACY_RETURN(STATE_IDLE, ACTION_DO_NOTHING);
+            }
+        }
+        // Fall through
+        case STATE_DOOR_OPEN: {
+            switch(event) {
+                case EVENT_STOP_BUTTON_HIGH:
+                    LEGACY_RETURN(STATE_EMERGENCY, ACTION_EMERGENCY);
+
+                case EVENT_QUEUE_EMPTY:
+                    LEGACY_RETURN(STATE_IDLE, ACTION_CLOSE_DOOR);
+
+                case EVENT_OBSTRUCTION_HIGH:
+                    LEGACY_RETURN(STATE_DOOR_OPEN, ACTION_START_DOOR_TIMER);
+
+                case EVENT_TARGET_FLOOR_DIFF:
+                    if((guard_mask & GUARD_TARGET_FLOOR_ABOVE) && timer_done) {
+                        LEGACY_RETURN(STATE_MOVING_UP, ACTION_MOVE_UP);
+                    }
+                    if((guard_mask & GUARD_TARGET_FLOOR_BELOW) && timer_done) {
+                        LEGACY_RETURN(STATE_MOVING_DOWN, ACTION_MOVE_DOWN);
+                    }
+                    // Fall through
+                case EVENT_NO_EVENT:
+                    if(timer_done) {
+                        LEGACY_RETURN(STATE_IDLE, ACTION_CLOSE_DOOR);
+                    }
+                    LEGACY_RETURN(STATE_DOOR_OPEN, ACTION_DO_NOTHING);
+            }
+        }
+        // Fall through
+        case STATE_MOVING_UP: {
+            switch(event) {
+                case EVENT_STOP_BUTTON_HIGH:
+                    LEGACY_RETURN(STATE_EMERGENCY, ACTION_EMERGENCY);
+
+                case EVENT_FLOOR_MATCH:
+                    if(guard_mask & GUARD_DIRECTION) {
+                        LEGACY_RETURN(STATE_DOOR_OPEN, ACTION_START_DOOR_TIMER);
+                    }
+                    // Fall through
+                case EVENT_NO_EVENT:
+                    LEGACY_RETURN(STATE_MOVING_UP, ACTION_DO_NOTHING);
+            }
+        }
+        // Fall through
+        case STATE_MOVING_DOWN: {
+            switch(event) {
+                case EVENT_STOP_BUTTON_HIGH:
+                    LEGACY_RETURN(STATE_EMERGENCY, ACTION_EMERGENCY);
+
+                case EVENT_FLOOR_MATCH:
+                    if(guard_mask & GUARD_DIRECTION) {
+                        LEGACY_RETURN(STATE_DOOR_OPEN, ACTION_START_DOOR_TIMER);
+                    }
+                    // Fall through
+                case EVENT_NO_EVENT:
+                    LEGACY_RETURN(STATE_MOVING_DOWN, ACTION_DO_NOTHING);
+            }
+        }
+        // Fall through
+        case STATE_EMERGENCY: {
+            switch(event) {
+                case EVENT_STOP_BUTTON_HIGH:
+                    LEGACY_RETURN(STATE_EMERGENCY, ACTION_EMERGENCY);
+
+                case EVENT_STOP_BUTTON_LOW:
+                    if(timer_done && at_floor) {
+                        LEGACY_RETURN(STATE_DOOR_OPEN, ACTION_DO_NOTHING);
+                    }
+                    if(timer_done && !at_floor) {
+                        LEGACY_RETURN(STATE_IDLE, ACTION_DO_NOTHING);
+                    }
+                    // Fall through
+                case EVENT_NO_EVENT:
+                    LEGACY_RETURN(STATE_EMERGENCY, ACTION_DO_NOTHING);
+            }
+        }
+    }
+#undef LEGACY_RETURN
+
+    result.next_state = state;
+    result.action = ACTION_DO_NOTHING;
+    return result;
+}
+
+
+static void bench_stimulate(long long tick) {
+    static const HardwareOrder types[] = { HARDWARE_ORDER_UP, HARDWARE_ORDER_INSIDE, HARDWARE_ORDER_DOWN };
+    long long second = tick / CONTROL_RATE_HZ;
+
+    if(tick % CONTROL_RATE_HZ == 0) {
+        int floor = rand() % HARDWARE_NUMBER_OF_FLOORS;
+        HardwareOrder order_type = types[rand() % 3];
+        if((floor == MIN_FLOOR && order_type == HARDWARE_ORDER_DOWN) ||
+           (floor == HARDWARE_NUMBER_OF_FLOORS - 1 && order_type == HARDWARE_ORDER_UP)) {
+            order_type = HARDWARE_ORDER_INSIDE;
+        }
+        sim_press_order(floor, order_type);
+    }
+
+    // Hold the stop button for a second every two minutes, at a different point of the ride each time
+    sim_set_stop(second % 120 == 117);
+    // Obstruct the door for four seconds every 45 seconds
+    sim_set_obstruction(second % 45 < 4);
+}
+
+
+static bench_step_t* bench_record(long long ticks) {
+    bench_step_t* p_trace = malloc(ticks * sizeof(*p_trace));
+    if(p_trace == NULL) {
+        return NULL;
+    }
+
+    elevator_data_t elevator_data = elevator_init();
+
+    for(long long tick = 0; tick < ticks; tick++) {
+        bench_stimulate(tick);
+
+        // elevator_tick(), with the state update split open to record it
+        elevator_begin_tick(&elevator_data);
+        elevator_data.last_floor = update_valid_floor(&elevator_data.sensors, elevator_data.last_floor);
+        set_floor_indicator_light(elevator_data.sensors.current_floor);
+        update_button_state(&elevator_data);
+
+        elevator_event_t event = elevator_update_event(&elevator_data);
+        elevator_guard_t guards = elevator_update_guards(&elevator_data);
+        failsafe_invalid_state(&elevator_data);
+
+        p_trace[tick].state = elevator_data.state;
+        p_trace[tick].event = event;
+        p_trace[tick].guard_mask = elevator_guard_mask(&guards);
+
+        elevator_data.next_action = elevator_take_transition(&elevator_data, event, p_trace[tick].guard_mask);
+        elevator_execute_next_action(&elevator_data);
+        hardware_flush_outputs();
+
+        sim_advance(BENCH_TICK_NS);
+    }
+
+    return p_trace;
+}
+
+
+static long long bench_mismatches(const bench_step_t* p_trace, long long ticks) {
+    long long mismatches = 0;
+    for(long long i = 0; i < ticks; i++) {
+        elevator_transition_t table = elevator_fsm_lookup(p_trace[i].state, p_trace[i].event, p_trace[i].guard_mask);
+        elevator_transition_t legacy = legacy_transition(p_trace[i].state, p_trace[i].event, p_trace[i].guard_mask);
+        if(table.next_state != legacy.next_state || table.action != legacy.action) {
+            if(mismatches++ < 10) {
+                fprintf(stderr, "Step %lld: state %d, event %d, guards 0x%02x: table gives (%d, %d), switch gives (%d, %d)\n",
+                        i, p_trace[i].state, p_trace[i].event, p_trace[i].guard_mask,
+                        table.next_state, table.action, legacy.next_state, legacy.action);
+            }
+        }
+    }
+    return mismatches;
+}
+
+
+static int bench_distinct_steps(const bench_step_t* p_trace, long long ticks) {
+    static uint8_t seen[STATE_COUNT][EVENT_COUNT][128];
+    int distinct = 0;
+    for(long long i = 0; i < ticks; i++) {
+        uint8_t* p_seen = &seen[p_trace[i].state][p_trace[i].event][p_trace[i].guard_mask];
+        distinct += !*p_seen;
+        *p_seen = 1;
+    }
+    return distinct;
+}
+
+
+static double bench_rate(const bench_step_t* p_trace, long long ticks,
+                         elevator_transition_t (*transition)(elevator_state_t, elevator_event_t, unsigned int)) {
+    volatile unsigned int sink = 0;
+    long long start_ns = bench_clock_ns();
+    for(int replay = 0; replay < BENCH_REPLAYS; replay++) {
+        unsigned int checksum = 0;
+        for(long long i = 0; i < ticks; i++) {
+            elevator_transition_t result = transition(p_trace[i].state, p_trace[i].event, p_trace[i].guard_mask);
+            checksum += result.next_state * 8 + result.action;
+        }
+        sink += checksum;
+    }
+    long long elapsed_ns = bench_clock_ns() - start_ns;
+    return 1e9 * BENCH_REPLAYS * ticks / elapsed_ns;
+}
+
+
+int main(int argc, char** argv) {
+    long long ticks = (argc > 1) ? atoll(argv[1]) : BENCH_DEFAULT_TICKS;
+    if(ticks <= 0) {
+        fprintf(stderr, "Usage: %s [ticks]\n", argv[0]);
+        return 1;
+    }
+
+    sim_use_virtual_clock();
+    timer_set_clock(sim_now_ns);
+    srand(1);
+
+    if(hardware_init() != 0) {
+        fprintf(stderr, "Unable to initialize hardware\n");
+        return 1;
+    }
+
+    bench_step_t* p_trace = bench_record(ticks);
+    if(p_trace == NULL) {
+        fprintf(stderr, "Unable to allocate a trace of %lld steps\n", ticks);
+        return 1;
+    }
+
+    long long mismatches = bench_mismatches(p_trace, ticks);
+    printf("Recorded %lld steps, %d distinct (state, event, guards)\n", ticks, bench_distinct_steps(p_trace, ticks));
+    if(mismatches > 0) {
+        printf("Table and switch disagree on %lld steps\n", mismatches);
+        free(p_trace);
+        return 1;
+    }
+    printf("Table and switch agree on every step\n");
+
+    double legacy_rate = bench_rate(p_trace, ticks, legacy_transition);
+    double table_rate = bench_rate(p_trace, ticks, elevator_fsm_lookup);
+    printf("Nested switch:   %6.1f M transitions/s\n", legacy_rate / 1e6);
+    printf("Generated table: %6.1f M transitions/s\n", table_rate / 1e6);
+
+    free(p_trace);
+    return 0;
+}
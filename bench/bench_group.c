@@ -0,0 +1,133 @@
+/**
+ * @file
+ * @brief Hall-call wait time of a bank of cars under each assignment policy.
+ *
+ * Runs banks of 2 to 16 cars against the simulated plant on a virtual clock. Hall calls arrive
+ * at random floors at a rate that grows with the number of cars. When a call is served, the
+ * passenger presses a cab button for a random floor in the direction of the call, so the cars
+ * carry committed stops as well. Every bank is run once with ETA assignment and once with
+ * nearest-car assignment, on the same arrivals. Run it with @c make bench_group.
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "driver/sim.h"
+#include "globals.h"
+#include "group.h"
+#include "timer.h"
+
+
+#define BENCH_DEFAULT_SECONDS 3600
+#define BENCH_TICK_NS (1000000000LL / CONTROL_RATE_HZ)
+#define BENCH_CALLS_PER_CAR_HOUR 120
+#define BENCH_MAX_SERVED 1000000
+
+
+typedef struct{
+    double waits_s[BENCH_MAX_SERVED];
+    int served;
+    unsigned int destination_seed;      // Separate from the arrivals, so every policy sees the same calls
+} bench_waits_t;
+
+
+static int bench_compare_double(const void* a, const void* b) {
+    double x = *(const double*)a;
+    double y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+
+static int bench_random_floor(unsigned int* p_seed, int above, int below) {
+    return above + 1 + rand_r(p_seed) % (below - above - 1);
+}
+
+
+static void bench_passenger_boards(void* arg, int car, const group_call_t* p_call) {
+    bench_waits_t* p_waits = arg;
+    if(p_waits->served < BENCH_MAX_SERVED) {
+        p_waits->waits_s[p_waits->served++] = (timer_now_ns() - p_call->pressed_ns) / 1e9;
+    }
+
+    int destination = (p_call->order_type == HARDWARE_ORDER_UP)
+                    ? bench_random_floor(&p_waits->destination_seed, p_call->floor, HARDWARE_NUMBER_OF_FLOORS)
+                    : bench_random_floor(&p_waits->destination_seed, MIN_FLOOR - 1, p_call->floor);
+    hardware_select_car(car);
+    sim_press_order(destination, HARDWARE_ORDER_INSIDE);
+    hardware_select_car(0);
+}
+
+
+static void bench_call(unsigned int* p_seed) {
+    int floor = rand_r(p_seed) % HARDWARE_NUMBER_OF_FLOORS;
+    HardwareOrder order_type = (rand_r(p_seed) % 2) ? HARDWARE_ORDER_UP : HARDWARE_ORDER_DOWN;
+    if(floor == MIN_FLOOR) {
+        order_type = HARDWARE_ORDER_UP;
+    }
+    if(floor == HARDWARE_NUMBER_OF_FLOORS - 1) {
+        order_type = HARDWARE_ORDER_DOWN;
+    }
+    sim_press_order(floor, order_type);
+}
+
+
+static void bench_run(int car_count, group_policy_t policy, long long seconds, bench_waits_t* p_waits) {
+    static group_t group;
+
+    sim_use_virtual_clock();
+    unsigned int arrival_seed = car_count;
+    p_waits->destination_seed = car_count + 1000;
+    if(group_init(&group, car_count, policy) != 0) {
+        fprintf(stderr, "Unable to initialize hardware\n");
+        exit(1);
+    }
+    p_waits->served = 0;
+    group.on_served = bench_passenger_boards;
+    group.on_served_arg = p_waits;
+
+    long long calls_per_hour = (long long)BENCH_CALLS_PER_CAR_HOUR * car_count;
+    long long ticks = seconds * CONTROL_RATE_HZ;
+    for(long long tick = 0; tick < ticks; tick++) {
+        if(rand_r(&arrival_seed) % (3600LL * CONTROL_RATE_HZ) < calls_per_hour) {
+            bench_call(&arrival_seed);
+        }
+        group_tick(&group);
+        sim_advance(BENCH_TICK_NS);
+    }
+
+    qsort(p_waits->waits_s, p_waits->served, sizeof(double), bench_compare_double);
+    double sum = 0.0;
+    for(int i = 0; i < p_waits->served; i++) {
+        sum += p_waits->waits_s[i];
+    }
+    double mean = (p_waits->served > 0) ? sum / p_waits->served : 0.0;
+    double p95 = (p_waits->served > 0) ? p_waits->waits_s[(int)(0.95 * (p_waits->served - 1))] : 0.0;
+
+    printf("%5d cars  %-8s %7lld calls %7lld served %6lld reassigned   wait mean %6.1f s  p95 %6.1f s  max %6.1f s\n",
+           car_count, group_policy_name(policy), group.stats.calls, group.stats.served, group.stats.reassigned,
+           mean, p95, group.stats.wait_max_ns / 1e9);
+}
+
+
+int main(int argc, char** argv) {
+    static const int car_counts[] = { 2, 4, 8, 16 };
+    static bench_waits_t waits;
+
+    long long seconds = (argc > 1) ? atoll(argv[1]) : BENCH_DEFAULT_SECONDS;
+    if(seconds <= 0) {
+        fprintf(stderr, "Usage: %s [simulated seconds]\n", argv[0]);
+        return 1;
+    }
+
+    timer_set_clock(sim_now_ns);
+    printf("%s, %d floors, %d hall calls per car and hour, %lld simulated seconds per run\n",
+           BUILDING_NAME, HARDWARE_NUMBER_OF_FLOORS, BENCH_CALLS_PER_CAR_HOUR, seconds);
+
+    for(int i = 0; i < (int)(sizeof(car_counts) / sizeof(car_counts[0])); i++) {
+        for(int policy = 0; policy < GROUP_POLICY_COUNT; policy++) {
+            bench_run(car_counts[i], policy, seconds, &waits);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,103 @@
+/**
+ * @file
+ * @brief Run times and stopping accuracy of the motor's speed profile.
+ *
+ * Runs one car against the simulated plant on a virtual clock, from the bottom floor to floors
+ * further and further up and back, once with the motor at the lab rig's fixed speed and once
+ * along the default profile of motion.h. A run is timed from the cab call until the door opens,
+ * and its overshoot is how far past the floor, in the direction of travel, the car comes to rest.
+ * A negative overshoot is a stop short of the floor. The worst error of the controller's estimate
+ * of the position, from position.h, is reported for every profile. Run it with @c make bench_motion.
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "driver/sim.h"
+#include "elevator_fsm.h"
+#include "globals.h"
+#include "timer.h"
+
+
+#define BENCH_TICK_NS (1000000000LL / CONTROL_RATE_HZ)
+#define BENCH_RUN_LIMIT_NS (120 * 1000000000LL)
+
+
+typedef struct{
+    double seconds;             /**< From the cab call until the door opened*/
+    double overshoot;           /**< Floors past the floor the car rests at, in the direction of travel*/
+    double estimate_error;      /**< Largest distance between the estimated and the simulated position*/
+} bench_run_t;
+
+
+static void bench_tick(elevator_data_t* p_elevator_data, bench_run_t* p_run) {
+    elevator_tick(p_elevator_data);
+    // Compared before the plant moves on, since the estimate is of the start of the tick
+    p_run->estimate_error = fmax(p_run->estimate_error, fabs(p_elevator_data->position.floor - sim_get_position()));
+    sim_advance(BENCH_TICK_NS);
+}
+
+
+/**
+ * @brief Call the car from where it stands to @p floor with a cab call, and wait until it is idle again
+ */
+static bench_run_t bench_run_to(elevator_data_t* p_elevator_data, int floor) {
+    double from = sim_get_position();
+    long long start_ns = sim_now_ns();
+    sim_press_order(floor, HARDWARE_ORDER_INSIDE);
+
+    bench_run_t run = { 0 };
+    while(!sim_get_door_open() && sim_now_ns() - start_ns < BENCH_RUN_LIMIT_NS) {
+        bench_tick(p_elevator_data, &run);
+    }
+    run.seconds = (sim_now_ns() - start_ns) * 1e-9;
+
+    while(p_elevator_data->state != STATE_IDLE && sim_now_ns() - start_ns < BENCH_RUN_LIMIT_NS) {
+        bench_tick(p_elevator_data, &run);
+    }
+    run.overshoot = (floor > from) ? sim_get_position() - floor : floor - sim_get_position();
+    return run;
+}
+
+
+static void bench_profile(const char* name, motion_profile_t profile) {
+    static const int floors[] = { 1, 2, 3, 5, 8, HARDWARE_NUMBER_OF_FLOORS - 1 };
+
+    sim_use_virtual_clock();
+    if(hardware_init() != 0) {
+        fprintf(stderr, "Unable to initialize hardware\n");
+        exit(1);
+    }
+    elevator_data_t elevator_data = elevator_init();
+    elevator_data.motion.profile = profile;
+
+    double worst = 0.0;
+    double estimate_error = 0.0;
+    for(int i = 0; i < (int)(sizeof(floors) / sizeof(floors[0])); i++) {
+        if(floors[i] >= HARDWARE_NUMBER_OF_FLOORS || (i > 0 && floors[i] <= floors[i - 1])) {
+            continue;
+        }
+        bench_run_t up = bench_run_to(&elevator_data, floors[i]);
+        bench_run_t down = bench_run_to(&elevator_data, MIN_FLOOR);
+        printf("  %-6s %3d floors  up %6.2f s  down %6.2f s  %5.2f s/floor  overshoot up %+.3f down %+.3f floors\n",
+               name, floors[i], up.seconds, down.seconds, (up.seconds + down.seconds) / (2 * floors[i]), up.overshoot, down.overshoot);
+        worst = fmax(worst, fmax(fabs(up.overshoot), fabs(down.overshoot)));
+        estimate_error = fmax(estimate_error, fmax(up.estimate_error, down.estimate_error));
+    }
+    printf("  %-6s cruise %d, landing %d within %.1f floors, ramp %d/s: worst stop %.3f floors from the floor, worst estimate %.3f floors off\n",
+           name, profile.cruise_speed, profile.landing_speed, profile.landing_floors, profile.ramp_per_s, worst, estimate_error);
+}
+
+
+int main() {
+    timer_set_clock(sim_now_ns);
+    printf("%s, %d floors, %d Hz control\n", BUILDING_NAME, HARDWARE_NUMBER_OF_FLOORS, CONTROL_RATE_HZ);
+
+    motion_t motion;
+    motion_init(&motion);
+    bench_profile("fixed", motion_fixed_profile());
+    bench_profile("ramped", motion.profile);
+    return 0;
+}
@@ -0,0 +1,146 @@
+/**
+ * @file
+ * @brief Passenger-level key performance indicators of the controller under standard traffic.
+ *
+ * Runs every scenario file given on the command line against the simulated plant on a
+ * virtual clock, with a single car or a group of cars, and reports the wait and journey times
+ * of the passengers, the handling capacity, the motor starts and distance of the cars, and the
+ * time their doors were open. Every scenario is run on the same arrivals with the fixed and the
+ * adaptive door dwell of door.h, and with the adaptive dwell and idle cars parked by a demand model
+ * of demand.h that starts the run knowing nothing. Run the scenarios in bench/scenarios with @c make bench.
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "driver/sim.h"
+#include "globals.h"
+#include "group.h"
+#include "timer.h"
+#include "traffic.h"
+
+
+#define BENCH_TICK_NS (1000000000LL / CONTROL_RATE_HZ)
+#define BENCH_SEED 1
+
+
+/**
+ * How the cars of a run are set up
+ */
+typedef struct{
+    const char* name;
+    door_policy_t door_policy;
+    int parking;                // 1 to park idle cars by a demand model
+} bench_variant_t;
+
+
+static const bench_variant_t bench_variants[] = {
+    { "fixed door", DOOR_POLICY_FIXED, 0 },
+    { "adaptive door", DOOR_POLICY_ADAPTIVE, 0 },
+    { "adaptive door, parking", DOOR_POLICY_ADAPTIVE, 1 },
+};
+
+
+static int bench_run(const traffic_scenario_t* p_scenario, const bench_variant_t* p_variant) {
+    static group_t group;
+    static elevator_data_t elevator_data;
+    static traffic_t traffic;
+    static demand_t demand;
+
+    sim_use_virtual_clock();
+    if(p_variant->parking && demand_open(&demand, NULL, 0) != 0) {
+        return -1;
+    }
+    demand_t* p_demand = p_variant->parking ? &demand : NULL;
+    if(p_scenario->cars > 1) {
+        if(group_init(&group, p_scenario->cars, GROUP_POLICY_ETA) != 0) {
+            return -1;
+        }
+        for(int car = 0; car < p_scenario->cars; car++) {
+            group.cars[car].policy = p_scenario->policy;
+            group.cars[car].door.policy = p_variant->door_policy;
+        }
+        group.p_demand = p_demand;
+    }
+    else {
+        if(hardware_select_car(0) != 0 || hardware_init() != 0) {
+            return -1;
+        }
+        elevator_data = elevator_init();
+        elevator_data.policy = p_scenario->policy;
+        elevator_data.door.policy = p_variant->door_policy;
+        elevator_data.p_demand = p_demand;
+    }
+    traffic_init(&traffic, BENCH_SEED, p_scenario->cars, p_scenario->capacity);
+
+    long long ticks = p_scenario->duration_s * CONTROL_RATE_HZ;
+    long long door_open_ticks = 0;
+    for(long long tick = 0; tick < ticks; tick++) {
+        traffic_generate(&traffic, p_scenario, BENCH_TICK_NS);
+        if(p_scenario->cars > 1) {
+            group_tick(&group);
+        }
+        else {
+            elevator_tick(&elevator_data);
+        }
+        traffic_step(&traffic);
+        for(int car = 0; car < p_scenario->cars; car++) {
+            hardware_select_car(car);
+            door_open_ticks += sim_get_door_open();
+        }
+        hardware_select_car(0);
+        sim_advance(BENCH_TICK_NS);
+    }
+
+    long long motor_starts = 0;
+    double distance = 0.0;
+    for(int car = 0; car < p_scenario->cars; car++) {
+        hardware_select_car(car);
+        motor_starts += sim_get_motor_starts();
+        distance += sim_get_distance();
+    }
+    hardware_select_car(0);
+
+    if(p_variant->parking) {
+        demand_close(&demand);
+    }
+
+    traffic_stats_t stats = traffic_summarize(&traffic);
+    printf("%s: %d car%s, capacity %d, %s dispatch, %s, %lld simulated seconds\n", p_scenario->name, p_scenario->cars,
+           (p_scenario->cars > 1) ? "s" : "", p_scenario->capacity, queue_policy_name(p_scenario->policy),
+           p_variant->name, p_scenario->duration_s);
+    printf("  passengers       %6d arrived  %6d delivered\n", traffic.count, stats.delivered);
+    printf("  wait        [s]  mean %6.1f  p95 %6.1f  p99 %6.1f\n", stats.wait_mean_s, stats.wait_p95_s, stats.wait_p99_s);
+    printf("  journey     [s]  mean %6.1f  p95 %6.1f  p99 %6.1f\n", stats.journey_mean_s, stats.journey_p95_s, stats.journey_p99_s);
+    printf("  handling capacity %5d passengers per %d s\n", stats.handling_capacity, TRAFFIC_WINDOW_S);
+    printf("  motor starts     %6lld  distance %8.0f floors\n", motor_starts, distance);
+    printf("  door open        %6.0f s  %5.1f s per motor start\n", door_open_ticks / (double)CONTROL_RATE_HZ,
+           (motor_starts > 0) ? door_open_ticks / (double)CONTROL_RATE_HZ / motor_starts : 0.0);
+    return 0;
+}
+
+
+int main(int argc, char** argv) {
+    if(argc < 2) {
+        fprintf(stderr, "Usage: %s scenario...\n", argv[0]);
+        return 1;
+    }
+
+    timer_set_clock(sim_now_ns);
+    printf("%s, %d floors\n", BUILDING_NAME, HARDWARE_NUMBER_OF_FLOORS);
+
+    for(int i = 1; i < argc; i++) {
+        traffic_scenario_t scenario;
+        if(traffic_load_scenario(argv[i], &scenario) != 0) {
+            return 1;
+        }
+        for(int variant = 0; variant < (int)(sizeof(bench_variants) / sizeof(bench_variants[0])); variant++) {
+            if(bench_run(&scenario, &bench_variants[variant]) != 0) {
+                fprintf(stderr, "Unable to initialize hardware\n");
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
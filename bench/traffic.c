@@ -0,0 +1,312 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "driver/sim.h"
+#include "traffic.h"
+#include "timer.h"
+
+
+static double samples_g[TRAFFIC_MAX_PASSENGERS];
+
+
+static int traffic_compare_double(const void* a, const void* b) {
+    double x = *(const double*)a;
+    double y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+
+int traffic_load_scenario(const char* path, traffic_scenario_t* p_scenario) {
+    FILE* file = fopen(path, "r");
+    if(file == NULL) {
+        perror(path);
+        return -1;
+    }
+
+    *p_scenario = (traffic_scenario_t){ .duration_s = 3600, .cars = 1, .policy = QUEUE_POLICY_LOOK };
+    snprintf(p_scenario->name, sizeof(p_scenario->name), "%s", path);
+
+    char line[256];
+    int line_number = 0;
+    int error = 0;
+    while(!error && fgets(line, sizeof(line), file) != NULL) {
+        line_number++;
+        char* comment = strchr(line, '#');
+        if(comment != NULL) {
+            *comment = '\0';
+        }
+
+        char key[32];
+        char text[64];
+        if(sscanf(line, "%31s", key) != 1) {
+            continue;
+        }
+
+        if(strcmp(key, "name") == 0) {
+            error = sscanf(line, "%*s %63s", p_scenario->name) != 1;
+        }
+        else if(strcmp(key, "duration") == 0) {
+            error = sscanf(line, "%*s %lld", &p_scenario->duration_s) != 1 || p_scenario->duration_s <= 0;
+        }
+        else if(strcmp(key, "cars") == 0) {
+            error = sscanf(line, "%*s %d", &p_scenario->cars) != 1 || p_scenario->cars < 1 || p_scenario->cars > HARDWARE_MAX_CARS;
+        }
+        else if(strcmp(key, "capacity") == 0) {
+            error = sscanf(line, "%*s %d", &p_scenario->capacity) != 1 || p_scenario->capacity < 0;
+        }
+        else if(strcmp(key, "policy") == 0) {
+            error = sscanf(line, "%*s %63s", text) != 1 || queue_policy_from_name(text, &p_scenario->policy) != 0;
+        }
+        else if(strcmp(key, "phase") == 0 && p_scenario->phase_count < TRAFFIC_MAX_PHASES) {
+            traffic_phase_t* p_phase = &p_scenario->phases[p_scenario->phase_count++];
+            error = sscanf(line, "%*s %lld %d %d %d %d", &p_phase->start_s, &p_phase->per_hour,
+                           &p_phase->incoming, &p_phase->outgoing, &p_phase->interfloor) != 5
+                 || p_phase->incoming + p_phase->outgoing + p_phase->interfloor <= 0
+                 || (p_scenario->phase_count > 1 && p_phase->start_s < p_phase[-1].start_s);
+        }
+        else {
+            error = 1;
+        }
+    }
+    fclose(file);
+
+    if(error) {
+        fprintf(stderr, "%s:%d: invalid line\n", path, line_number);
+        return -1;
+    }
+    return 0;
+}
+
+
+void traffic_init(traffic_t* p_traffic, unsigned int seed, int car_count, int capacity) {
+    p_traffic->count = 0;
+    p_traffic->active_count = 0;
+    memset(p_traffic->riding, 0, sizeof(p_traffic->riding));
+    memset(p_traffic->transfer_until_ns, 0, sizeof(p_traffic->transfer_until_ns));
+    p_traffic->car_count = car_count;
+    p_traffic->capacity = capacity;
+    p_traffic->seed = seed;
+}
+
+
+static HardwareOrder traffic_hall_order(const traffic_passenger_t* p_passenger) {
+    return (p_passenger->destination > p_passenger->origin) ? HARDWARE_ORDER_UP : HARDWARE_ORDER_DOWN;
+}
+
+
+void traffic_add_passenger(traffic_t* p_traffic, int origin, int destination) {
+    if(p_traffic->count >= TRAFFIC_MAX_PASSENGERS) {
+        return;
+    }
+
+    traffic_passenger_t* p_passenger = &p_traffic->passengers[p_traffic->count];
+    *p_passenger = (traffic_passenger_t){ .origin = origin,
+                                          .destination = destination,
+                                          .state = PASSENGER_WAITING,
+                                          .arrived_ns = timer_now_ns(),
+                                          .pressed_ns = timer_now_ns()
+                                        };
+    p_traffic->active[p_traffic->active_count++] = p_traffic->count++;
+    sim_press_order(origin, traffic_hall_order(p_passenger));
+}
+
+
+/**
+ * @brief A random floor other than @p except, which may be @c FLOOR_NOT_INIT
+ */
+static int traffic_random_floor(traffic_t* p_traffic, int except) {
+    if(except == FLOOR_NOT_INIT) {
+        return rand_r(&p_traffic->seed) % HARDWARE_NUMBER_OF_FLOORS;
+    }
+    return (except + 1 + rand_r(&p_traffic->seed) % (HARDWARE_NUMBER_OF_FLOORS - 1)) % HARDWARE_NUMBER_OF_FLOORS;
+}
+
+
+void traffic_generate(traffic_t* p_traffic, const traffic_scenario_t* p_scenario, long long tick_ns) {
+    long long now_s = timer_now_ns() / 1000000000LL;
+    const traffic_phase_t* p_phase = NULL;
+    for(int i = 0; i < p_scenario->phase_count && p_scenario->phases[i].start_s <= now_s; i++) {
+        p_phase = &p_scenario->phases[i];
+    }
+    if(p_phase == NULL) {
+        return;
+    }
+
+    double probability = p_phase->per_hour * (tick_ns / 3.6e12);
+    if(rand_r(&p_traffic->seed) / (RAND_MAX + 1.0) >= probability) {
+        return;
+    }
+
+    int total = p_phase->incoming + p_phase->outgoing + p_phase->interfloor;
+    int pick = rand_r(&p_traffic->seed) % total;
+    int origin;
+    int destination;
+    if(pick < p_phase->incoming) {
+        origin = TRAFFIC_LOBBY;
+        destination = traffic_random_floor(p_traffic, TRAFFIC_LOBBY);
+    }
+    else if(pick < p_phase->incoming + p_phase->outgoing) {
+        origin = traffic_random_floor(p_traffic, TRAFFIC_LOBBY);
+        destination = TRAFFIC_LOBBY;
+    }
+    else {
+        // Interfloor trips start and end above the lobby, where the building has enough floors
+        do {
+            origin = traffic_random_floor(p_traffic, FLOOR_NOT_INIT);
+            destination = traffic_random_floor(p_traffic, origin);
+        } while(HARDWARE_NUMBER_OF_FLOORS > 2 && (origin == TRAFFIC_LOBBY || destination == TRAFFIC_LOBBY));
+    }
+    traffic_add_passenger(p_traffic, origin, destination);
+}
+
+
+/**
+ * @brief The floor the selected car has its door open at, or @c FLOOR_NOT_INIT
+ */
+static int traffic_door_floor() {
+    if(!sim_get_door_open()) {
+        return FLOOR_NOT_INIT;
+    }
+    double position = sim_get_position();
+    int floor = (int)lround(position);
+    return (fabs(position - floor) <= 0.05) ? floor : FLOOR_NOT_INIT;
+}
+
+
+void traffic_step(traffic_t* p_traffic) {
+    long long now = timer_now_ns();
+    int door_floors[HARDWARE_MAX_CARS];
+    int door_free[HARDWARE_MAX_CARS];
+    int any_open = 0;
+    for(int car = 0; car < p_traffic->car_count; car++) {
+        hardware_select_car(car);
+        door_floors[car] = traffic_door_floor();
+        // Only one passenger passes a door at a time
+        door_free[car] = (now >= p_traffic->transfer_until_ns[car]);
+        any_open |= (door_floors[car] != FLOOR_NOT_INIT);
+    }
+    hardware_select_car(0);
+
+    for(int i = 0; i < p_traffic->active_count;) {
+        traffic_passenger_t* p_passenger = &p_traffic->passengers[p_traffic->active[i]];
+
+        if(p_passenger->state == PASSENGER_RIDING) {
+            if(door_floors[p_passenger->car] == p_passenger->destination && door_free[p_passenger->car]) {
+                p_passenger->state = PASSENGER_ARRIVED;
+                p_passenger->left_ns = now;
+                p_traffic->riding[p_passenger->car]--;
+                p_traffic->transfer_until_ns[p_passenger->car] = now + TRAFFIC_TRANSFER_NS;
+                door_free[p_passenger->car] = 0;
+                p_traffic->active[i] = p_traffic->active[--p_traffic->active_count];
+                continue;
+            }
+            i++;
+            continue;
+        }
+
+        // The light goes out when a car takes the call
+        HardwareOrder order_type = traffic_hall_order(p_passenger);
+        if(sim_get_order_light(p_passenger->origin, order_type)) {
+            i++;
+            continue;
+        }
+
+        int door_here = 0;
+        for(int car = 0; any_open && car < p_traffic->car_count; car++) {
+            if(door_floors[car] != p_passenger->origin) {
+                continue;
+            }
+            door_here = 1;
+            if(door_free[car] && (p_traffic->capacity == 0 || p_traffic->riding[car] < p_traffic->capacity)) {
+                p_passenger->state = PASSENGER_RIDING;
+                p_passenger->car = car;
+                p_passenger->boarded_ns = now;
+                p_traffic->riding[car]++;
+                p_traffic->transfer_until_ns[car] = now + TRAFFIC_TRANSFER_NS;
+                door_free[car] = 0;
+                hardware_select_car(car);
+                sim_press_order(p_passenger->destination, HARDWARE_ORDER_INSIDE);
+                hardware_select_car(0);
+                break;
+            }
+        }
+        if(!door_here && now - p_passenger->pressed_ns >= TRAFFIC_REPRESS_NS) {
+            sim_press_order(p_passenger->origin, order_type);
+            p_passenger->pressed_ns = now;
+        }
+        i++;
+    }
+
+    for(int car = 0; car < p_traffic->car_count; car++) {
+        hardware_select_car(car);
+        sim_set_obstruction(sim_get_door_open() && now < p_traffic->transfer_until_ns[car]);
+    }
+    hardware_select_car(0);
+}
+
+
+/**
+ * @brief The value at quantile @p q of @p count sorted samples
+ */
+static double traffic_quantile(double* samples, int count, double q) {
+    return (count > 0) ? samples[(int)(q * (count - 1))] : 0.0;
+}
+
+
+traffic_stats_t traffic_summarize(const traffic_t* p_traffic) {
+    traffic_stats_t stats = { 0 };
+
+    int count = 0;
+    double sum = 0.0;
+    for(int i = 0; i < p_traffic->count; i++) {
+        const traffic_passenger_t* p_passenger = &p_traffic->passengers[i];
+        if(p_passenger->state == PASSENGER_ARRIVED) {
+            samples_g[count] = (p_passenger->boarded_ns - p_passenger->arrived_ns) / 1e9;
+            sum += samples_g[count++];
+        }
+    }
+    stats.delivered = count;
+    if(count == 0) {
+        return stats;
+    }
+    qsort(samples_g, count, sizeof(double), traffic_compare_double);
+    stats.wait_mean_s = sum / count;
+    stats.wait_p95_s = traffic_quantile(samples_g, count, 0.95);
+    stats.wait_p99_s = traffic_quantile(samples_g, count, 0.99);
+
+    count = 0;
+    sum = 0.0;
+    for(int i = 0; i < p_traffic->count; i++) {
+        const traffic_passenger_t* p_passenger = &p_traffic->passengers[i];
+        if(p_passenger->state == PASSENGER_ARRIVED) {
+            samples_g[count] = (p_passenger->left_ns - p_passenger->arrived_ns) / 1e9;
+            sum += samples_g[count++];
+        }
+    }
+    qsort(samples_g, count, sizeof(double), traffic_compare_double);
+    stats.journey_mean_s = sum / count;
+    stats.journey_p95_s = traffic_quantile(samples_g, count, 0.95);
+    stats.journey_p99_s = traffic_quantile(samples_g, count, 0.99);
+
+    // Deliveries in the busiest window, sliding over the sorted delivery times
+    count = 0;
+    for(int i = 0; i < p_traffic->count; i++) {
+        if(p_traffic->passengers[i].state == PASSENGER_ARRIVED) {
+            samples_g[count++] = p_traffic->passengers[i].left_ns / 1e9;
+        }
+    }
+    qsort(samples_g, count, sizeof(double), traffic_compare_double);
+    for(int first = 0, last = 0; last < count; last++) {
+        while(samples_g[last] - samples_g[first] >= TRAFFIC_WINDOW_S) {
+            first++;
+        }
+        if(last - first + 1 > stats.handling_capacity) {
+            stats.handling_capacity = last - first + 1;
+        }
+    }
+    return stats;
+}
@@ -0,0 +1,188 @@
+/**
+ * @file
+ * @brief Passengers for the benchmarks, and the traffic scenarios they arrive in.
+ *
+ * A passenger arrives at a floor, presses the hall button for their direction and waits.
+ * They board a car that has its door open at their floor once the hall light for their
+ * direction has gone out, which is when the car takes their call, press the cab button for
+ * their destination and leave when the door opens there. Passengers pass the door of a car one
+ * at a time, each taking @c TRAFFIC_TRANSFER_NS , and hold its obstruction switch high while they
+ * do, as they would break the light curtain of a real door. A passenger who sees their hall
+ * light go out while no car is there, for instance because the car was full, presses it again
+ * after a while, so that the button is released in between and the press is seen as a new call.
+ *
+ * The passengers move between the simulated cars, so every car must have been selected with
+ * @c hardware_select_car() before @c traffic_step() is called. Hall buttons are pressed on
+ * car 0, which carries the hall buttons of a bank.
+ */
+#ifndef TRAFFIC_H
+#define TRAFFIC_H
+
+#include "driver/hardware.h"
+#include "queue.h"
+
+
+#define TRAFFIC_MAX_PASSENGERS 100000   /**< Most passengers a run can generate */
+#define TRAFFIC_MAX_PHASES 32           /**< Most phases a scenario can have */
+#define TRAFFIC_LOBBY MIN_FLOOR         /**< The floor incoming passengers arrive at and outgoing passengers leave from */
+#define TRAFFIC_WINDOW_S 300            /**< Window of the handling capacity, which is conventionally five minutes */
+#define TRAFFIC_REPRESS_NS 1000000000LL /**< How long a passenger waits before pressing an unlit hall button again */
+#define TRAFFIC_TRANSFER_NS 1000000000LL /**< How long a passenger takes to pass the door when boarding or leaving */
+
+
+/**
+ * A part of a scenario with a constant arrival rate and traffic mix
+ */
+typedef struct{
+    long long start_s;          /**< When the phase starts, in seconds from the start of the run*/
+    int per_hour;               /**< Passengers arriving per hour*/
+    int incoming;               /**< Share of passengers going from the lobby to another floor, in percent*/
+    int outgoing;               /**< Share of passengers going from another floor to the lobby, in percent*/
+    int interfloor;             /**< Share of passengers going between two random floors, in percent*/
+} traffic_phase_t;
+
+
+/**
+ * A traffic scenario, as read from a scenario file
+ */
+typedef struct{
+    char name[64];                                  /**< Name of the scenario*/
+    long long duration_s;                           /**< Length of the run, in simulated seconds*/
+    int cars;                                       /**< Number of cars*/
+    int capacity;                                   /**< Passengers a car holds, or 0 for no limit*/
+    queue_policy_t policy;                          /**< Dispatch policy of every car*/
+    traffic_phase_t phases[TRAFFIC_MAX_PHASES];     /**< The phases, by start time*/
+    int phase_count;                                /**< Number of phases*/
+} traffic_scenario_t;
+
+
+/**
+ * Enum for where a passenger is
+ */
+typedef enum{
+    PASSENGER_WAITING,          /**< At the origin floor*/
+    PASSENGER_RIDING,           /**< In a car*/
+    PASSENGER_ARRIVED           /**< Left the car at the destination floor*/
+} traffic_passenger_state_t;
+
+
+/**
+ * A passenger
+ */
+typedef struct{
+    int origin;                         /**< Floor the passenger arrives at*/
+    int destination;                    /**< Floor the passenger travels to*/
+    int car;                            /**< The car the passenger rides in, once boarded*/
+    traffic_passenger_state_t state;    /**< Where the passenger is*/
+    long long arrived_ns;               /**< When the passenger arrived at the origin*/
+    long long pressed_ns;               /**< When the passenger last pressed the hall button*/
+    long long boarded_ns;               /**< When the passenger boarded*/
+    long long left_ns;                  /**< When the passenger left at the destination*/
+} traffic_passenger_t;
+
+
+/**
+ * A struct holding the passengers of a run
+ */
+typedef struct{
+    traffic_passenger_t passengers[TRAFFIC_MAX_PASSENGERS]; /**< Every passenger, in order of arrival*/
+    int count;                                              /**< Number of passengers*/
+    int active[TRAFFIC_MAX_PASSENGERS];                     /**< Passengers that have not arrived, in no particular order*/
+    int active_count;                                       /**< Number of passengers that have not arrived*/
+    int riding[HARDWARE_MAX_CARS];                          /**< Passengers in every car*/
+    long long transfer_until_ns[HARDWARE_MAX_CARS];         /**< When the passenger passing the door of every car is through*/
+    int car_count;                                          /**< Number of cars*/
+    int capacity;                                           /**< Passengers a car holds, or 0 for no limit*/
+    unsigned int seed;                                      /**< State of the arrival generator*/
+} traffic_t;
+
+
+/**
+ * A struct holding the results of a run
+ */
+typedef struct{
+    int delivered;              /**< Passengers that arrived at their destination*/
+    double wait_mean_s;         /**< Mean time from arrival to boarding*/
+    double wait_p95_s;          /**< 95th percentile of the wait time*/
+    double wait_p99_s;          /**< 99th percentile of the wait time*/
+    double journey_mean_s;      /**< Mean time from arrival to leaving the car*/
+    double journey_p95_s;       /**< 95th percentile of the journey time*/
+    double journey_p99_s;       /**< 99th percentile of the journey time*/
+    int handling_capacity;      /**< Most passengers delivered in any @c TRAFFIC_WINDOW_S*/
+} traffic_stats_t;
+
+
+/**
+ * @brief Read a scenario file
+ *
+ * @param[in] path          Path of the scenario file
+ * @param[out] p_scenario   The scenario
+ *
+ * @return 0 on success, and -1 if the file could not be read or has an error, which is reported on stderr
+ *
+ * A scenario file has one key and its values per line, and @c # starts a comment:
+ * @code
+ * name up-peak
+ * duration 3600        # simulated seconds
+ * cars 4
+ * capacity 12          # passengers per car, 0 for no limit
+ * policy look          # fifo, look or nearest
+ * phase 0 600 85 5 10  # start s, passengers/h, incoming %, outgoing %, interfloor %
+ * @endcode
+ * Every phase lasts until the next one starts.
+ */
+int traffic_load_scenario(const char* path, traffic_scenario_t* p_scenario);
+
+
+/**
+ * @brief Start a run without passengers
+ *
+ * @param[out] p_traffic    The passengers of the run
+ * @param[in] seed          Seed of the arrival generator
+ * @param[in] car_count     Number of cars
+ * @param[in] capacity      Passengers a car holds, or 0 for no limit
+ */
+void traffic_init(traffic_t* p_traffic, unsigned int seed, int car_count, int capacity);
+
+
+/**
+ * @brief Let a passenger arrive and press their hall button
+ *
+ * @param[in, out] p_traffic    The passengers of the run
+ * @param[in] origin            Floor the passenger arrives at
+ * @param[in] destination       Floor the passenger travels to, not @p origin
+ */
+void traffic_add_passenger(traffic_t* p_traffic, int origin, int destination);
+
+
+/**
+ * @brief Let the passengers of @p p_scenario arrive for one tick of @p tick_ns
+ *
+ * @param[in, out] p_traffic    The passengers of the run
+ * @param[in] p_scenario        The scenario
+ * @param[in] tick_ns           Length of the tick
+ */
+void traffic_generate(traffic_t* p_traffic, const traffic_scenario_t* p_scenario, long long tick_ns);
+
+
+/**
+ * @brief Board and alight passengers at every car that has its door open, and set the obstruction switch of every car
+ *
+ * @param[in, out] p_traffic    The passengers of the run
+ *
+ * Leaves car 0 selected.
+ */
+void traffic_step(traffic_t* p_traffic);
+
+
+/**
+ * @brief Summarize the passengers that have arrived
+ *
+ * @param[in] p_traffic     The passengers of the run
+ *
+ * @return The results of the run
+ */
+traffic_stats_t traffic_summarize(const traffic_t* p_traffic);
+
+
+#endif //TRAFFIC_H
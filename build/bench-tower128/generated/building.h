@@ -0,0 +1,283 @@
+/* Generated by tools/gen_building.py from buildings/tower128.building. Do not edit. */
+#ifndef BUILDING_H
+#define BUILDING_H
+
+#define BUILDING_NAME "tower128"
+#define HARDWARE_NUMBER_OF_FLOORS 128
+
+/* 1 if the channels only exist in the simulated driver */
+#define BUILDING_SIMULATED_ONLY 1
+
+/* Number of digital subdevices the channels below are spread over */
+#define BUILDING_SUBDEVICES 8
+
+/* Channel tables, indexed by floor. Order columns are {up, down, cab} */
+#define BUILDING_SENSOR_CHANNELS { (0x400+0), (0x400+1), (0x400+2), (0x400+3), (0x400+4), (0x400+5), (0x400+6), (0x400+7), (0x400+8), (0x400+9), (0x400+10), (0x400+11), (0x400+12), (0x400+13), (0x400+14), (0x400+15), (0x400+16), (0x400+17), (0x400+18), (0x400+19), (0x400+20), (0x400+21), (0x400+22), (0x400+23), (0x400+24), (0x400+25), (0x400+26), (0x400+27), (0x400+28), (0x400+29), (0x400+30), (0x400+31), (0x400+32), (0x400+33), (0x400+34), (0x400+35), (0x400+36), (0x400+37), (0x400+38), (0x400+39), (0x400+40), (0x400+41), (0x400+42), (0x400+43), (0x400+44), (0x400+45), (0x400+46), (0x400+47), (0x400+48), (0x400+49), (0x400+50), (0x400+51), (0x400+52), (0x400+53), (0x400+54), (0x400+55), (0x400+56), (0x400+57), (0x400+58), (0x400+59), (0x400+60), (0x400+61), (0x400+62), (0x400+63), (0x400+64), (0x400+65), (0x400+66), (0x400+67), (0x400+68), (0x400+69), (0x400+70), (0x400+71), (0x400+72), (0x400+73), (0x400+74), (0x400+75), (0x400+76), (0x400+77), (0x400+78), (0x400+79), (0x400+80), (0x400+81), (0x400+82), (0x400+83), (0x400+84), (0x400+85), (0x400+86), (0x400+87), (0x400+88), (0x400+89), (0x400+90), (0x400+91), (0x400+92), (0x400+93), (0x400+94), (0x400+95), (0x400+96), (0x400+97), (0x400+98), (0x400+99), (0x400+100), (0x400+101), (0x400+102), (0x400+103), (0x400+104), (0x400+105), (0x400+106), (0x400+107), (0x400+108), (0x400+109), (0x400+110), (0x400+111), (0x400+112), (0x400+113), (0x400+114), (0x400+115), (0x400+116), (0x400+117), (0x400+118), (0x400+119), (0x400+120), (0x400+121), (0x400+122), (0x400+123), (0x400+124), (0x400+125), (0x400+126), (0x400+127) }
+
+#define BUILDING_ORDER_CHANNELS { \
+    {(0x400+128), -1, (0x500+126)}, \
+    {(0x400+129), (0x400+255), (0x500+127)}, \
+    {(0x400+130), (0x500+0), (0x500+128)}, \
+    {(0x400+131), (0x500+1), (0x500+129)}, \
+    {(0x400+132), (0x500+2), (0x500+130)}, \
+    {(0x400+133), (0x500+3), (0x500+131)}, \
+    {(0x400+134), (0x500+4), (0x500+132)}, \
+    {(0x400+135), (0x500+5), (0x500+133)}, \
+    {(0x400+136), (0x500+6), (0x500+134)}, \
+    {(0x400+137), (0x500+7), (0x500+135)}, \
+    {(0x400+138), (0x500+8), (0x500+136)}, \
+    {(0x400+139), (0x500+9), (0x500+137)}, \
+    {(0x400+140), (0x500+10), (0x500+138)}, \
+    {(0x400+141), (0x500+11), (0x500+139)}, \
+    {(0x400+142), (0x500+12), (0x500+140)}, \
+    {(0x400+143), (0x500+13), (0x500+141)}, \
+    {(0x400+144), (0x500+14), (0x500+142)}, \
+    {(0x400+145), (0x500+15), (0x500+143)}, \
+    {(0x400+146), (0x500+16), (0x500+144)}, \
+    {(0x400+147), (0x500+17), (0x500+145)}, \
+    {(0x400+148), (0x500+18), (0x500+146)}, \
+    {(0x400+149), (0x500+19), (0x500+147)}, \
+    {(0x400+150), (0x500+20), (0x500+148)}, \
+    {(0x400+151), (0x500+21), (0x500+149)}, \
+    {(0x400+152), (0x500+22), (0x500+150)}, \
+    {(0x400+153), (0x500+23), (0x500+151)}, \
+    {(0x400+154), (0x500+24), (0x500+152)}, \
+    {(0x400+155), (0x500+25), (0x500+153)}, \
+    {(0x400+156), (0x500+26), (0x500+154)}, \
+    {(0x400+157), (0x500+27), (0x500+155)}, \
+    {(0x400+158), (0x500+28), (0x500+156)}, \
+    {(0x400+159), (0x500+29), (0x500+157)}, \
+    {(0x400+160), (0x500+30), (0x500+158)}, \
+    {(0x400+161), (0x500+31), (0x500+159)}, \
+    {(0x400+162), (0x500+32), (0x500+160)}, \
+    {(0x400+163), (0x500+33), (0x500+161)}, \
+    {(0x400+164), (0x500+34), (0x500+162)}, \
+    {(0x400+165), (0x500+35), (0x500+163)}, \
+    {(0x400+166), (0x500+36), (0x500+164)}, \
+    {(0x400+167), (0x500+37), (0x500+165)}, \
+    {(0x400+168), (0x500+38), (0x500+166)}, \
+    {(0x400+169), (0x500+39), (0x500+167)}, \
+    {(0x400+170), (0x500+40), (0x500+168)}, \
+    {(0x400+171), (0x500+41), (0x500+169)}, \
+    {(0x400+172), (0x500+42), (0x500+170)}, \
+    {(0x400+173), (0x500+43), (0x500+171)}, \
+    {(0x400+174), (0x500+44), (0x500+172)}, \
+    {(0x400+175), (0x500+45), (0x500+173)}, \
+    {(0x400+176), (0x500+46), (0x500+174)}, \
+    {(0x400+177), (0x500+47), (0x500+175)}, \
+    {(0x400+178), (0x500+48), (0x500+176)}, \
+    {(0x400+179), (0x500+49), (0x500+177)}, \
+    {(0x400+180), (0x500+50), (0x500+178)}, \
+    {(0x400+181), (0x500+51), (0x500+179)}, \
+    {(0x400+182), (0x500+52), (0x500+180)}, \
+    {(0x400+183), (0x500+53), (0x500+181)}, \
+    {(0x400+184), (0x500+54), (0x500+182)}, \
+    {(0x400+185), (0x500+55), (0x500+183)}, \
+    {(0x400+186), (0x500+56), (0x500+184)}, \
+    {(0x400+187), (0x500+57), (0x500+185)}, \
+    {(0x400+188), (0x500+58), (0x500+186)}, \
+    {(0x400+189), (0x500+59), (0x500+187)}, \
+    {(0x400+190), (0x500+60), (0x500+188)}, \
+    {(0x400+191), (0x500+61), (0x500+189)}, \
+    {(0x400+192), (0x500+62), (0x500+190)}, \
+    {(0x400+193), (0x500+63), (0x500+191)}, \
+    {(0x400+194), (0x500+64), (0x500+192)}, \
+    {(0x400+195), (0x500+65), (0x500+193)}, \
+    {(0x400+196), (0x500+66), (0x500+194)}, \
+    {(0x400+197), (0x500+67), (0x500+195)}, \
+    {(0x400+198), (0x500+68), (0x500+196)}, \
+    {(0x400+199), (0x500+69), (0x500+197)}, \
+    {(0x400+200), (0x500+70), (0x500+198)}, \
+    {(0x400+201), (0x500+71), (0x500+199)}, \
+    {(0x400+202), (0x500+72), (0x500+200)}, \
+    {(0x400+203), (0x500+73), (0x500+201)}, \
+    {(0x400+204), (0x500+74), (0x500+202)}, \
+    {(0x400+205), (0x500+75), (0x500+203)}, \
+    {(0x400+206), (0x500+76), (0x500+204)}, \
+    {(0x400+207), (0x500+77), (0x500+205)}, \
+    {(0x400+208), (0x500+78), (0x500+206)}, \
+    {(0x400+209), (0x500+79), (0x500+207)}, \
+    {(0x400+210), (0x500+80), (0x500+208)}, \
+    {(0x400+211), (0x500+81), (0x500+209)}, \
+    {(0x400+212), (0x500+82), (0x500+210)}, \
+    {(0x400+213), (0x500+83), (0x500+211)}, \
+    {(0x400+214), (0x500+84), (0x500+212)}, \
+    {(0x400+215), (0x500+85), (0x500+213)}, \
+    {(0x400+216), (0x500+86), (0x500+214)}, \
+    {(0x400+217), (0x500+87), (0x500+215)}, \
+    {(0x400+218), (0x500+88), (0x500+216)}, \
+    {(0x400+219), (0x500+89), (0x500+217)}, \
+    {(0x400+220), (0x500+90), (0x500+218)}, \
+    {(0x400+221), (0x500+91), (0x500+219)}, \
+    {(0x400+222), (0x500+92), (0x500+220)}, \
+    {(0x400+223), (0x500+93), (0x500+221)}, \
+    {(0x400+224), (0x500+94), (0x500+222)}, \
+    {(0x400+225), (0x500+95), (0x500+223)}, \
+    {(0x400+226), (0x500+96), (0x500+224)}, \
+    {(0x400+227), (0x500+97), (0x500+225)}, \
+    {(0x400+228), (0x500+98), (0x500+226)}, \
+    {(0x400+229), (0x500+99), (0x500+227)}, \
+    {(0x400+230), (0x500+100), (0x500+228)}, \
+    {(0x400+231), (0x500+101), (0x500+229)}, \
+    {(0x400+232), (0x500+102), (0x500+230)}, \
+    {(0x400+233), (0x500+103), (0x500+231)}, \
+    {(0x400+234), (0x500+104), (0x500+232)}, \
+    {(0x400+235), (0x500+105), (0x500+233)}, \
+    {(0x400+236), (0x500+106), (0x500+234)}, \
+    {(0x400+237), (0x500+107), (0x500+235)}, \
+    {(0x400+238), (0x500+108), (0x500+236)}, \
+    {(0x400+239), (0x500+109), (0x500+237)}, \
+    {(0x400+240), (0x500+110), (0x500+238)}, \
+    {(0x400+241), (0x500+111), (0x500+239)}, \
+    {(0x400+242), (0x500+112), (0x500+240)}, \
+    {(0x400+243), (0x500+113), (0x500+241)}, \
+    {(0x400+244), (0x500+114), (0x500+242)}, \
+    {(0x400+245), (0x500+115), (0x500+243)}, \
+    {(0x400+246), (0x500+116), (0x500+244)}, \
+    {(0x400+247), (0x500+117), (0x500+245)}, \
+    {(0x400+248), (0x500+118), (0x500+246)}, \
+    {(0x400+249), (0x500+119), (0x500+247)}, \
+    {(0x400+250), (0x500+120), (0x500+248)}, \
+    {(0x400+251), (0x500+121), (0x500+249)}, \
+    {(0x400+252), (0x500+122), (0x500+250)}, \
+    {(0x400+253), (0x500+123), (0x500+251)}, \
+    {(0x400+254), (0x500+124), (0x500+252)}, \
+    {-1, (0x500+125), (0x500+253)} \
+}
+
+#define BUILDING_LIGHT_CHANNELS { \
+    {(0x600+0), -1, (0x600+254)}, \
+    {(0x600+1), (0x600+127), (0x600+255)}, \
+    {(0x600+2), (0x600+128), (0x700+0)}, \
+    {(0x600+3), (0x600+129), (0x700+1)}, \
+    {(0x600+4), (0x600+130), (0x700+2)}, \
+    {(0x600+5), (0x600+131), (0x700+3)}, \
+    {(0x600+6), (0x600+132), (0x700+4)}, \
+    {(0x600+7), (0x600+133), (0x700+5)}, \
+    {(0x600+8), (0x600+134), (0x700+6)}, \
+    {(0x600+9), (0x600+135), (0x700+7)}, \
+    {(0x600+10), (0x600+136), (0x700+8)}, \
+    {(0x600+11), (0x600+137), (0x700+9)}, \
+    {(0x600+12), (0x600+138), (0x700+10)}, \
+    {(0x600+13), (0x600+139), (0x700+11)}, \
+    {(0x600+14), (0x600+140), (0x700+12)}, \
+    {(0x600+15), (0x600+141), (0x700+13)}, \
+    {(0x600+16), (0x600+142), (0x700+14)}, \
+    {(0x600+17), (0x600+143), (0x700+15)}, \
+    {(0x600+18), (0x600+144), (0x700+16)}, \
+    {(0x600+19), (0x600+145), (0x700+17)}, \
+    {(0x600+20), (0x600+146), (0x700+18)}, \
+    {(0x600+21), (0x600+147), (0x700+19)}, \
+    {(0x600+22), (0x600+148), (0x700+20)}, \
+    {(0x600+23), (0x600+149), (0x700+21)}, \
+    {(0x600+24), (0x600+150), (0x700+22)}, \
+    {(0x600+25), (0x600+151), (0x700+23)}, \
+    {(0x600+26), (0x600+152), (0x700+24)}, \
+    {(0x600+27), (0x600+153), (0x700+25)}, \
+    {(0x600+28), (0x600+154), (0x700+26)}, \
+    {(0x600+29), (0x600+155), (0x700+27)}, \
+    {(0x600+30), (0x600+156), (0x700+28)}, \
+    {(0x600+31), (0x600+157), (0x700+29)}, \
+    {(0x600+32), (0x600+158), (0x700+30)}, \
+    {(0x600+33), (0x600+159), (0x700+31)}, \
+    {(0x600+34), (0x600+160), (0x700+32)}, \
+    {(0x600+35), (0x600+161), (0x700+33)}, \
+    {(0x600+36), (0x600+162), (0x700+34)}, \
+    {(0x600+37), (0x600+163), (0x700+35)}, \
+    {(0x600+38), (0x600+164), (0x700+36)}, \
+    {(0x600+39), (0x600+165), (0x700+37)}, \
+    {(0x600+40), (0x600+166), (0x700+38)}, \
+    {(0x600+41), (0x600+167), (0x700+39)}, \
+    {(0x600+42), (0x600+168), (0x700+40)}, \
+    {(0x600+43), (0x600+169), (0x700+41)}, \
+    {(0x600+44), (0x600+170), (0x700+42)}, \
+    {(0x600+45), (0x600+171), (0x700+43)}, \
+    {(0x600+46), (0x600+172), (0x700+44)}, \
+    {(0x600+47), (0x600+173), (0x700+45)}, \
+    {(0x600+48), (0x600+174), (0x700+46)}, \
+    {(0x600+49), (0x600+175), (0x700+47)}, \
+    {(0x600+50), (0x600+176), (0x700+48)}, \
+    {(0x600+51), (0x600+177), (0x700+49)}, \
+    {(0x600+52), (0x600+178), (0x700+50)}, \
+    {(0x600+53), (0x600+179), (0x700+51)}, \
+    {(0x600+54), (0x600+180), (0x700+52)}, \
+    {(0x600+55), (0x600+181), (0x700+53)}, \
+    {(0x600+56), (0x600+182), (0x700+54)}, \
+    {(0x600+57), (0x600+183), (0x700+55)}, \
+    {(0x600+58), (0x600+184), (0x700+56)}, \
+    {(0x600+59), (0x600+185), (0x700+57)}, \
+    {(0x600+60), (0x600+186), (0x700+58)}, \
+    {(0x600+61), (0x600+187), (0x700+59)}, \
+    {(0x600+62), (0x600+188), (0x700+60)}, \
+    {(0x600+63), (0x600+189), (0x700+61)}, \
+    {(0x600+64), (0x600+190), (0x700+62)}, \
+    {(0x600+65), (0x600+191), (0x700+63)}, \
+    {(0x600+66), (0x600+192), (0x700+64)}, \
+    {(0x600+67), (0x600+193), (0x700+65)}, \
+    {(0x600+68), (0x600+194), (0x700+66)}, \
+    {(0x600+69), (0x600+195), (0x700+67)}, \
+    {(0x600+70), (0x600+196), (0x700+68)}, \
+    {(0x600+71), (0x600+197), (0x700+69)}, \
+    {(0x600+72), (0x600+198), (0x700+70)}, \
+    {(0x600+73), (0x600+199), (0x700+71)}, \
+    {(0x600+74), (0x600+200), (0x700+72)}, \
+    {(0x600+75), (0x600+201), (0x700+73)}, \
+    {(0x600+76), (0x600+202), (0x700+74)}, \
+    {(0x600+77), (0x600+203), (0x700+75)}, \
+    {(0x600+78), (0x600+204), (0x700+76)}, \
+    {(0x600+79), (0x600+205), (0x700+77)}, \
+    {(0x600+80), (0x600+206), (0x700+78)}, \
+    {(0x600+81), (0x600+207), (0x700+79)}, \
+    {(0x600+82), (0x600+208), (0x700+80)}, \
+    {(0x600+83), (0x600+209), (0x700+81)}, \
+    {(0x600+84), (0x600+210), (0x700+82)}, \
+    {(0x600+85), (0x600+211), (0x700+83)}, \
+    {(0x600+86), (0x600+212), (0x700+84)}, \
+    {(0x600+87), (0x600+213), (0x700+85)}, \
+    {(0x600+88), (0x600+214), (0x700+86)}, \
+    {(0x600+89), (0x600+215), (0x700+87)}, \
+    {(0x600+90), (0x600+216), (0x700+88)}, \
+    {(0x600+91), (0x600+217), (0x700+89)}, \
+    {(0x600+92), (0x600+218), (0x700+90)}, \
+    {(0x600+93), (0x600+219), (0x700+91)}, \
+    {(0x600+94), (0x600+220), (0x700+92)}, \
+    {(0x600+95), (0x600+221), (0x700+93)}, \
+    {(0x600+96), (0x600+222), (0x700+94)}, \
+    {(0x600+97), (0x600+223), (0x700+95)}, \
+    {(0x600+98), (0x600+224), (0x700+96)}, \
+    {(0x600+99), (0x600+225), (0x700+97)}, \
+    {(0x600+100), (0x600+226), (0x700+98)}, \
+    {(0x600+101), (0x600+227), (0x700+99)}, \
+    {(0x600+102), (0x600+228), (0x700+100)}, \
+    {(0x600+103), (0x600+229), (0x700+101)}, \
+    {(0x600+104), (0x600+230), (0x700+102)}, \
+    {(0x600+105), (0x600+231), (0x700+103)}, \
+    {(0x600+106), (0x600+232), (0x700+104)}, \
+    {(0x600+107), (0x600+233), (0x700+105)}, \
+    {(0x600+108), (0x600+234), (0x700+106)}, \
+    {(0x600+109), (0x600+235), (0x700+107)}, \
+    {(0x600+110), (0x600+236), (0x700+108)}, \
+    {(0x600+111), (0x600+237), (0x700+109)}, \
+    {(0x600+112), (0x600+238), (0x700+110)}, \
+    {(0x600+113), (0x600+239), (0x700+111)}, \
+    {(0x600+114), (0x600+240), (0x700+112)}, \
+    {(0x600+115), (0x600+241), (0x700+113)}, \
+    {(0x600+116), (0x600+242), (0x700+114)}, \
+    {(0x600+117), (0x600+243), (0x700+115)}, \
+    {(0x600+118), (0x600+244), (0x700+116)}, \
+    {(0x600+119), (0x600+245), (0x700+117)}, \
+    {(0x600+120), (0x600+246), (0x700+118)}, \
+    {(0x600+121), (0x600+247), (0x700+119)}, \
+    {(0x600+122), (0x600+248), (0x700+120)}, \
+    {(0x600+123), (0x600+249), (0x700+121)}, \
+    {(0x600+124), (0x600+250), (0x700+122)}, \
+    {(0x600+125), (0x600+251), (0x700+123)}, \
+    {(0x600+126), (0x600+252), (0x700+124)}, \
+    {-1, (0x600+253), (0x700+125)} \
+}
+
+/* Binary floor indicator, most significant bit first */
+#define BUILDING_FLOOR_INDICATOR_BITS 7
+#define BUILDING_FLOOR_INDICATOR_CHANNELS { (0x700+126), (0x700+127), (0x700+128), (0x700+129), (0x700+130), (0x700+131), (0x700+132) }
+
+#endif //BUILDING_H
@@ -0,0 +1,52 @@
+/* Generated by tools/gen_fsm.py from UML_ELEVATOR_FINAL.drawio. Do not edit. */
+#ifndef ELEVATOR_FSM_TABLE_H
+#define ELEVATOR_FSM_TABLE_H
+
+/* Transitions grouped by state and event, most guards first: {required, forbidden, next state, action} */
+#define ELEVATOR_FSM_TRANSITIONS { \
+    /* STATE_IDLE */ \
+    {0, 0, STATE_IDLE, ACTION_DO_NOTHING}, \
+    {GUARD_TARGET_FLOOR_ABOVE, 0, STATE_MOVING_UP, ACTION_MOVE_UP}, \
+    {GUARD_TARGET_FLOOR_BELOW, 0, STATE_MOVING_DOWN, ACTION_MOVE_DOWN}, \
+    {GUARD_TARGET_FLOOR_EQUAL, 0, STATE_DOOR_OPEN, ACTION_START_DOOR_TIMER}, \
+    {GUARD_DIRECTION, 0, STATE_DOOR_OPEN, ACTION_START_DOOR_TIMER}, \
+    {0, 0, STATE_EMERGENCY, ACTION_EMERGENCY}, \
+    {0, 0, STATE_IDLE, ACTION_DO_NOTHING}, \
+    /* STATE_DOOR_OPEN */ \
+    {0, 0, STATE_IDLE, ACTION_CLOSE_DOOR}, \
+    {GUARD_TARGET_FLOOR_BELOW | GUARD_TIMER_DONE, 0, STATE_MOVING_DOWN, ACTION_MOVE_DOWN}, \
+    {GUARD_TARGET_FLOOR_ABOVE | GUARD_TIMER_DONE, 0, STATE_MOVING_UP, ACTION_MOVE_UP}, \
+    {GUARD_TIMER_DONE, 0, STATE_IDLE, ACTION_CLOSE_DOOR}, \
+    {0, 0, STATE_DOOR_OPEN, ACTION_START_DOOR_TIMER}, \
+    {0, 0, STATE_EMERGENCY, ACTION_EMERGENCY}, \
+    {GUARD_TIMER_DONE, 0, STATE_IDLE, ACTION_CLOSE_DOOR}, \
+    {0, GUARD_TIMER_DONE, STATE_DOOR_OPEN, ACTION_DO_NOTHING}, \
+    /* STATE_MOVING_UP */ \
+    {GUARD_DIRECTION, 0, STATE_DOOR_OPEN, ACTION_START_DOOR_TIMER}, \
+    {0, 0, STATE_EMERGENCY, ACTION_EMERGENCY}, \
+    {0, 0, STATE_MOVING_UP, ACTION_DO_NOTHING}, \
+    /* STATE_MOVING_DOWN */ \
+    {GUARD_DIRECTION, 0, STATE_DOOR_OPEN, ACTION_START_DOOR_TIMER}, \
+    {0, 0, STATE_EMERGENCY, ACTION_EMERGENCY}, \
+    {0, 0, STATE_MOVING_DOWN, ACTION_DO_NOTHING}, \
+    /* STATE_EMERGENCY */ \
+    {0, 0, STATE_EMERGENCY, ACTION_EMERGENCY}, \
+    {GUARD_TIMER_DONE | GUARD_AT_FLOOR, 0, STATE_DOOR_OPEN, ACTION_DO_NOTHING}, \
+    {GUARD_TIMER_DONE, GUARD_AT_FLOOR, STATE_IDLE, ACTION_DO_NOTHING}, \
+    /* STATE_HOMING */ \
+    {0, 0, STATE_EMERGENCY, ACTION_EMERGENCY}, \
+    {0, GUARD_AT_FLOOR, STATE_HOMING, ACTION_DO_NOTHING}, \
+    {GUARD_AT_FLOOR, 0, STATE_IDLE, ACTION_STOP_MOVEMENT}, \
+}
+
+/* {first transition, number of transitions} for every [state][event] */
+#define ELEVATOR_FSM_INDEX { \
+    { {0, 1}, {1, 3}, {4, 0}, {4, 1}, {5, 0}, {5, 1}, {6, 0}, {6, 1} }, \
+    { {7, 1}, {8, 0}, {8, 3}, {11, 0}, {11, 1}, {12, 1}, {13, 0}, {13, 2} }, \
+    { {15, 0}, {15, 0}, {15, 0}, {15, 1}, {16, 0}, {16, 1}, {17, 0}, {17, 1} }, \
+    { {18, 0}, {18, 0}, {18, 0}, {18, 1}, {19, 0}, {19, 1}, {20, 0}, {20, 1} }, \
+    { {21, 0}, {21, 0}, {21, 0}, {21, 0}, {21, 0}, {21, 1}, {22, 2}, {24, 0} }, \
+    { {24, 0}, {24, 0}, {24, 0}, {24, 0}, {24, 0}, {24, 1}, {25, 0}, {25, 2} } \
+}
+
+#endif //ELEVATOR_FSM_TABLE_H
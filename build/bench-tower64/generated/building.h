@@ -0,0 +1,155 @@
+/* Generated by tools/gen_building.py from buildings/tower64.building. Do not edit. */
+#ifndef BUILDING_H
+#define BUILDING_H
+
+#define BUILDING_NAME "tower64"
+#define HARDWARE_NUMBER_OF_FLOORS 64
+
+/* 1 if the channels only exist in the simulated driver */
+#define BUILDING_SIMULATED_ONLY 1
+
+/* Number of digital subdevices the channels below are spread over */
+#define BUILDING_SUBDEVICES 6
+
+/* Channel tables, indexed by floor. Order columns are {up, down, cab} */
+#define BUILDING_SENSOR_CHANNELS { (0x400+0), (0x400+1), (0x400+2), (0x400+3), (0x400+4), (0x400+5), (0x400+6), (0x400+7), (0x400+8), (0x400+9), (0x400+10), (0x400+11), (0x400+12), (0x400+13), (0x400+14), (0x400+15), (0x400+16), (0x400+17), (0x400+18), (0x400+19), (0x400+20), (0x400+21), (0x400+22), (0x400+23), (0x400+24), (0x400+25), (0x400+26), (0x400+27), (0x400+28), (0x400+29), (0x400+30), (0x400+31), (0x400+32), (0x400+33), (0x400+34), (0x400+35), (0x400+36), (0x400+37), (0x400+38), (0x400+39), (0x400+40), (0x400+41), (0x400+42), (0x400+43), (0x400+44), (0x400+45), (0x400+46), (0x400+47), (0x400+48), (0x400+49), (0x400+50), (0x400+51), (0x400+52), (0x400+53), (0x400+54), (0x400+55), (0x400+56), (0x400+57), (0x400+58), (0x400+59), (0x400+60), (0x400+61), (0x400+62), (0x400+63) }
+
+#define BUILDING_ORDER_CHANNELS { \
+    {(0x400+64), -1, (0x400+190)}, \
+    {(0x400+65), (0x400+127), (0x400+191)}, \
+    {(0x400+66), (0x400+128), (0x400+192)}, \
+    {(0x400+67), (0x400+129), (0x400+193)}, \
+    {(0x400+68), (0x400+130), (0x400+194)}, \
+    {(0x400+69), (0x400+131), (0x400+195)}, \
+    {(0x400+70), (0x400+132), (0x400+196)}, \
+    {(0x400+71), (0x400+133), (0x400+197)}, \
+    {(0x400+72), (0x400+134), (0x400+198)}, \
+    {(0x400+73), (0x400+135), (0x400+199)}, \
+    {(0x400+74), (0x400+136), (0x400+200)}, \
+    {(0x400+75), (0x400+137), (0x400+201)}, \
+    {(0x400+76), (0x400+138), (0x400+202)}, \
+    {(0x400+77), (0x400+139), (0x400+203)}, \
+    {(0x400+78), (0x400+140), (0x400+204)}, \
+    {(0x400+79), (0x400+141), (0x400+205)}, \
+    {(0x400+80), (0x400+142), (0x400+206)}, \
+    {(0x400+81), (0x400+143), (0x400+207)}, \
+    {(0x400+82), (0x400+144), (0x400+208)}, \
+    {(0x400+83), (0x400+145), (0x400+209)}, \
+    {(0x400+84), (0x400+146), (0x400+210)}, \
+    {(0x400+85), (0x400+147), (0x400+211)}, \
+    {(0x400+86), (0x400+148), (0x400+212)}, \
+    {(0x400+87), (0x400+149), (0x400+213)}, \
+    {(0x400+88), (0x400+150), (0x400+214)}, \
+    {(0x400+89), (0x400+151), (0x400+215)}, \
+    {(0x400+90), (0x400+152), (0x400+216)}, \
+    {(0x400+91), (0x400+153), (0x400+217)}, \
+    {(0x400+92), (0x400+154), (0x400+218)}, \
+    {(0x400+93), (0x400+155), (0x400+219)}, \
+    {(0x400+94), (0x400+156), (0x400+220)}, \
+    {(0x400+95), (0x400+157), (0x400+221)}, \
+    {(0x400+96), (0x400+158), (0x400+222)}, \
+    {(0x400+97), (0x400+159), (0x400+223)}, \
+    {(0x400+98), (0x400+160), (0x400+224)}, \
+    {(0x400+99), (0x400+161), (0x400+225)}, \
+    {(0x400+100), (0x400+162), (0x400+226)}, \
+    {(0x400+101), (0x400+163), (0x400+227)}, \
+    {(0x400+102), (0x400+164), (0x400+228)}, \
+    {(0x400+103), (0x400+165), (0x400+229)}, \
+    {(0x400+104), (0x400+166), (0x400+230)}, \
+    {(0x400+105), (0x400+167), (0x400+231)}, \
+    {(0x400+106), (0x400+168), (0x400+232)}, \
+    {(0x400+107), (0x400+169), (0x400+233)}, \
+    {(0x400+108), (0x400+170), (0x400+234)}, \
+    {(0x400+109), (0x400+171), (0x400+235)}, \
+    {(0x400+110), (0x400+172), (0x400+236)}, \
+    {(0x400+111), (0x400+173), (0x400+237)}, \
+    {(0x400+112), (0x400+174), (0x400+238)}, \
+    {(0x400+113), (0x400+175), (0x400+239)}, \
+    {(0x400+114), (0x400+176), (0x400+240)}, \
+    {(0x400+115), (0x400+177), (0x400+241)}, \
+    {(0x400+116), (0x400+178), (0x400+242)}, \
+    {(0x400+117), (0x400+179), (0x400+243)}, \
+    {(0x400+118), (0x400+180), (0x400+244)}, \
+    {(0x400+119), (0x400+181), (0x400+245)}, \
+    {(0x400+120), (0x400+182), (0x400+246)}, \
+    {(0x400+121), (0x400+183), (0x400+247)}, \
+    {(0x400+122), (0x400+184), (0x400+248)}, \
+    {(0x400+123), (0x400+185), (0x400+249)}, \
+    {(0x400+124), (0x400+186), (0x400+250)}, \
+    {(0x400+125), (0x400+187), (0x400+251)}, \
+    {(0x400+126), (0x400+188), (0x400+252)}, \
+    {-1, (0x400+189), (0x400+253)} \
+}
+
+#define BUILDING_LIGHT_CHANNELS { \
+    {(0x500+0), -1, (0x500+126)}, \
+    {(0x500+1), (0x500+63), (0x500+127)}, \
+    {(0x500+2), (0x500+64), (0x500+128)}, \
+    {(0x500+3), (0x500+65), (0x500+129)}, \
+    {(0x500+4), (0x500+66), (0x500+130)}, \
+    {(0x500+5), (0x500+67), (0x500+131)}, \
+    {(0x500+6), (0x500+68), (0x500+132)}, \
+    {(0x500+7), (0x500+69), (0x500+133)}, \
+    {(0x500+8), (0x500+70), (0x500+134)}, \
+    {(0x500+9), (0x500+71), (0x500+135)}, \
+    {(0x500+10), (0x500+72), (0x500+136)}, \
+    {(0x500+11), (0x500+73), (0x500+137)}, \
+    {(0x500+12), (0x500+74), (0x500+138)}, \
+    {(0x500+13), (0x500+75), (0x500+139)}, \
+    {(0x500+14), (0x500+76), (0x500+140)}, \
+    {(0x500+15), (0x500+77), (0x500+141)}, \
+    {(0x500+16), (0x500+78), (0x500+142)}, \
+    {(0x500+17), (0x500+79), (0x500+143)}, \
+    {(0x500+18), (0x500+80), (0x500+144)}, \
+    {(0x500+19), (0x500+81), (0x500+145)}, \
+    {(0x500+20), (0x500+82), (0x500+146)}, \
+    {(0x500+21), (0x500+83), (0x500+147)}, \
+    {(0x500+22), (0x500+84), (0x500+148)}, \
+    {(0x500+23), (0x500+85), (0x500+149)}, \
+    {(0x500+24), (0x500+86), (0x500+150)}, \
+    {(0x500+25), (0x500+87), (0x500+151)}, \
+    {(0x500+26), (0x500+88), (0x500+152)}, \
+    {(0x500+27), (0x500+89), (0x500+153)}, \
+    {(0x500+28), (0x500+90), (0x500+154)}, \
+    {(0x500+29), (0x500+91), (0x500+155)}, \
+    {(0x500+30), (0x500+92), (0x500+156)}, \
+    {(0x500+31), (0x500+93), (0x500+157)}, \
+    {(0x500+32), (0x500+94), (0x500+158)}, \
+    {(0x500+33), (0x500+95), (0x500+159)}, \
+    {(0x500+34), (0x500+96), (0x500+160)}, \
+    {(0x500+35), (0x500+97), (0x500+161)}, \
+    {(0x500+36), (0x500+98), (0x500+162)}, \
+    {(0x500+37), (0x500+99), (0x500+163)}, \
+    {(0x500+38), (0x500+100), (0x500+164)}, \
+    {(0x500+39), (0x500+101), (0x500+165)}, \
+    {(0x500+40), (0x500+102), (0x500+166)}, \
+    {(0x500+41), (0x500+103), (0x500+167)}, \
+    {(0x500+42), (0x500+104), (0x500+168)}, \
+    {(0x500+43), (0x500+105), (0x500+169)}, \
+    {(0x500+44), (0x500+106), (0x500+170)}, \
+    {(0x500+45), (0x500+107), (0x500+171)}, \
+    {(0x500+46), (0x500+108), (0x500+172)}, \
+    {(0x500+47), (0x500+109), (0x500+173)}, \
+    {(0x500+48), (0x500+110), (0x500+174)}, \
+    {(0x500+49), (0x500+111), (0x500+175)}, \
+    {(0x500+50), (0x500+112), (0x500+176)}, \
+    {(0x500+51), (0x500+113), (0x500+177)}, \
+    {(0x500+52), (0x500+114), (0x500+178)}, \
+    {(0x500+53), (0x500+115), (0x500+179)}, \
+    {(0x500+54), (0x500+116), (0x500+180)}, \
+    {(0x500+55), (0x500+117), (0x500+181)}, \
+    {(0x500+56), (0x500+118), (0x500+182)}, \
+    {(0x500+57), (0x500+119), (0x500+183)}, \
+    {(0x500+58), (0x500+120), (0x500+184)}, \
+    {(0x500+59), (0x500+121), (0x500+185)}, \
+    {(0x500+60), (0x500+122), (0x500+186)}, \
+    {(0x500+61), (0x500+123), (0x500+187)}, \
+    {(0x500+62), (0x500+124), (0x500+188)}, \
+    {-1, (0x500+125), (0x500+189)} \
+}
+
+/* Binary floor indicator, most significant bit first */
+#define BUILDING_FLOOR_INDICATOR_BITS 6
+#define BUILDING_FLOOR_INDICATOR_CHANNELS { (0x500+190), (0x500+191), (0x500+192), (0x500+193), (0x500+194), (0x500+195) }
+
+#endif //BUILDING_H
@@ -0,0 +1,59 @@
+/* Generated by tools/gen_building.py from buildings/tower16.building. Do not edit. */
+#ifndef BUILDING_H
+#define BUILDING_H
+
+#define BUILDING_NAME "tower16"
+#define HARDWARE_NUMBER_OF_FLOORS 16
+
+/* 1 if the channels only exist in the simulated driver */
+#define BUILDING_SIMULATED_ONLY 1
+
+/* Number of digital subdevices the channels below are spread over */
+#define BUILDING_SUBDEVICES 6
+
+/* Channel tables, indexed by floor. Order columns are {up, down, cab} */
+#define BUILDING_SENSOR_CHANNELS { (0x400+0), (0x400+1), (0x400+2), (0x400+3), (0x400+4), (0x400+5), (0x400+6), (0x400+7), (0x400+8), (0x400+9), (0x400+10), (0x400+11), (0x400+12), (0x400+13), (0x400+14), (0x400+15) }
+
+#define BUILDING_ORDER_CHANNELS { \
+    {(0x400+16), -1, (0x400+46)}, \
+    {(0x400+17), (0x400+31), (0x400+47)}, \
+    {(0x400+18), (0x400+32), (0x400+48)}, \
+    {(0x400+19), (0x400+33), (0x400+49)}, \
+    {(0x400+20), (0x400+34), (0x400+50)}, \
+    {(0x400+21), (0x400+35), (0x400+51)}, \
+    {(0x400+22), (0x400+36), (0x400+52)}, \
+    {(0x400+23), (0x400+37), (0x400+53)}, \
+    {(0x400+24), (0x400+38), (0x400+54)}, \
+    {(0x400+25), (0x400+39), (0x400+55)}, \
+    {(0x400+26), (0x400+40), (0x400+56)}, \
+    {(0x400+27), (0x400+41), (0x400+57)}, \
+    {(0x400+28), (0x400+42), (0x400+58)}, \
+    {(0x400+29), (0x400+43), (0x400+59)}, \
+    {(0x400+30), (0x400+44), (0x400+60)}, \
+    {-1, (0x400+45), (0x400+61)} \
+}
+
+#define BUILDING_LIGHT_CHANNELS { \
+    {(0x500+0), -1, (0x500+30)}, \
+    {(0x500+1), (0x500+15), (0x500+31)}, \
+    {(0x500+2), (0x500+16), (0x500+32)}, \
+    {(0x500+3), (0x500+17), (0x500+33)}, \
+    {(0x500+4), (0x500+18), (0x500+34)}, \
+    {(0x500+5), (0x500+19), (0x500+35)}, \
+    {(0x500+6), (0x500+20), (0x500+36)}, \
+    {(0x500+7), (0x500+21), (0x500+37)}, \
+    {(0x500+8), (0x500+22), (0x500+38)}, \
+    {(0x500+9), (0x500+23), (0x500+39)}, \
+    {(0x500+10), (0x500+24), (0x500+40)}, \
+    {(0x500+11), (0x500+25), (0x500+41)}, \
+    {(0x500+12), (0x500+26), (0x500+42)}, \
+    {(0x500+13), (0x500+27), (0x500+43)}, \
+    {(0x500+14), (0x500+28), (0x500+44)}, \
+    {-1, (0x500+29), (0x500+45)} \
+}
+
+/* Binary floor indicator, most significant bit first */
+#define BUILDING_FLOOR_INDICATOR_BITS 4
+#define BUILDING_FLOOR_INDICATOR_CHANNELS { (0x500+46), (0x500+47), (0x500+48), (0x500+49) }
+
+#endif //BUILDING_H
@@ -0,0 +1,35 @@
+/* Generated by tools/gen_building.py from buildings/lab.building. Do not edit. */
+#ifndef BUILDING_H
+#define BUILDING_H
+
+#define BUILDING_NAME "lab"
+#define HARDWARE_NUMBER_OF_FLOORS 4
+
+/* 1 if the channels only exist in the simulated driver */
+#define BUILDING_SIMULATED_ONLY 0
+
+/* Number of digital subdevices the channels below are spread over */
+#define BUILDING_SUBDEVICES 4
+
+/* Channel tables, indexed by floor. Order columns are {up, down, cab} */
+#define BUILDING_SENSOR_CHANNELS { SENSOR_FLOOR1, SENSOR_FLOOR2, SENSOR_FLOOR3, SENSOR_FLOOR4 }
+
+#define BUILDING_ORDER_CHANNELS { \
+    {BUTTON_UP1, -1, BUTTON_COMMAND1}, \
+    {BUTTON_UP2, BUTTON_DOWN2, BUTTON_COMMAND2}, \
+    {BUTTON_UP3, BUTTON_DOWN3, BUTTON_COMMAND3}, \
+    {-1, BUTTON_DOWN4, BUTTON_COMMAND4} \
+}
+
+#define BUILDING_LIGHT_CHANNELS { \
+    {LIGHT_UP1, -1, LIGHT_COMMAND1}, \
+    {LIGHT_UP2, LIGHT_DOWN2, LIGHT_COMMAND2}, \
+    {LIGHT_UP3, LIGHT_DOWN3, LIGHT_COMMAND3}, \
+    {-1, LIGHT_DOWN4, LIGHT_COMMAND4} \
+}
+
+/* Binary floor indicator, most significant bit first */
+#define BUILDING_FLOOR_INDICATOR_BITS 2
+#define BUILDING_FLOOR_INDICATOR_CHANNELS { LIGHT_FLOOR_IND1, LIGHT_FLOOR_IND2 }
+
+#endif //BUILDING_H
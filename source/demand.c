@@ -0,0 +1,169 @@
+#define _DEFAULT_SOURCE
+
+#include <fcntl.h>
+#include <math.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "demand.h"
+#include "globals.h"
+#include "timer.h"
+
+
+static int demand_valid(const demand_file_t* p_file) {
+    return p_file->magic == DEMAND_MAGIC && p_file->version == DEMAND_VERSION
+        && p_file->floors == HARDWARE_NUMBER_OF_FLOORS && p_file->buckets == DEMAND_BUCKETS;
+}
+
+
+static long long demand_time_of_day(long long time_ns, long long day_offset_ns) {
+    return ((time_ns + day_offset_ns) % DEMAND_DAY_NS + DEMAND_DAY_NS) % DEMAND_DAY_NS;
+}
+
+
+int demand_open(demand_t* p_demand, const char* path, long long day_offset_ns) {
+    demand_file_t* p_file;
+    if(path == NULL) {
+        p_file = mmap(NULL, sizeof(demand_file_t), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    }
+    else {
+        int fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        if(fd < 0) {
+            return -1;
+        }
+        if(ftruncate(fd, sizeof(demand_file_t)) != 0) {
+            close(fd);
+            return -1;
+        }
+        // The mapping keeps the file open
+        p_file = mmap(NULL, sizeof(demand_file_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+    }
+    if(p_file == MAP_FAILED) {
+        return -1;
+    }
+
+    if(!demand_valid(p_file)) {
+        memset(p_file, 0, sizeof(demand_file_t));
+        p_file->version = DEMAND_VERSION;
+        p_file->floors = HARDWARE_NUMBER_OF_FLOORS;
+        p_file->buckets = DEMAND_BUCKETS;
+        // Marked valid last, so a crash while it is set up leaves a file that is set up again
+        p_file->magic = DEMAND_MAGIC;
+    }
+
+    long long now = timer_now_ns();
+    long long time_of_day = demand_time_of_day(now, day_offset_ns);
+    p_demand->p_file = p_file;
+    p_demand->day_offset_ns = day_offset_ns;
+    p_demand->bucket_start_ns = now - time_of_day % DEMAND_BUCKET_NS;
+    p_demand->bucket_whole = (time_of_day % DEMAND_BUCKET_NS == 0);
+    memset(p_demand->count, 0, sizeof(p_demand->count));
+    memset(p_demand->recent, 0, sizeof(p_demand->recent));
+    p_demand->recent_ns = now;
+    return 0;
+}
+
+
+void demand_close(demand_t* p_demand) {
+    if(p_demand->p_file != NULL) {
+        munmap(p_demand->p_file, sizeof(demand_file_t));
+        p_demand->p_file = NULL;
+    }
+}
+
+
+static int demand_bucket(const demand_t* p_demand, long long time_ns) {
+    return (int)(demand_time_of_day(time_ns, p_demand->day_offset_ns) / DEMAND_BUCKET_NS);
+}
+
+
+/**
+ * @brief Learn from the parts of the day that have ended by @p now , including those without calls
+ */
+static void demand_advance(demand_t* p_demand, long long now) {
+    demand_file_t* p_file = p_demand->p_file;
+
+    for(int ended = 0; now >= p_demand->bucket_start_ns + DEMAND_BUCKET_NS; ended++) {
+        if(ended == DEMAND_BUCKETS) {
+            // Every part of the day has been learned from, as having no calls
+            p_demand->bucket_start_ns = now - (now - p_demand->bucket_start_ns) % DEMAND_BUCKET_NS;
+            break;
+        }
+
+        int bucket = demand_bucket(p_demand, p_demand->bucket_start_ns);
+        if(p_demand->bucket_whole) {
+            for(int f = 0; f < HARDWARE_NUMBER_OF_FLOORS; f++) {
+                for(int d = 0; d < 2; d++) {
+                    float sample = p_demand->count[f][d] * (float)(3600e9 / DEMAND_BUCKET_NS);
+                    float* p_rate = &p_file->rate_per_hour[bucket][f][d];
+                    *p_rate = (p_file->days[bucket] > 0) ? *p_rate + (sample - *p_rate) / DEMAND_DAY_WEIGHT : sample;
+                }
+            }
+            p_file->days[bucket]++;
+        }
+        memset(p_demand->count, 0, sizeof(p_demand->count));
+        p_demand->bucket_start_ns += DEMAND_BUCKET_NS;
+        p_demand->bucket_whole = 1;
+    }
+}
+
+
+void demand_record(demand_t* p_demand, int floor, HardwareOrder order_type) {
+    if(floor < MIN_FLOOR || floor >= HARDWARE_NUMBER_OF_FLOORS) {
+        return;
+    }
+    long long now = timer_now_ns();
+    demand_advance(p_demand, now);
+
+    double decay = exp(-(now - p_demand->recent_ns) / (double)DEMAND_RECENT_NS);
+    for(int f = 0; f < HARDWARE_NUMBER_OF_FLOORS; f++) {
+        p_demand->recent[f][0] *= decay;
+        p_demand->recent[f][1] *= decay;
+    }
+    p_demand->recent_ns = now;
+
+    int direction = (order_type == HARDWARE_ORDER_DOWN);
+    p_demand->count[floor][direction]++;
+    p_demand->recent[floor][direction] += 1.0;
+}
+
+
+double demand_forecast(const demand_t* p_demand, int floor) {
+    long long now = timer_now_ns();
+    const demand_file_t* p_file = p_demand->p_file;
+
+    // The count decays by 1 / e over the time constant, so it holds the calls of about that long
+    double decay = exp(-(now - p_demand->recent_ns) / (double)DEMAND_RECENT_NS);
+    double recent = (p_demand->recent[floor][0] + p_demand->recent[floor][1]) * decay * (3600e9 / DEMAND_RECENT_NS);
+
+    // Blended towards the next part of the day as this one goes on, so a peak is expected before it starts
+    int bucket = demand_bucket(p_demand, now);
+    int next = (bucket + 1) % DEMAND_BUCKETS;
+    double into = (double)(demand_time_of_day(now, p_demand->day_offset_ns) % DEMAND_BUCKET_NS) / DEMAND_BUCKET_NS;
+    if(p_file->days[bucket] == 0 || p_file->days[next] == 0) {
+        return recent;
+    }
+    double learned = (1.0 - into) * (p_file->rate_per_hour[bucket][floor][0] + p_file->rate_per_hour[bucket][floor][1])
+                   + into * (p_file->rate_per_hour[next][floor][0] + p_file->rate_per_hour[next][floor][1]);
+    return (recent + learned) / 2.0;
+}
+
+
+int demand_park_floor(const demand_t* p_demand, const int* p_cars_at) {
+    int best = FLOOR_NOT_INIT;
+    double best_forecast = 0.0;
+
+    for(int f = MIN_FLOOR; f < HARDWARE_NUMBER_OF_FLOORS; f++) {
+        if(p_cars_at != NULL && p_cars_at[f] > 0) {
+            continue;
+        }
+        double forecast = demand_forecast(p_demand, f);
+        if(forecast >= DEMAND_PARK_MIN_PER_HOUR && (best == FLOOR_NOT_INIT || forecast > best_forecast)) {
+            best = f;
+            best_forecast = forecast;
+        }
+    }
+    return best;
+}
@@ -0,0 +1,112 @@
+/**
+ * @file
+ * @brief Forecast of the hall calls at every floor, for parking idle cars where the next call is likely.
+ *
+ * The model counts the hall calls made at every floor and in every direction. It keeps two rates:
+ * - a learned rate for every quarter of an hour of the day, updated at the end of every quarter
+ *   observed from its start, as an exponentially weighted average over the days;
+ * - a recent rate, as a count that decays exponentially over @c DEMAND_RECENT_NS .
+ *
+ * The forecast for a floor is the recent rate, averaged with the learned rate of the time of day
+ * once that has been learned. The learned rates are kept in a memory-mapped file, so they survive
+ * restarts of the controller. A model opened without a file learns the same, but forgets on exit.
+ *
+ * An elevator that has stood idle with nothing to do for @c DEMAND_PARK_DELAY_NS parks at the floor
+ * with the highest forecast, if that is at least @c DEMAND_PARK_MIN_PER_HOUR . In a group, every car
+ * parks at a different floor.
+ */
+#ifndef DEMAND_H
+#define DEMAND_H
+
+#include <stdint.h>
+
+#include "driver/hardware.h"
+
+
+#define DEMAND_MAGIC 0x444d4e44u                             /**< "DNMD", which a model file starts with */
+#define DEMAND_VERSION 1                                    /**< Layout of the model file */
+#define DEMAND_DAY_NS (24LL * 3600 * 1000000000LL)          /**< Length of a day */
+#define DEMAND_BUCKETS 96                                   /**< Parts of the day with a learned rate of their own */
+#define DEMAND_BUCKET_NS (DEMAND_DAY_NS / DEMAND_BUCKETS)   /**< Length of a part of the day */
+#define DEMAND_DAY_WEIGHT 4                                 /**< A new day weighs 1 / this in a learned rate */
+#define DEMAND_RECENT_NS 600000000000LL                     /**< Time constant of the recent rate */
+#define DEMAND_PARK_DELAY_NS 2000000000LL                   /**< How long an elevator stands idle before it parks */
+#define DEMAND_PARK_MIN_PER_HOUR 20.0                       /**< Fewest forecast hall calls per hour at a floor worth parking at */
+
+
+/**
+ * The learned rates, as laid out in the model's file
+ */
+typedef struct{
+    uint32_t magic;                                             /**< @c DEMAND_MAGIC in a file that holds a model*/
+    uint32_t version;                                           /**< Layout of the file*/
+    int32_t floors;                                             /**< Floors of the building the model is of*/
+    int32_t buckets;                                            /**< Parts of the day the model has*/
+    uint32_t days[DEMAND_BUCKETS];                              /**< Days every part of the day has been learned from*/
+    float rate_per_hour[DEMAND_BUCKETS][HARDWARE_NUMBER_OF_FLOORS][2];  /**< Learned hall calls per hour, up and down*/
+} demand_file_t;
+
+
+/**
+ * The demand model of a building
+ */
+typedef struct{
+    demand_file_t* p_file;                              /**< The learned rates, mapped from the file or from anonymous memory*/
+    long long day_offset_ns;                            /**< Time of day when @c timer_now_ns() is 0*/
+    long long bucket_start_ns;                          /**< When the part of the day being counted started, on the timer clock*/
+    int bucket_whole;                                   /**< 1 if the part of the day has been counted from its start*/
+    int count[HARDWARE_NUMBER_OF_FLOORS][2];            /**< Hall calls in the part of the day so far, up and down*/
+    double recent[HARDWARE_NUMBER_OF_FLOORS][2];        /**< Exponentially decaying count of the hall calls, up and down*/
+    long long recent_ns;                                /**< When @c recent was last decayed*/
+} demand_t;
+
+
+/**
+ * @brief Open a demand model
+ *
+ * @param[out] p_demand     The model
+ * @param[in] path          File the learned rates are kept in, which is created if it does not hold a
+ *                          model of this building, or NULL to keep them in memory only
+ * @param[in] day_offset_ns Time of day when @c timer_now_ns() is 0, in nanoseconds since midnight
+ *
+ * @return 0 on success, and -1 if the file could not be opened or mapped
+ */
+int demand_open(demand_t* p_demand, const char* path, long long day_offset_ns);
+
+
+/**
+ * @brief Unmap the learned rates of @p p_demand , and with them close its file
+ */
+void demand_close(demand_t* p_demand);
+
+
+/**
+ * @brief Count a new hall call
+ *
+ * @param[in, out] p_demand The model
+ * @param[in] floor         Floor of the call
+ * @param[in] order_type    @c HARDWARE_ORDER_UP or @c HARDWARE_ORDER_DOWN
+ */
+void demand_record(demand_t* p_demand, int floor, HardwareOrder order_type);
+
+
+/**
+ * @brief Forecast of the hall calls per hour at @p floor , in both directions, at this time of day
+ */
+double demand_forecast(const demand_t* p_demand, int floor);
+
+
+/**
+ * @brief The floor to park an idle car at
+ *
+ * @param[in] p_demand      The model
+ * @param[in] p_cars_at     Number of other cars standing or parking at every floor, which are passed
+ *                          over, or NULL
+ *
+ * @return The free floor with the highest forecast, or @c FLOOR_NOT_INIT if no free floor has a
+ * forecast of at least @c DEMAND_PARK_MIN_PER_HOUR
+ */
+int demand_park_floor(const demand_t* p_demand, const int* p_cars_at);
+
+
+#endif //DEMAND_H
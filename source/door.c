@@ -0,0 +1,101 @@
+#include <string.h>
+
+#include "door.h"
+#include "globals.h"
+#include "timer.h"
+
+
+void door_init(door_t* p_door) {
+    p_door->policy = DOOR_POLICY_ADAPTIVE;
+    p_door->open = 0;
+    p_door->opened_ns = 0;
+    for(int f = 0; f < HARDWARE_NUMBER_OF_FLOORS; f++) {
+        p_door->hall_stops[f] = 0.0;
+    }
+    p_door->hall_total = 0.0;
+}
+
+
+/**
+ * @brief Learn a hall stop at @p floor
+ */
+static void door_learn_hall_stop(door_t* p_door, int floor) {
+    double keep = 1.0 - 1.0 / DOOR_DEMAND_WEIGHT;
+    for(int f = 0; f < HARDWARE_NUMBER_OF_FLOORS; f++) {
+        p_door->hall_stops[f] *= keep;
+    }
+    p_door->hall_stops[floor] += 1.0;
+    p_door->hall_total = p_door->hall_total * keep + 1.0;
+}
+
+
+static int door_hall_stop(const queue_t* p_queue, int floor) {
+    return queue_has_order(p_queue, floor, HARDWARE_ORDER_UP) || queue_has_order(p_queue, floor, HARDWARE_ORDER_DOWN);
+}
+
+
+long long door_expected_dwell_ns(const door_t* p_door, const queue_t* p_queue, int floor) {
+    if(p_door->policy != DOOR_POLICY_ADAPTIVE || floor < MIN_FLOOR || floor >= HARDWARE_NUMBER_OF_FLOORS) {
+        return DOOR_TIME_NS;
+    }
+    if(!door_hall_stop(p_queue, floor)) {
+        // A stop for no order at all is made to park, on giving parking up, or for an order another car took
+        return queue_has_order(p_queue, floor, HARDWARE_ORDER_INSIDE) ? DOOR_CAB_TIME_NS : DOOR_CLEAR_TIME_NS;
+    }
+    if(p_door->hall_total <= 0.0) {
+        return DOOR_TIME_NS;
+    }
+
+    // Only the share above that of a floor of even traffic is heavy
+    double even = 1.0 / HARDWARE_NUMBER_OF_FLOORS;
+    double heavy = (p_door->hall_stops[floor] / p_door->hall_total - even) / (1.0 - even);
+    return DOOR_TIME_NS + ((heavy > 0.0) ? (long long)(heavy * DOOR_HEAVY_TIME_NS) : 0);
+}
+
+
+long long door_dwell_ns(door_t* p_door, const queue_t* p_queue, int floor) {
+    if(!p_door->open) {
+        p_door->open = 1;
+        p_door->opened_ns = timer_now_ns();
+        // The stop counts in its own dwell
+        if(p_door->policy == DOOR_POLICY_ADAPTIVE && floor >= MIN_FLOOR && floor < HARDWARE_NUMBER_OF_FLOORS
+           && door_hall_stop(p_queue, floor)) {
+            door_learn_hall_stop(p_door, floor);
+        }
+        return door_expected_dwell_ns(p_door, p_queue, floor);
+    }
+
+    switch(p_door->policy) {
+        case DOOR_POLICY_ADAPTIVE:
+            return (timer_now_ns() - p_door->opened_ns < DOOR_NUDGE_TIME_NS) ? DOOR_CLEAR_TIME_NS : 0;
+        default:
+            return DOOR_TIME_NS;
+    }
+}
+
+
+void door_close(door_t* p_door) {
+    p_door->open = 0;
+}
+
+
+const char* door_policy_name(door_policy_t policy) {
+    switch(policy) {
+        case DOOR_POLICY_FIXED:
+            return "fixed";
+        case DOOR_POLICY_ADAPTIVE:
+            return "adaptive";
+    }
+    return "unknown";
+}
+
+
+int door_policy_from_name(const char* name, door_policy_t* p_policy) {
+    for(int policy = 0; policy < DOOR_POLICY_COUNT; policy++) {
+        if(strcmp(name, door_policy_name(policy)) == 0) {
+            *p_policy = policy;
+            return 0;
+        }
+    }
+    return -1;
+}
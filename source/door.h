@@ -0,0 +1,119 @@
+/**
+ * @file
+ * @brief How long the door of an elevator dwells open at a stop.
+ *
+ * The door timer is started when the door opens and every time the obstruction is high while it
+ * is open, and the door closes once the timer is done. With @c DOOR_POLICY_FIXED the timer always
+ * runs @c DOOR_TIME_NS . With @c DOOR_POLICY_ADAPTIVE it depends on the stop:
+ * - a stop where riders only get off, with no hall call at the floor, dwells @c DOOR_CAB_TIME_NS ;
+ * - a stop for no order at all, such as one made to park, dwells @c DOOR_CLEAR_TIME_NS ;
+ * - a stop for a hall call dwells @c DOOR_TIME_NS , and up to @c DOOR_HEAVY_TIME_NS longer at a
+ *   floor that takes more than its share of the elevator's hall stops, where more passengers board;
+ * - once the obstruction has cleared, the door closes after @c DOOR_CLEAR_TIME_NS , since whoever
+ *   held it has passed;
+ * - once the door has been open for @c DOOR_NUDGE_TIME_NS , it closes as soon as the obstruction
+ *   clears, so a fluttering obstruction switch cannot hold it open. It never closes while the
+ *   obstruction is high.
+ *
+ * The share of hall stops at every floor is learned online, as an exponentially weighted count.
+ */
+#ifndef DOOR_H
+#define DOOR_H
+
+#include "driver/hardware.h"
+#include "queue.h"
+
+
+#define DOOR_CAB_TIME_NS 2000000000LL       /**< Dwell at a stop where riders only get off */
+#define DOOR_HEAVY_TIME_NS 2000000000LL     /**< Most extra dwell at the floor of all hall stops */
+#define DOOR_CLEAR_TIME_NS 1000000000LL     /**< Dwell after the obstruction clears */
+#define DOOR_NUDGE_TIME_NS 20000000000LL    /**< Time open after which the obstruction no longer extends the dwell */
+#define DOOR_DEMAND_WEIGHT 64               /**< A new hall stop weighs 1 / this in the learned shares */
+
+
+/**
+ * Enum for the ways the dwell of the door can be chosen
+ */
+typedef enum{
+    DOOR_POLICY_FIXED,          /**< @c DOOR_TIME_NS at every stop and after every obstruction*/
+    DOOR_POLICY_ADAPTIVE,       /**< By the kind of stop, the floor and the obstruction*/
+    DOOR_POLICY_COUNT           /**< Number of policies, not a policy*/
+} door_policy_t;
+
+
+/**
+ * The door of one elevator
+ */
+typedef struct{
+    door_policy_t policy;                           /**< How the dwell is chosen*/
+    int open;                                       /**< 1 from when the door timer starts at a stop until the door closes*/
+    long long opened_ns;                            /**< When the door opened at the current stop*/
+    double hall_stops[HARDWARE_NUMBER_OF_FLOORS];   /**< Weighted count of the hall stops at every floor*/
+    double hall_total;                              /**< Sum of @c hall_stops*/
+} door_t;
+
+
+/**
+ * @brief Initialize @p p_door closed, with the adaptive policy and no hall stops learned
+ *
+ * @param[out] p_door   The door to initialize
+ */
+void door_init(door_t* p_door);
+
+
+/**
+ * @brief Dwell to start the door timer with
+ *
+ * @param[in, out] p_door   The door, which learns from every stop it opens at
+ * @param[in] p_queue       The elevator's queue, before the orders at @p floor are cleared
+ * @param[in] floor         The floor the door is open at
+ *
+ * @return For the first call at a stop, the dwell of the stop. For the calls after, which are
+ * made while the obstruction is high, the dwell after the obstruction clears.
+ */
+long long door_dwell_ns(door_t* p_door, const queue_t* p_queue, int floor);
+
+
+/**
+ * @brief Dwell a stop at @p floor would start the door timer with, for estimates
+ *
+ * @param[in] p_door    The door, which is left as it is
+ * @param[in] p_queue   The elevator's queue
+ * @param[in] floor     The floor of the stop
+ *
+ * @return The dwell of @c door_dwell_ns() for a stop at @p floor with the orders of @p p_queue ,
+ * from the hall stops learned so far
+ */
+long long door_expected_dwell_ns(const door_t* p_door, const queue_t* p_queue, int floor);
+
+
+/**
+ * @brief Note that the door has closed, so the next dwell is of a new stop
+ *
+ * @param[in, out] p_door   The door
+ */
+void door_close(door_t* p_door);
+
+
+/**
+ * @brief Name of a policy
+ *
+ * @param[in] policy    The policy
+ *
+ * @return The name, as given on the command line
+ */
+const char* door_policy_name(door_policy_t policy);
+
+
+/**
+ * @brief Look up a policy by its name
+ *
+ * @param[in] name          The name, as returned by @c door_policy_name()
+ * @param[out] p_policy     The policy, left alone if there is none by that name
+ *
+ * @return 0 if @p name is a policy, and -1 otherwise
+ */
+int door_policy_from_name(const char* name, door_policy_t* p_policy);
+
+
+#endif //DOOR_H
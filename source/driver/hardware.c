@@ -1,8 +1,216 @@
+#define _POSIX_C_SOURCE 200809L
+
 #include "hardware.h"
 #include "channels.h"
 #include "io.h"
+#include "io_record.h"
 
+#include <pthread.h>
+#include <signal.h>
+#include <stdatomic.h>
 #include <stdlib.h>
+#include <time.h>
+
+#define HARDWARE_WORDS_PER_SUBDEVICE 8   /* 256 channels in words of 32 */
+#define HARDWARE_MAX_WORDS (BUILDING_SUBDEVICES * HARDWARE_WORDS_PER_SUBDEVICE)
+
+/* The digital channels in use, grouped into 32-bit words that
+ * are read or written with a single bitfield call each. */
+typedef struct {
+    int count;
+    int subdevice[HARDWARE_MAX_WORDS];
+    int base_channel[HARDWARE_MAX_WORDS];
+    short index[BUILDING_SUBDEVICES][HARDWARE_WORDS_PER_SUBDEVICE];
+} HardwareWordMap;
+
+static const int hardware_sensor_channels[HARDWARE_NUMBER_OF_FLOORS] = BUILDING_SENSOR_CHANNELS;
+static const int hardware_order_channels[HARDWARE_NUMBER_OF_FLOORS][3] = BUILDING_ORDER_CHANNELS;
+static const int hardware_light_channels[HARDWARE_NUMBER_OF_FLOORS][3] = BUILDING_LIGHT_CHANNELS;
+static const int hardware_indicator_channels[BUILDING_FLOOR_INDICATOR_BITS] = BUILDING_FLOOR_INDICATOR_CHANNELS;
+
+/* Latest sample of the input words. Every sensor and button bit
+ * remembers its floor, so the active ones can be found by scanning
+ * words instead of floors. */
+static HardwareWordMap hardware_inputs;
+static unsigned int hardware_input_mask[HARDWARE_MAX_WORDS];
+static unsigned int hardware_sensor_mask[HARDWARE_MAX_WORDS];
+static unsigned int hardware_order_mask[HARDWARE_MAX_WORDS];
+static short hardware_bit_floor[HARDWARE_MAX_WORDS][32];
+static HardwareOrder hardware_bit_order_type[HARDWARE_MAX_WORDS][32];
+
+static HardwareWordMap hardware_outputs;
+static unsigned int hardware_output_mask[HARDWARE_MAX_WORDS];
+
+/* A change of the debounced inputs of a word, as found by the sampler. */
+typedef struct {
+    long long time_ns;
+    int word;
+    unsigned int rose;
+    unsigned int fell;
+} HardwareEdge;
+
+/* Everything that differs between the cars of a bank; the channel
+ * maps above are shared, since every car is wired the same way.
+ * Commands only touch the output shadow; hardware_flush_outputs
+ * writes whatever differs from what was last written.
+ *
+ * While the sampler runs, the edges of a car go from the sampler to
+ * the controller through a single-producer, single-consumer ring. */
+typedef struct {
+    unsigned int input_sample[HARDWARE_MAX_WORDS];
+    unsigned int input_rose[HARDWARE_MAX_WORDS];
+    unsigned int output_shadow[HARDWARE_MAX_WORDS];
+    unsigned int output_written[HARDWARE_MAX_WORDS];
+    int motor_shadow;
+    int motor_written;
+
+    HardwareEdge edges[HARDWARE_EDGE_QUEUE];
+    _Atomic unsigned long long edge_head;   /* Written by the sampler */
+    _Atomic unsigned long long edge_tail;   /* Written by the controller */
+    _Atomic int stop_floor;
+    _Atomic unsigned int reflex_stops;      /* Written by the sampler, after the edge that caused it */
+    unsigned int reflex_stops_drained;
+
+    /* Sampler side: debounced inputs, the two bits of a counter of
+     * differing samples for every input, and what was last queued */
+    unsigned int debounced[HARDWARE_MAX_WORDS];
+    unsigned int count0[HARDWARE_MAX_WORDS];
+    unsigned int count1[HARDWARE_MAX_WORDS];
+    unsigned int queued[HARDWARE_MAX_WORDS];
+
+    HardwareSamplerStats stats;
+
+    /* Made by the controller and by the sampler, which are serialized
+     * while both make them; atomic for readers on other threads */
+    _Atomic unsigned long long io_calls;
+} HardwareCar;
+
+static HardwareCar hardware_cars[HARDWARE_MAX_CARS];
+static HardwareCar* hardware_car = &hardware_cars[0];
+
+/* The sampler thread. The I/O layer is not thread safe, so every use
+ * of it is serialized by the mutex while the sampler runs; the flag
+ * is only changed while no other thread uses the hardware. */
+static pthread_t hardware_sampler;
+static pthread_mutex_t hardware_io_mutex = PTHREAD_MUTEX_INITIALIZER;
+static int hardware_sampler_running = 0;
+static atomic_int hardware_sampler_stopping;
+static int hardware_sampler_cars;
+static long long hardware_sampler_period_ns;
+
+static int hardware_word(HardwareWordMap* map, int channel){
+    int subdevice = channel >> 8;
+    int word = (channel & 0xff) >> 5;
+
+    if(map->index[subdevice][word] < 0){
+        map->index[subdevice][word] = map->count;
+        map->subdevice[map->count] = subdevice;
+        map->base_channel[map->count] = word << 5;
+        map->count++;
+    }
+
+    return map->index[subdevice][word];
+}
+
+static void hardware_clear_word_map(HardwareWordMap* map){
+    map->count = 0;
+    for(int subdevice = 0; subdevice < BUILDING_SUBDEVICES; subdevice++){
+        for(int word = 0; word < HARDWARE_WORDS_PER_SUBDEVICE; word++){
+            map->index[subdevice][word] = -1;
+        }
+    }
+}
+
+static void hardware_map_input(int channel, unsigned int* mask, int floor, HardwareOrder order_type){
+    if(channel < 0){
+        return;
+    }
+    int word = hardware_word(&hardware_inputs, channel);
+    int bit = channel & 0x1f;
+
+    hardware_input_mask[word] |= 1u << bit;
+    mask[word] |= 1u << bit;
+    hardware_bit_floor[word][bit] = floor;
+    hardware_bit_order_type[word][bit] = order_type;
+}
+
+static void hardware_map_output(int channel){
+    if(channel >= 0){
+        int word = hardware_word(&hardware_outputs, channel);
+        hardware_output_mask[word] |= 1u << (channel & 0x1f);
+    }
+}
+
+static int hardware_sampled_bit(int channel){
+    int word = hardware_inputs.index[channel >> 8][(channel & 0xff) >> 5];
+    return (hardware_car->input_sample[word] >> (channel & 0x1f)) & 1;
+}
+
+static int hardware_shadow_bit(int channel){
+    int word = hardware_outputs.index[channel >> 8][(channel & 0xff) >> 5];
+    return (hardware_car->output_shadow[word] >> (channel & 0x1f)) & 1;
+}
+
+static void hardware_write_output_bit(int channel, int value){
+    int word = hardware_outputs.index[channel >> 8][(channel & 0xff) >> 5];
+
+    if(value){
+        hardware_car->output_shadow[word] |= 1u << (channel & 0x1f);
+    }
+    else{
+        hardware_car->output_shadow[word] &= ~(1u << (channel & 0x1f));
+    }
+}
+
+static void hardware_count_io_calls(HardwareCar* car, int calls){
+    atomic_store_explicit(&car->io_calls, atomic_load_explicit(&car->io_calls, memory_order_relaxed) + calls, memory_order_relaxed);
+}
+
+static long long hardware_now_ns(){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/* Take the I/O layer for the selected car, if the sampler shares it */
+static void hardware_io_begin(){
+    if(hardware_sampler_running){
+        pthread_mutex_lock(&hardware_io_mutex);
+        io_select_car(hardware_car - hardware_cars);
+    }
+}
+
+static void hardware_io_end(){
+    if(hardware_sampler_running){
+        pthread_mutex_unlock(&hardware_io_mutex);
+    }
+}
+
+static void hardware_build_channel_maps(){
+    static const HardwareOrder column_types[3] = {
+        HARDWARE_ORDER_UP, HARDWARE_ORDER_DOWN, HARDWARE_ORDER_INSIDE
+    };
+
+    hardware_clear_word_map(&hardware_inputs);
+    hardware_clear_word_map(&hardware_outputs);
+
+    for(int floor = 0; floor < HARDWARE_NUMBER_OF_FLOORS; floor++){
+        hardware_map_input(hardware_sensor_channels[floor], hardware_sensor_mask, floor, HARDWARE_ORDER_NOT_INIT);
+        for(int column = 0; column < 3; column++){
+            hardware_map_input(hardware_order_channels[floor][column], hardware_order_mask, floor, column_types[column]);
+            hardware_map_output(hardware_light_channels[floor][column]);
+        }
+    }
+    hardware_input_mask[hardware_word(&hardware_inputs, STOP)] |= 1u << (STOP & 0x1f);
+    hardware_input_mask[hardware_word(&hardware_inputs, OBSTRUCTION)] |= 1u << (OBSTRUCTION & 0x1f);
+
+    for(int bit = 0; bit < BUILDING_FLOOR_INDICATOR_BITS; bit++){
+        hardware_map_output(hardware_indicator_channels[bit]);
+    }
+    hardware_map_output(MOTORDIR);
+    hardware_map_output(LIGHT_STOP);
+    hardware_map_output(LIGHT_DOOR_OPEN);
+}
 
 static int hardware_legal_floor(int floor, HardwareOrder order_type){
     int lower_floor = 0;
@@ -24,7 +232,7 @@ static int hardware_legal_floor(int floor, HardwareOrder order_type){
 }
 
 static int hardware_order_type_bit(HardwareOrder order_type){
-    int type_bit;
+    int type_bit = 0;
 
     switch(order_type){
         case HARDWARE_ORDER_UP:
@@ -48,75 +256,345 @@ int hardware_init(){
         return 1;
     }
 
+    hardware_build_channel_maps();
+
+    // Nothing is known about the outputs yet; make the first flush write all of them
+    for(int word = 0; word < hardware_outputs.count; word++){
+        hardware_car->output_written[word] = ~hardware_car->output_shadow[word];
+    }
+    hardware_car->motor_written = -1;
+
     for(int i = 0; i < HARDWARE_NUMBER_OF_FLOORS; i++){
         if(i != 0){
-            hardware_command_order_light(HARDWARE_ORDER_DOWN, i, 0);
+            hardware_command_order_light(i, HARDWARE_ORDER_DOWN, 0);
         }
 
         if(i != HARDWARE_NUMBER_OF_FLOORS - 1){
-            hardware_command_order_light(HARDWARE_ORDER_UP, i, 0);
+            hardware_command_order_light(i, HARDWARE_ORDER_UP, 0);
         }
 
-        hardware_command_order_light(HARDWARE_ORDER_INSIDE, i, 0);
+        hardware_command_order_light(i, HARDWARE_ORDER_INSIDE, 0);
     }
 
     hardware_command_stop_light(0);
     hardware_command_door_open(0);
     hardware_command_floor_indicator_on(0);
 
+    hardware_flush_outputs();
+    hardware_sample_inputs();
+
+    return 0;
+}
+
+int hardware_select_car(int car){
+    // While the sampler runs, the I/O layer is pointed at the car whenever it is taken
+    if(car < 0 || car >= HARDWARE_MAX_CARS || (!hardware_sampler_running && !io_select_car(car))){
+        return 1;
+    }
+
+    hardware_car = &hardware_cars[car];
     return 0;
 }
 
+/* Apply the edges the sampler queued for the selected car since the last call */
+static void hardware_drain_edges(){
+    // Loaded before the queue: the edge of every reflex stop counted here is queued by now
+    unsigned int reflex_stops = atomic_load_explicit(&hardware_car->reflex_stops, memory_order_acquire);
+    unsigned long long head = atomic_load_explicit(&hardware_car->edge_head, memory_order_acquire);
+    unsigned long long tail = atomic_load_explicit(&hardware_car->edge_tail, memory_order_relaxed);
+    long long now = hardware_now_ns();
+
+    for(int word = 0; word < hardware_inputs.count; word++){
+        hardware_car->input_rose[word] = 0;
+    }
+
+    for(; tail != head; tail++){
+        const HardwareEdge* edge = &hardware_car->edges[tail & (HARDWARE_EDGE_QUEUE - 1)];
+        hardware_car->input_sample[edge->word] = (hardware_car->input_sample[edge->word] | edge->rose) & ~edge->fell;
+        hardware_car->input_rose[edge->word] |= edge->rose;
+
+        long long age = now - edge->time_ns;
+        hardware_car->stats.edge_age_sum_ns += age;
+        if(age > hardware_car->stats.edge_age_max_ns){
+            hardware_car->stats.edge_age_max_ns = age;
+        }
+        hardware_car->stats.drained++;
+    }
+
+    atomic_store_explicit(&hardware_car->edge_tail, tail, memory_order_release);
+    hardware_car->reflex_stops_drained = reflex_stops;
+}
+
+void hardware_sample_inputs(){
+    if(hardware_sampler_running){
+        hardware_drain_edges();
+        return;
+    }
+
+    for(int word = 0; word < hardware_inputs.count; word++){
+        hardware_car->input_sample[word] = io_read_bitfield(hardware_inputs.subdevice[word], hardware_inputs.base_channel[word]);
+    }
+    hardware_count_io_calls(hardware_car, hardware_inputs.count);
+
+    if(io_record_is_open()){
+        for(int word = 0; word < hardware_inputs.count; word++){
+            io_record_word(IO_RECORD_INPUT_WORD, hardware_car - hardware_cars, hardware_inputs.subdevice[word],
+                           hardware_inputs.base_channel[word], hardware_car->input_sample[word] & hardware_input_mask[word]);
+        }
+    }
+}
+
+void hardware_flush_outputs(){
+    hardware_io_begin();
+    for(int word = 0; word < hardware_outputs.count; word++){
+        // Inputs may share the word, so only the mapped output bits are ever written
+        unsigned int dirty = (hardware_car->output_shadow[word] ^ hardware_car->output_written[word]) & hardware_output_mask[word];
+        if(dirty){
+            io_write_bitfield(hardware_outputs.subdevice[word], dirty, hardware_car->output_shadow[word], hardware_outputs.base_channel[word]);
+            hardware_count_io_calls(hardware_car, 1);
+            hardware_car->output_written[word] = hardware_car->output_shadow[word];
+            if(io_record_is_open()){
+                io_record_word(IO_RECORD_OUTPUT_WORD, hardware_car - hardware_cars, hardware_outputs.subdevice[word],
+                               hardware_outputs.base_channel[word], hardware_car->output_shadow[word] & hardware_output_mask[word]);
+            }
+        }
+    }
+
+    // After a reflex stop the motor stays off until the controller has seen the edge behind it
+    int held = hardware_car->motor_shadow != 0
+            && atomic_load_explicit(&hardware_car->reflex_stops, memory_order_relaxed) != hardware_car->reflex_stops_drained;
+
+    if(hardware_car->motor_shadow != hardware_car->motor_written && !held){
+        io_write_analog(MOTOR, hardware_car->motor_shadow);
+        hardware_count_io_calls(hardware_car, 1);
+        hardware_car->motor_written = hardware_car->motor_shadow;
+        if(io_record_is_open()){
+            io_record_analog(hardware_car - hardware_cars, MOTOR, hardware_car->motor_shadow);
+        }
+    }
+    io_flush();
+    hardware_io_end();
+}
+
+void hardware_set_stop_floor(int floor){
+    atomic_store_explicit(&hardware_car->stop_floor, floor, memory_order_relaxed);
+}
+
+/* Whether a rising edge needs the motor stopped before the controller gets to it */
+static int hardware_needs_reflex_stop(HardwareCar* car, int word, unsigned int rose){
+    if(hardware_inputs.index[STOP >> 8][(STOP & 0xff) >> 5] == word && (rose >> (STOP & 0x1f)) & 1){
+        return 1;
+    }
+
+    unsigned int arrived = rose & hardware_sensor_mask[word];
+    if(!arrived){
+        return 0;
+    }
+    int floor = hardware_bit_floor[word][__builtin_ctz(arrived)];
+    int stop_floor = atomic_load_explicit(&car->stop_floor, memory_order_relaxed);
+
+    return floor == 0 || floor == HARDWARE_NUMBER_OF_FLOORS - 1
+        || floor == stop_floor || stop_floor == HARDWARE_STOP_FLOOR_NEXT;
+}
+
+/* Sample the inputs of a car, debounce them and queue what changed.
+ * Called by the sampler with the I/O layer pointed at the car. */
+static void hardware_sample_car(int index, long long now){
+    HardwareCar* car = &hardware_cars[index];
+
+    for(int word = 0; word < hardware_inputs.count; word++){
+        unsigned int raw = io_read_bitfield(hardware_inputs.subdevice[word], hardware_inputs.base_channel[word]) & hardware_input_mask[word];
+
+        // A two-bit vertical counter per input: it takes four differing samples in a row to change
+        unsigned int delta = raw ^ car->debounced[word];
+        car->count1[word] = (car->count1[word] ^ car->count0[word]) & delta;
+        car->count0[word] = ~car->count0[word] & delta;
+        car->debounced[word] ^= delta & ~(car->count0[word] | car->count1[word]);
+
+        unsigned int changed = car->debounced[word] ^ car->queued[word];
+        if(!changed){
+            continue;
+        }
+
+        unsigned int rose = changed & car->debounced[word];
+        int reflex = hardware_needs_reflex_stop(car, word, rose);
+
+        unsigned long long head = atomic_load_explicit(&car->edge_head, memory_order_relaxed);
+        unsigned long long tail = atomic_load_explicit(&car->edge_tail, memory_order_acquire);
+        if(head - tail < HARDWARE_EDGE_QUEUE){
+            car->edges[head & (HARDWARE_EDGE_QUEUE - 1)] = (HardwareEdge){ .time_ns = now, .word = word, .rose = rose, .fell = changed & ~rose };
+            atomic_store_explicit(&car->edge_head, head + 1, memory_order_release);
+            car->queued[word] = car->debounced[word];
+            car->stats.edges++;
+            if(io_record_is_open()){
+                io_record_word(IO_RECORD_INPUT_WORD, index, hardware_inputs.subdevice[word], hardware_inputs.base_channel[word], car->debounced[word]);
+            }
+        }
+        else{
+            // Queued with the next sample that finds room; the controller is far behind
+            car->stats.deferred++;
+        }
+
+        if(reflex && car->motor_written != 0){
+            io_write_analog(MOTOR, 0);
+            hardware_count_io_calls(car, 1);
+            car->motor_written = 0;
+            if(io_record_is_open()){
+                io_record_analog(index, MOTOR, 0);
+            }
+            car->stats.reflex_stops++;
+            atomic_fetch_add_explicit(&car->reflex_stops, 1, memory_order_release);
+        }
+    }
+    hardware_count_io_calls(car, hardware_inputs.count);
+    car->stats.samples++;
+}
+
+static void* hardware_sampler_thread(void* arg){
+    struct timespec next;
+    clock_gettime(CLOCK_MONOTONIC, &next);
+
+    while(!atomic_load(&hardware_sampler_stopping)){
+        next.tv_nsec += hardware_sampler_period_ns;
+        while(next.tv_nsec >= 1000000000L){
+            next.tv_nsec -= 1000000000L;
+            next.tv_sec++;
+        }
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+
+        long long now = hardware_now_ns();
+        pthread_mutex_lock(&hardware_io_mutex);
+        for(int car = 0; car < hardware_sampler_cars; car++){
+            io_select_car(car);
+            hardware_sample_car(car, now);
+        }
+        pthread_mutex_unlock(&hardware_io_mutex);
+    }
+    return NULL;
+}
+
+int hardware_start_sampler(int car_count, int rate_hz){
+    if(hardware_sampler_running || car_count < 1 || car_count > HARDWARE_MAX_CARS || rate_hz <= 0){
+        return 1;
+    }
+
+    // The sampler starts from what the controller last sampled, so nothing is queued for it
+    for(int index = 0; index < car_count; index++){
+        HardwareCar* car = &hardware_cars[index];
+        for(int word = 0; word < hardware_inputs.count; word++){
+            car->debounced[word] = car->input_sample[word] & hardware_input_mask[word];
+            car->queued[word] = car->debounced[word];
+            car->count0[word] = 0;
+            car->count1[word] = 0;
+            car->input_rose[word] = 0;
+        }
+        atomic_store(&car->edge_head, 0);
+        atomic_store(&car->edge_tail, 0);
+        atomic_store(&car->reflex_stops, 0);
+        car->reflex_stops_drained = 0;
+        car->stats = (HardwareSamplerStats){ 0 };
+    }
+
+    hardware_sampler_cars = car_count;
+    hardware_sampler_period_ns = 1000000000LL / rate_hz;
+    atomic_store(&hardware_sampler_stopping, 0);
+    hardware_sampler_running = 1;
+
+    // The thread blocks every signal, so they reach the control loop
+    sigset_t all;
+    sigset_t previous;
+    sigfillset(&all);
+    pthread_sigmask(SIG_SETMASK, &all, &previous);
+    int created = pthread_create(&hardware_sampler, NULL, hardware_sampler_thread, NULL);
+    pthread_sigmask(SIG_SETMASK, &previous, NULL);
+
+    if(created != 0){
+        hardware_sampler_running = 0;
+        return 1;
+    }
+    return 0;
+}
+
+void hardware_stop_sampler(){
+    if(!hardware_sampler_running){
+        return;
+    }
+    atomic_store(&hardware_sampler_stopping, 1);
+    pthread_join(hardware_sampler, NULL);
+    hardware_sampler_running = 0;
+
+    // The controller may have switched cars since it last took the I/O layer
+    io_select_car(hardware_car - hardware_cars);
+}
+
+HardwareSamplerStats hardware_get_sampler_stats(int car){
+    return hardware_cars[car].stats;
+}
+
+long long hardware_get_io_calls(int car){
+    return atomic_load_explicit(&hardware_cars[car].io_calls, memory_order_relaxed);
+}
+
+int hardware_get_motor_speed(){
+    if(hardware_car->motor_shadow == 0){
+        return 0;
+    }
+    return hardware_shadow_bit(MOTORDIR) ? -hardware_car->motor_shadow : hardware_car->motor_shadow;
+}
+
+int hardware_get_door_open(){
+    return hardware_shadow_bit(LIGHT_DOOR_OPEN);
+}
+
 void hardware_command_movement(HardwareMovement movement){
     switch(movement){
         case HARDWARE_MOVEMENT_UP:
-            io_clear_bit(MOTORDIR);
-            io_write_analog(MOTOR, 2800);
+            hardware_write_output_bit(MOTORDIR, 0);
+            hardware_car->motor_shadow = 2800;
             break;
 
         case HARDWARE_MOVEMENT_STOP:
-            io_write_analog(MOTOR, 0);
+            hardware_car->motor_shadow = 0;
             break;
 
         case HARDWARE_ORDER_DOWN:
-            io_set_bit(MOTORDIR);
-            io_write_analog(MOTOR, 2800);
+            hardware_write_output_bit(MOTORDIR, 1);
+            hardware_car->motor_shadow = 2800;
             break;
     }
 }
 
+void hardware_command_motor_speed(int speed){
+    if(hardware_car->motor_shadow != 0 && speed > 0){
+        hardware_car->motor_shadow = speed;
+    }
+}
+
 int hardware_read_stop_signal(){
-    return io_read_bit(STOP);
+    return hardware_sampled_bit(STOP);
 }
 
 int hardware_read_obstruction_signal(){
-    return io_read_bit(OBSTRUCTION);
+    return hardware_sampled_bit(OBSTRUCTION);
 }
 
 int hardware_read_floor_sensor(int floor){
-    int floor_bit;
-    switch(floor){
-        case 0:
-            floor_bit = SENSOR_FLOOR1;
-            break;
-
-        case 1:
-            floor_bit = SENSOR_FLOOR2;
-            break;
-
-        case 2:
-            floor_bit = SENSOR_FLOOR3;
-            break;
+    if(floor < 0 || floor >= HARDWARE_NUMBER_OF_FLOORS){
+        return 0;
+    }
 
-        case 3:
-            floor_bit = SENSOR_FLOOR4;
-            break;
+    return hardware_sampled_bit(hardware_sensor_channels[floor]);
+}
 
-        default:
-            return 0;
+int hardware_read_current_floor(){
+    for(int word = 0; word < hardware_inputs.count; word++){
+        unsigned int active = hardware_car->input_sample[word] & hardware_sensor_mask[word];
+        if(active){
+            return hardware_bit_floor[word][__builtin_ctz(active)];
+        }
     }
 
-    return io_read_bit(floor_bit);
+    return -1;
 }
 
 int hardware_read_order(int floor, HardwareOrder order_type){
@@ -124,50 +602,42 @@ int hardware_read_order(int floor, HardwareOrder order_type){
         return 0;
     }
 
-    static const int order_bit_lookup[][3] = {
-        {BUTTON_UP1, BUTTON_DOWN1, BUTTON_COMMAND1},
-        {BUTTON_UP2, BUTTON_DOWN2, BUTTON_COMMAND2},
-        {BUTTON_UP3, BUTTON_DOWN3, BUTTON_COMMAND3},
-        {BUTTON_UP4, BUTTON_DOWN4, BUTTON_COMMAND4}
-    };
-
     int type_bit = hardware_order_type_bit(order_type);
 
-    return io_read_bit(order_bit_lookup[floor][type_bit]);
+    return hardware_sampled_bit(hardware_order_channels[floor][type_bit]);
 }
 
-void hardware_command_door_open(int door_open){
-    if(door_open){
-        io_set_bit(LIGHT_DOOR_OPEN);
-    }
-    else{
-        io_clear_bit(LIGHT_DOOR_OPEN);
+int hardware_read_pressed_orders(int* floors, HardwareOrder* order_types, int max_orders){
+    int count = 0;
+
+    for(int word = 0; word < hardware_inputs.count; word++){
+        // Presses the sampler saw come and go since the last sample count as well
+        unsigned int pressed = (hardware_car->input_sample[word] | hardware_car->input_rose[word]) & hardware_order_mask[word];
+        while(pressed && count < max_orders){
+            int bit = __builtin_ctz(pressed);
+            floors[count] = hardware_bit_floor[word][bit];
+            order_types[count] = hardware_bit_order_type[word][bit];
+            count++;
+            pressed &= pressed - 1;
+        }
     }
+
+    return count;
 }
 
-void hardware_command_floor_indicator_on(int floor){
-    if(floor & 0x02){
-        io_set_bit(LIGHT_FLOOR_IND1);
-    }
-    else{
-        io_clear_bit(LIGHT_FLOOR_IND1);
-    }
+void hardware_command_door_open(int door_open){
+    hardware_write_output_bit(LIGHT_DOOR_OPEN, door_open);
+}
 
-    if(floor & 0x01){
-        io_set_bit(LIGHT_FLOOR_IND2);
-    }
-    else{
-        io_clear_bit(LIGHT_FLOOR_IND2);
+void hardware_command_floor_indicator_on(int floor){
+    for(int bit = 0; bit < BUILDING_FLOOR_INDICATOR_BITS; bit++){
+        int weight = BUILDING_FLOOR_INDICATOR_BITS - 1 - bit;
+        hardware_write_output_bit(hardware_indicator_channels[bit], (floor >> weight) & 1);
     }
 }
 
 void hardware_command_stop_light(int on){
-    if(on){
-        io_set_bit(LIGHT_STOP);
-    }
-    else{
-        io_clear_bit(LIGHT_STOP);
-    }
+    hardware_write_output_bit(LIGHT_STOP, on);
 }
 
 void hardware_command_order_light(int floor, HardwareOrder order_type, int on){
@@ -175,19 +645,7 @@ void hardware_command_order_light(int floor, HardwareOrder order_type, int on){
         return;
     }
 
-    static const int light_bit_lookup[][3] = {
-        {LIGHT_UP1, LIGHT_DOWN1, LIGHT_COMMAND1},
-        {LIGHT_UP2, LIGHT_DOWN2, LIGHT_COMMAND2},
-        {LIGHT_UP3, LIGHT_DOWN3, LIGHT_COMMAND3},
-        {LIGHT_UP4, LIGHT_DOWN4, LIGHT_COMMAND4}
-    };
-
     int type_bit = hardware_order_type_bit(order_type);
 
-    if(on){
-        io_set_bit(light_bit_lookup[floor][type_bit]);
-    }
-    else{
-        io_clear_bit(light_bit_lookup[floor][type_bit]);
-    }
+    hardware_write_output_bit(hardware_light_channels[floor][type_bit], on);
 }
@@ -9,7 +9,9 @@
  */
 #ifndef HARDWARE_H
 #define HARDWARE_H
-#define HARDWARE_NUMBER_OF_FLOORS 4
+
+// Floor count and channel tables, generated from the building description
+#include "building.h"
 
 /**
  * @brief Movement type used in @c hardware_command_movement.
@@ -32,14 +34,148 @@ typedef enum {
 } HardwareOrder;
 
 /**
- * @brief Initializes the elevator control hardware.
- * Must be called once before other calls to the elevator
- * hardware driver.
+ * @brief Most cars a bank can have. Only the simulated
+ * driver has more than one.
+ */
+#define HARDWARE_MAX_CARS 16
+
+/**
+ * @brief Debounced input changes the sampler can queue for a
+ * car before the controller drains them. A power of two.
+ */
+#define HARDWARE_EDGE_QUEUE 256
+
+/**
+ * @brief Values of @c hardware_set_stop_floor that are not a floor.
+ */
+#define HARDWARE_STOP_FLOOR_NONE -1     /**< Only stop at the end floors */
+#define HARDWARE_STOP_FLOOR_NEXT -2     /**< Stop at the next floor reached */
+
+/**
+ * @brief Counters of the sampler for one car, see
+ * @c hardware_start_sampler.
+ */
+typedef struct {
+    long long samples;          /**< Samples taken */
+    long long edges;            /**< Debounced changes queued, one per changed word */
+    long long deferred;         /**< Samples whose changes waited for room in the queue */
+    long long reflex_stops;     /**< Motor stops made by the sampler */
+    long long drained;          /**< Changes applied by the controller */
+    long long edge_age_sum_ns;  /**< Sum of the times from sample to controller */
+    long long edge_age_max_ns;  /**< Longest time from sample to controller */
+} HardwareSamplerStats;
+
+/**
+ * @brief Initializes the elevator control hardware of the
+ * selected car. Must be called once for every car before
+ * other calls to the elevator hardware driver.
  *
  * @return 0 on success. Non-zero for failure.
  */
 int hardware_init();
 
+/**
+ * @brief Directs the other hardware_* calls at car @p car of
+ * the bank, until it is called again. Every car has its own
+ * input sample and output shadow. Car 0 is selected at start.
+ *
+ * @param car The car to select, from 0.
+ *
+ * @return 0 on success. Non-zero if the driver has no such car.
+ */
+int hardware_select_car(int car);
+
+/**
+ * @brief Samples every digital input of the elevator in one go.
+ * The stop, obstruction, floor sensor and order readers below
+ * answer from the latest sample, so this should be called once
+ * at the start of every control cycle.
+ *
+ * While the sampler runs, the ports are not read; the debounced
+ * changes the sampler queued are applied instead, so a button
+ * pressed and released between two calls is still reported by
+ * @c hardware_read_pressed_orders.
+ */
+void hardware_sample_inputs();
+
+/**
+ * @brief Starts a thread that samples the inputs of cars 0 to
+ * @p car_count - 1 at @p rate_hz, independently of the control
+ * cycle. An input only changes after four samples in a row
+ * disagree with it, and every change is queued, timestamped,
+ * for @c hardware_sample_inputs without locks.
+ *
+ * The thread also stops the motor itself when the stop button
+ * is pressed, or when the car reaches an end floor or the
+ * floor given to @c hardware_set_stop_floor, so that the time
+ * from the edge to the motor is bounded by five sample periods
+ * however long a control cycle takes. The motor is then not
+ * restarted until the controller has seen the edge. The I/O
+ * layer is shared under a mutex while the thread runs.
+ *
+ * Call after @c hardware_init for every car.
+ *
+ * @param car_count Number of cars to sample.
+ * @param rate_hz Samples per second.
+ *
+ * @return 0 on success. Non-zero if the thread was not started.
+ */
+int hardware_start_sampler(int car_count, int rate_hz);
+
+/**
+ * @brief Stops the sampler thread. The inputs are sampled by
+ * @c hardware_sample_inputs again afterwards.
+ */
+void hardware_stop_sampler();
+
+/**
+ * @brief Tells the sampler where the selected car will stop,
+ * so it can stop the motor on arrival. Ignored when the sampler
+ * does not run.
+ *
+ * @param floor The floor, @c HARDWARE_STOP_FLOOR_NEXT or
+ * @c HARDWARE_STOP_FLOOR_NONE.
+ */
+void hardware_set_stop_floor(int floor);
+
+/**
+ * @brief Reads the counters of the sampler for car @p car.
+ * Only consistent once the sampler has been stopped.
+ */
+HardwareSamplerStats hardware_get_sampler_stats(int car);
+
+/**
+ * @brief Number of io_* calls made for car @p car, by the
+ * controller and by the sampler. May be read while the sampler
+ * runs.
+ */
+long long hardware_get_io_calls(int car);
+
+/**
+ * @brief The drive the selected car's motor is commanded, as
+ * it will be written by the next @c hardware_flush_outputs.
+ *
+ * @return The drive, negative downwards, or 0 if the motor is
+ * commanded to stop.
+ */
+int hardware_get_motor_speed();
+
+/**
+ * @brief Whether the selected car's door is commanded open.
+ *
+ * @return 1 if the door is commanded open; 0 if closed.
+ */
+int hardware_get_door_open();
+
+/**
+ * @brief Writes every output that changed since the last flush
+ * to the hardware. The @c hardware_command_* functions only
+ * update a shadow copy of the outputs; nothing reaches the
+ * elevator until this is called, so it should be called once
+ * at the end of every control cycle.
+ */
+void hardware_flush_outputs();
+
 /**
  * @brief Commands the elevator to either move up or down,
  * or commands it to halt.
@@ -49,21 +185,32 @@ int hardware_init();
 void hardware_command_movement(HardwareMovement movement);
 
 /**
- * @brief Polls the hardware for the current stop signal.
+ * @brief Sets the drive of a running motor, leaving its
+ * direction as it is. A stopped motor stays stopped, so
+ * start it with @c hardware_command_movement first.
+ *
+ * @param speed Value written to the motor's DAC; the
+ * lab rig's fixed speed is 2800.
+ */
+void hardware_command_motor_speed(int speed);
+
+/**
+ * @brief Reads the stop signal from the latest input sample.
  *
  * @return 1 if the stop signal is high; 0 if it is low.
  */
 int hardware_read_stop_signal();
 
 /**
- * @brief Polls the hardware for the current obstruction signal.
+ * @brief Reads the obstruction signal from the latest input sample.
  *
  * @return 1 if the obstruction signal is high; 0 if it is low.
  */
 int hardware_read_obstruction_signal();
 
 /**
- * @brief Polls the floor sensor for the given @p floor.
+ * @brief Reads the floor sensor for the given @p floor
+ * from the latest input sample.
  *
  * @param floor Inquired floor.
  *
@@ -72,8 +219,18 @@ int hardware_read_obstruction_signal();
 int hardware_read_floor_sensor(int floor);
 
 /**
- * @brief Polls the hardware for the status of orders from
- * floor @p floor of type @p order_type.
+ * @brief Finds the floor whose sensor is active in the latest
+ * input sample. Only the sampled words are scanned, not every
+ * floor, so this stays cheap in tall buildings.
+ *
+ * @return The floor the elevator is at, or -1 if it is
+ * between floors.
+ */
+int hardware_read_current_floor();
+
+/**
+ * @brief Reads the status of orders from floor @p floor of
+ * type @p order_type from the latest input sample.
  *
  * @param floor Inquired floor.
  * @param order_type
@@ -83,6 +240,20 @@ int hardware_read_floor_sensor(int floor);
  */
 int hardware_read_order(int floor, HardwareOrder order_type);
 
+/**
+ * @brief Lists the orders that are being requested in the latest
+ * input sample. Like @c hardware_read_current_floor, the cost
+ * follows the number of sampled words and pressed buttons rather
+ * than the number of floors.
+ *
+ * @param floors Filled with the floor of each pressed button.
+ * @param order_types Filled with the type of each pressed button.
+ * @param max_orders Capacity of @p floors and @p order_types.
+ *
+ * @return Number of pressed buttons written, at most @p max_orders.
+ */
+int hardware_read_pressed_orders(int* floors, HardwareOrder* order_types, int max_orders);
+
 /**
  * @brief Commands the hardware to open- or close the elevator door.
  *
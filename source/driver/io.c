@@ -7,6 +7,11 @@
 
 #include "io.h"
 #include "channels.h"
+#include "building.h"
+
+#if BUILDING_SIMULATED_ONLY
+#error "This building only exists in the simulator; build it with 'make sim'"
+#endif
 
 #include <comedilib.h>
 
@@ -36,6 +41,12 @@ int io_init() {
 
 
 
+int io_select_car(int car) {
+    return (car == 0);
+}
+
+
+
 void io_set_bit(int channel) {
     comedi_dio_write(it_g, channel >> 8, channel & 0xff, 1);
 }
@@ -48,6 +59,12 @@ void io_clear_bit(int channel) {
 
 
 
+void io_write_bitfield(int subdevice, unsigned int write_mask, unsigned int bits, int base_channel) {
+    comedi_dio_bitfield2(it_g, subdevice, write_mask, &bits, base_channel);
+}
+
+
+
 void io_write_analog(int channel, int value) {
     comedi_data_write(it_g, channel >> 8, channel & 0xff, 0, AREF_GROUND, value);
 }
@@ -63,9 +80,29 @@ int io_read_bit(int channel) {
 
 
 
+unsigned int io_read_bitfield(int subdevice, int base_channel) {
+    unsigned int bits = 0;
+    comedi_dio_bitfield2(it_g, subdevice, 0, &bits, base_channel);
+
+    return bits;
+}
+
+
+
 int io_read_analog(int channel) {
     lsampl_t data = 0;
     comedi_data_read(it_g, channel >> 8, channel & 0xff, 0, AREF_GROUND, &data);
 
     return (int)data;
 }
+
+
+
+void io_flush() {
+}
+
+
+
+int io_get_stats(IoStats *stats) {
+    return 0;
+}
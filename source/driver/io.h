@@ -16,6 +16,16 @@ int io_init();
 
 
 
+/**
+  Directs the other io_* calls at one car of a bank. The lab
+  rig is a single car, number 0.
+  @param car Car to select, from 0.
+  @return Non-zero on success and 0 if there is no such car.
+*/
+int io_select_car(int car);
+
+
+
 /**
   Sets a digital channel bit.
   @param channel Channel bit to set.
@@ -32,6 +42,17 @@ void io_clear_bit(int channel);
 
 
 
+/**
+  Writes several digital channels of a subdevice in a single call.
+  @param subdevice Subdevice to write to (one of the PORTx values).
+  @param write_mask Bit n set means channel base_channel + n is written.
+  @param bits Bit n holds the new value of channel base_channel + n.
+  @param base_channel Channel that corresponds to bit 0 of the masks.
+*/
+void io_write_bitfield(int subdevice, unsigned int write_mask, unsigned int bits, int base_channel);
+
+
+
 /**
   Writes a value to an analog channel.
   @param channel Channel to write to.
@@ -51,6 +72,17 @@ int io_read_bit(int channel);
 
 
 
+/**
+  Reads every digital channel of a subdevice in a single call.
+  @param subdevice Subdevice to read from (one of the PORTx values).
+  @param base_channel Channel that ends up in bit 0 of the result.
+  @return Bit n holds the value of channel base_channel + n.
+*/
+unsigned int io_read_bitfield(int subdevice, int base_channel);
+
+
+
+
 /**
   Reads a bit value from an analog channel.
   @param channel Channel to read from.
@@ -58,5 +90,37 @@ int io_read_bit(int channel);
 */
 int io_read_analog(int channel);
 
+
+
+/**
+  Sends the writes a backend has held back, at the end of a flush of
+  the outputs. Backends that write at once do nothing.
+*/
+void io_flush();
+
+
+
+/**
+  Counts of a backend that batches its I/O into round trips to
+  another process.
+*/
+typedef struct {
+    long long calls;            // io_* calls to read or write a channel
+    long long round_trips;      // Requests that were answered
+    long long write_batches;    // Requests of writes only, which are not answered
+    long long writes;           // Writes sent, after merging those of the same word
+    long long round_trip_sum_ns;
+    long long round_trip_max_ns;
+} IoStats;
+
+
+
+/**
+  Reads the counts of the backend.
+  @param stats Filled in with the counts.
+  @return Non-zero if the backend batches its I/O, and 0 otherwise.
+*/
+int io_get_stats(IoStats *stats);
+
 #endif // #ifndef __INCLUDE_IO_H__
 
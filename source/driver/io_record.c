@@ -0,0 +1,167 @@
+// Recording of the io_* traffic seen by hardware.c, as described in io_record.h.
+// Records are delta-encoded varints written straight into a shared mapping of the file.
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "io_record.h"
+#include "hardware.h"
+
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+
+#define IO_RECORD_WORDS_PER_SUBDEVICE 8     // 256 channels in words of 32
+
+
+static int fd_g = -1;
+static unsigned char *map_g = NULL;
+static size_t map_bytes_g = 0;
+static size_t used_g = 0;                   // Bytes of the mapping in use, header included
+
+static long long (*clock_g)() = NULL;
+static long long last_us_g = 0;
+
+// The last recorded value of every word, so only the changed bits are written
+static unsigned int last_word_g[2][HARDWARE_MAX_CARS][BUILDING_SUBDEVICES][IO_RECORD_WORDS_PER_SUBDEVICE];
+
+
+
+static long long io_record_now_ns() {
+    if (clock_g != NULL)
+        return clock_g();
+
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+
+
+static io_record_header_t *io_record_header() {
+    return (io_record_header_t *)map_g;
+}
+
+
+
+// Extends the file by a chunk and maps it again; the only system calls made while recording
+static int io_record_grow() {
+    size_t bytes = map_bytes_g + IO_RECORD_CHUNK_BYTES;
+    if (ftruncate(fd_g, bytes) != 0)
+        return -1;
+
+    void *map = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd_g, 0);
+    if (map == MAP_FAILED)
+        return -1;
+
+    if (map_g != NULL)
+        munmap(map_g, map_bytes_g);
+    map_g = map;
+    map_bytes_g = bytes;
+    return 0;
+}
+
+
+
+static void io_record_put_varint(unsigned long long value) {
+    while (value >= 0x80) {
+        map_g[used_g++] = (unsigned char)(value | 0x80);
+        value >>= 7;
+    }
+    map_g[used_g++] = (unsigned char)value;
+}
+
+
+
+static void io_record_put(io_record_kind_t kind, int car, int channel, unsigned long long value) {
+    if (used_g + IO_RECORD_MAX_BYTES > map_bytes_g && io_record_grow() != 0) {
+        io_record_close();
+        return;
+    }
+
+    // Times are kept in whole microseconds since the start, so rounding never accumulates
+    long long now_us = (io_record_now_ns() - io_record_header()->start_ns) / 1000;
+    long long delta_us = (now_us > last_us_g) ? now_us - last_us_g : 0;
+    last_us_g += delta_us;
+
+    io_record_put_varint(((unsigned long long)delta_us << 2) | kind);
+    map_g[used_g++] = (unsigned char)car;
+    io_record_put_varint((unsigned int)channel);
+    io_record_put_varint(value);
+
+    io_record_header()->length = used_g - sizeof(io_record_header_t);
+}
+
+
+
+int io_record_open(const char *path, int rate_hz, int cars) {
+    if (fd_g >= 0)
+        return -1;
+
+    fd_g = open(path, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd_g < 0)
+        return -1;
+
+    if (io_record_grow() != 0) {
+        close(fd_g);
+        fd_g = -1;
+        return -1;
+    }
+
+    io_record_header_t header = { .magic = IO_RECORD_MAGIC, .version = IO_RECORD_VERSION,
+                                  .rate_hz = rate_hz, .cars = cars, .start_ns = io_record_now_ns() };
+    memcpy(map_g, &header, sizeof(header));
+    used_g = sizeof(header);
+    last_us_g = 0;
+    memset(last_word_g, 0, sizeof(last_word_g));
+    return 0;
+}
+
+
+
+int io_record_is_open() {
+    return fd_g >= 0;
+}
+
+
+
+void io_record_word(io_record_kind_t kind, int car, int subdevice, int base_channel, unsigned int value) {
+    unsigned int *last = &last_word_g[kind == IO_RECORD_OUTPUT_WORD][car][subdevice][base_channel >> 5];
+    unsigned int changed = value ^ *last;
+    if (fd_g < 0 || changed == 0)
+        return;
+
+    *last = value;
+    io_record_put(kind, car, (subdevice << 8) | base_channel, changed);
+}
+
+
+
+void io_record_analog(int car, int channel, int value) {
+    if (fd_g >= 0)
+        io_record_put(IO_RECORD_OUTPUT_ANALOG, car, channel, (unsigned int)value);
+}
+
+
+
+void io_record_set_clock(long long (*clock_ns)()) {
+    clock_g = clock_ns;
+}
+
+
+
+void io_record_close() {
+    if (fd_g < 0)
+        return;
+
+    munmap(map_g, map_bytes_g);
+    if (ftruncate(fd_g, used_g) != 0) {
+        // The header holds the length, so a recording that could not be cut is still readable
+    }
+    close(fd_g);
+    fd_g = -1;
+    map_g = NULL;
+    map_bytes_g = 0;
+}
@@ -0,0 +1,114 @@
+/**
+ * @file
+ * @brief Capture of the controller's hardware I/O to a compact file, for replay off-site.
+ *
+ * hardware.c reports every input word it samples and every output it writes to the
+ * @c io_* functions, for every car. Only changes are stored, as records of variable-length
+ * integers:
+ *
+ *     varint  (microseconds since the previous record << 2) | io_record_kind_t
+ *     byte    car
+ *     varint  channel: subdevice << 8 | base channel for words, the channel itself for analog
+ *     varint  the bits that changed for words, and the value written for analog
+ *
+ * A floor sensor or button edge takes 5 to 9 bytes, so a day of traffic fits in a few megabytes.
+ *
+ * The file is mapped into memory and grown in steps of @c IO_RECORD_CHUNK_BYTES , so a record
+ * costs a few stores and the control loop only makes a system call once per step. The header's
+ * length is updated after every record, so the recording survives a crash of the controller.
+ *
+ * Feed a recording back into the controller with elevator_replay, see replay.h .
+ */
+#ifndef IO_RECORD_H
+#define IO_RECORD_H
+
+#include <stdint.h>
+
+
+#define IO_RECORD_MAGIC "ELVIORC"               /**< First bytes of every recording, with its terminating zero */
+#define IO_RECORD_VERSION 1                     /**< Version of the record layout */
+#define IO_RECORD_CHUNK_BYTES (1 << 20)         /**< Step the file is grown in */
+#define IO_RECORD_MAX_BYTES 24                  /**< Longest encoded record */
+
+
+/**
+ * Enum for what a record describes
+ */
+typedef enum{
+    IO_RECORD_INPUT_WORD,       /**< A digital input word as sampled*/
+    IO_RECORD_OUTPUT_WORD,      /**< The digital output bits of a word as written*/
+    IO_RECORD_OUTPUT_ANALOG     /**< An analog output as written*/
+} io_record_kind_t;
+
+
+/**
+ * The header of a recording
+ */
+typedef struct{
+    char magic[8];              /**< @c IO_RECORD_MAGIC*/
+    uint32_t version;           /**< @c IO_RECORD_VERSION*/
+    uint32_t rate_hz;           /**< Control rate of the recorded controller*/
+    uint32_t cars;              /**< Number of cars of the recorded controller*/
+    uint32_t reserved;          /**< Zero*/
+    int64_t start_ns;           /**< Clock time the record times count from*/
+    uint64_t length;            /**< Bytes of records following the header*/
+} io_record_header_t;
+
+
+/**
+ * @brief Start recording to @p path , replacing the file
+ *
+ * @param[in] path      The recording
+ * @param[in] rate_hz   Control rate, kept in the header for the replay
+ * @param[in] cars      Number of cars, kept in the header for the replay
+ *
+ * @return 0 on success, and -1 if the file could not be created or mapped
+ */
+int io_record_open(const char* path, int rate_hz, int cars);
+
+
+/**
+ * @brief Check if a recording is open, so the caller can skip reporting
+ *
+ * @return 1 if a recording is open, and 0 if not
+ */
+int io_record_is_open();
+
+
+/**
+ * @brief Record the value of a digital word if it differs from the last one recorded
+ *
+ * @param[in] kind          @c IO_RECORD_INPUT_WORD or @c IO_RECORD_OUTPUT_WORD
+ * @param[in] car           The car the word belongs to
+ * @param[in] subdevice     Subdevice of the word
+ * @param[in] base_channel  Channel of bit 0 of the word, a multiple of 32
+ * @param[in] value         The word
+ */
+void io_record_word(io_record_kind_t kind, int car, int subdevice, int base_channel, unsigned int value);
+
+
+/**
+ * @brief Record a value written to an analog output
+ *
+ * @param[in] car       The car the output belongs to
+ * @param[in] channel   The analog channel
+ * @param[in] value     The value, from 0
+ */
+void io_record_analog(int car, int channel, int value);
+
+
+/**
+ * @brief Replace the clock records are timed by
+ *
+ * @param[in] clock_ns  Function returning the current time in nanoseconds, or NULL for @c CLOCK_MONOTONIC
+ */
+void io_record_set_clock(long long (*clock_ns)());
+
+
+/**
+ * @brief Cut the file to the recorded length and close it
+ */
+void io_record_close();
+
+
+#endif //IO_RECORD_H
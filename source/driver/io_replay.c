@@ -0,0 +1,297 @@
+// Replay replacement for the libComedi wrapper in io.c.
+// Implements the io_* interface from a recording made with io_record.h: reads return the
+// inputs as recorded, on a virtual clock moved by replay_advance_to(). Every car has its
+// own copy of every channel, as in io_sim.c.
+// Link with this file instead of io.c, and without -lcomedi.
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "io.h"
+#include "io_record.h"
+#include "replay.h"
+#include "hardware.h"
+
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+#define REPLAY_WORDS_PER_SUBDEVICE 8    // 256 channels in words of 32
+#define REPLAY_STARTUP_NS 1000000LL     // Inputs recorded this soon after the first are from the start of the controller
+
+
+typedef struct {
+    unsigned int inputs[BUILDING_SUBDEVICES][REPLAY_WORDS_PER_SUBDEVICE];
+    unsigned int outputs[BUILDING_SUBDEVICES][REPLAY_WORDS_PER_SUBDEVICE];
+    int motor;
+} ReplayCar;
+
+// A decoded record, read one ahead of the clock
+typedef struct {
+    long long time_ns;
+    io_record_kind_t kind;
+    int car;
+    int channel;
+    unsigned long long value;
+} ReplayRecord;
+
+
+static ReplayCar cars_g[HARDWARE_MAX_CARS];
+static ReplayCar *car_g = &cars_g[0];
+
+static const unsigned char *map_g = NULL;
+static size_t map_bytes_g = 0;
+static const io_record_header_t *header_g = NULL;
+
+static size_t cursor_g = 0;
+static long long cursor_us_g = 0;
+static ReplayRecord next_g;
+static int next_valid_g = 0;
+static long long end_ns_g = 0;
+static long long records_g = 0;
+
+static long long now_g = 0;
+
+
+
+static int replay_get_varint(size_t *p_cursor, unsigned long long *p_value) {
+    const unsigned char *records = map_g + sizeof(io_record_header_t);
+    unsigned long long value = 0;
+
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (*p_cursor >= header_g->length)
+            return -1;
+        unsigned char byte = records[(*p_cursor)++];
+        value |= (unsigned long long)(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            *p_value = value;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+
+
+// Decodes the record at the cursor; a truncated or corrupt tail ends the recording
+static int replay_decode(size_t *p_cursor, long long *p_time_us, ReplayRecord *p_record) {
+    unsigned long long tag, channel, value;
+    if (replay_get_varint(p_cursor, &tag) != 0 || *p_cursor >= header_g->length)
+        return -1;
+
+    int car = map_g[sizeof(io_record_header_t) + (*p_cursor)++];
+    if (replay_get_varint(p_cursor, &channel) != 0 || replay_get_varint(p_cursor, &value) != 0)
+        return -1;
+    if (car >= HARDWARE_MAX_CARS || (channel >> 8) >= BUILDING_SUBDEVICES)
+        return -1;
+
+    *p_time_us += (long long)(tag >> 2);
+    p_record->time_ns = *p_time_us * 1000;
+    p_record->kind = (io_record_kind_t)(tag & 3);
+    p_record->car = car;
+    p_record->channel = (int)channel;
+    p_record->value = value;
+    return 0;
+}
+
+
+
+static void replay_read_next() {
+    next_valid_g = (replay_decode(&cursor_g, &cursor_us_g, &next_g) == 0);
+}
+
+
+
+static void replay_apply_to(long long ns) {
+    if (ns > now_g)
+        now_g = ns;
+
+    while (next_valid_g && next_g.time_ns <= ns) {
+        if (next_g.kind == IO_RECORD_INPUT_WORD)
+            cars_g[next_g.car].inputs[next_g.channel >> 8][(next_g.channel & 0xff) >> 5] ^= (unsigned int)next_g.value;
+        records_g++;
+        replay_read_next();
+    }
+}
+
+
+
+int replay_open(const char *path) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return -1;
+
+    struct stat st;
+    void *map = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && (size_t)st.st_size >= sizeof(io_record_header_t))
+        map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED)
+        return -1;
+
+    const io_record_header_t *header = map;
+    if (memcmp(header->magic, IO_RECORD_MAGIC, sizeof(IO_RECORD_MAGIC)) != 0 || header->version != IO_RECORD_VERSION
+        || header->length > st.st_size - sizeof(io_record_header_t)) {
+        munmap(map, st.st_size);
+        return -1;
+    }
+
+    replay_close();
+    map_g = map;
+    map_bytes_g = st.st_size;
+    header_g = header;
+
+    // The end is found up front, so a run knows how long it is
+    size_t cursor = 0;
+    long long time_us = 0;
+    ReplayRecord record;
+    while (replay_decode(&cursor, &time_us, &record) == 0)
+        end_ns_g = record.time_ns;
+
+    memset(cars_g, 0, sizeof(cars_g));
+    car_g = &cars_g[0];
+    cursor_g = 0;
+    cursor_us_g = 0;
+    records_g = 0;
+    now_g = 0;
+    replay_read_next();
+
+    // The controller starts from the inputs its first samples saw, with the clock at the start
+    if (replay_next_input_ns() >= 0)
+        replay_apply_to(replay_next_input_ns() + REPLAY_STARTUP_NS);
+    now_g = 0;
+    return 0;
+}
+
+
+
+int replay_rate_hz() {
+    return header_g ? (int)header_g->rate_hz : 0;
+}
+
+
+
+int replay_cars() {
+    return header_g ? (int)header_g->cars : 0;
+}
+
+
+
+long long replay_now_ns() {
+    return now_g;
+}
+
+
+
+long long replay_next_input_ns() {
+    // Output records say nothing the controller reads, so they are passed over here
+    while (next_valid_g && next_g.kind != IO_RECORD_INPUT_WORD) {
+        records_g++;
+        replay_read_next();
+    }
+    return next_valid_g ? next_g.time_ns : -1;
+}
+
+
+
+long long replay_end_ns() {
+    return end_ns_g;
+}
+
+
+
+void replay_advance_to(long long ns) {
+    replay_apply_to(ns);
+}
+
+
+
+long long replay_records() {
+    return records_g;
+}
+
+
+
+void replay_close() {
+    if (map_g != NULL)
+        munmap((void *)map_g, map_bytes_g);
+    map_g = NULL;
+    header_g = NULL;
+    next_valid_g = 0;
+    end_ns_g = 0;
+}
+
+
+
+int io_init() {
+    // The inputs belong to the recording, so only what the controller wrote is forgotten
+    memset(car_g->outputs, 0, sizeof(car_g->outputs));
+    car_g->motor = 0;
+    return header_g != NULL;
+}
+
+
+
+int io_select_car(int car) {
+    if (car < 0 || car >= HARDWARE_MAX_CARS)
+        return 0;
+    car_g = &cars_g[car];
+    return 1;
+}
+
+
+
+void io_set_bit(int channel) {
+    car_g->outputs[channel >> 8][(channel & 0xff) >> 5] |= 1u << (channel & 0x1f);
+}
+
+
+
+void io_clear_bit(int channel) {
+    car_g->outputs[channel >> 8][(channel & 0xff) >> 5] &= ~(1u << (channel & 0x1f));
+}
+
+
+
+void io_write_bitfield(int subdevice, unsigned int write_mask, unsigned int bits, int base_channel) {
+    unsigned int *word = &car_g->outputs[subdevice][base_channel >> 5];
+    int shift = base_channel & 0x1f;
+    *word = (*word & ~(write_mask << shift)) | ((bits & write_mask) << shift);
+}
+
+
+
+void io_write_analog(int channel, int value) {
+    car_g->motor = value;
+}
+
+
+
+int io_read_bit(int channel) {
+    return (car_g->inputs[channel >> 8][(channel & 0xff) >> 5] >> (channel & 0x1f)) & 1;
+}
+
+
+
+unsigned int io_read_bitfield(int subdevice, int base_channel) {
+    return car_g->inputs[subdevice][base_channel >> 5] >> (base_channel & 0x1f);
+}
+
+
+
+int io_read_analog(int channel) {
+    return car_g->motor;
+}
+
+
+
+void io_flush() {
+}
+
+
+
+int io_get_stats(IoStats *stats) {
+    return 0;
+}
@@ -0,0 +1,469 @@
+// Simulated replacement for the libComedi wrapper in io.c.
+// Implements the io_* interface against an in-process physics model of a
+// bank of elevator cars, so the controller can run on machines without the
+// lab rig. Every car has its own shaft and its own copy of every channel.
+// Link with this file instead of io.c, and without -lcomedi.
+// The shaft and its channels follow the generated building.h, so the same
+// model serves the lab rig and the simulated-only tall buildings.
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "io.h"
+#include "channels.h"
+#include "sim.h"
+
+#include <math.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+
+#define SIM_WORDS_PER_SUBDEVICE 8       // 256 channels in words of 32
+#define SIM_MOTOR_FULL_SCALE    2800.0  // DAC value giving SIM_SPEED_AT_FULL_SCALE
+#define SIM_SPEED_AT_FULL_SCALE 0.4     // Floors per second
+#define SIM_ACCELERATION        4.0     // Floors per second squared
+#define SIM_SENSOR_HALF_WIDTH   0.05    // Floors; a sensor is active within this distance of its floor
+#define SIM_SHAFT_MARGIN        0.3     // Floors of shaft beyond the top and bottom sensors
+#define SIM_STEP_NS             1000000LL
+#define SIM_CONSOLE_POLL_NS     50000000LL
+
+
+typedef struct {
+    unsigned int dio[BUILDING_SUBDEVICES][SIM_WORDS_PER_SUBDEVICE];
+    int motor;
+
+    double position;
+    double velocity;
+
+    int active_sensor;
+
+    double distance;
+    long long motor_starts;
+
+    // Pressed buttons waiting to be released, so releasing does not scan every floor
+    long long release_at[HARDWARE_NUMBER_OF_FLOORS][3];
+    int held[HARDWARE_NUMBER_OF_FLOORS * 3];
+    int held_count;
+} SimCar;
+
+
+static SimCar cars_g[HARDWARE_MAX_CARS];
+static SimCar *car_g = &cars_g[0];
+static int car_count_g = 1;     // Cars that have been selected, and so are integrated
+
+static int virtual_clock_g = 0;
+static long long now_g = 0;
+static long long epoch_g = 0;
+
+static int console_open_g = 1;
+static long long console_polled_g = 0;
+
+
+static const int sim_order_bits[HARDWARE_NUMBER_OF_FLOORS][3] = BUILDING_ORDER_CHANNELS;
+static const int sim_light_bits[HARDWARE_NUMBER_OF_FLOORS][3] = BUILDING_LIGHT_CHANNELS;
+static const int sim_sensor_bits[HARDWARE_NUMBER_OF_FLOORS] = BUILDING_SENSOR_CHANNELS;
+
+
+
+static long long sim_monotonic_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+
+
+static int sim_type_index(HardwareOrder order_type) {
+    switch (order_type) {
+    case HARDWARE_ORDER_UP:
+        return 0;
+    case HARDWARE_ORDER_DOWN:
+        return 1;
+    case HARDWARE_ORDER_INSIDE:
+        return 2;
+    default:
+        return -1;
+    }
+}
+
+
+
+static int sim_get_bit(int channel) {
+    if (channel < 0)
+        return 0;
+    return (car_g->dio[channel >> 8][(channel & 0xff) >> 5] >> (channel & 0x1f)) & 1;
+}
+
+
+
+static void sim_put_bit(int channel, int value) {
+    if (channel < 0)
+        return;
+    unsigned int *word = &car_g->dio[channel >> 8][(channel & 0xff) >> 5];
+    if (value)
+        *word |= 1u << (channel & 0x1f);
+    else
+        *word &= ~(1u << (channel & 0x1f));
+}
+
+
+
+// Only the sensor of the nearest floor can be active, so only that one is checked
+static void sim_update_sensors() {
+    int nearest = (int)lround(car_g->position);
+    int active = -1;
+    if (nearest >= 0 && nearest < HARDWARE_NUMBER_OF_FLOORS
+        && fabs(car_g->position - nearest) <= SIM_SENSOR_HALF_WIDTH)
+        active = nearest;
+
+    if (active != car_g->active_sensor) {
+        if (car_g->active_sensor >= 0)
+            sim_put_bit(sim_sensor_bits[car_g->active_sensor], 0);
+        if (active >= 0)
+            sim_put_bit(sim_sensor_bits[active], 1);
+        car_g->active_sensor = active;
+    }
+}
+
+
+
+static void sim_step(double dt) {
+    double target = SIM_SPEED_AT_FULL_SCALE * car_g->motor / SIM_MOTOR_FULL_SCALE;
+    if (sim_get_bit(MOTORDIR))
+        target = -target;
+
+    double max_dv = SIM_ACCELERATION * dt;
+    if (target > car_g->velocity + max_dv)
+        car_g->velocity += max_dv;
+    else if (target < car_g->velocity - max_dv)
+        car_g->velocity -= max_dv;
+    else
+        car_g->velocity = target;
+
+    car_g->position += car_g->velocity * dt;
+    car_g->distance += fabs(car_g->velocity * dt);
+
+    double bottom = -SIM_SHAFT_MARGIN;
+    double top = HARDWARE_NUMBER_OF_FLOORS - 1 + SIM_SHAFT_MARGIN;
+    if (car_g->position < bottom || car_g->position > top) {
+        car_g->position = car_g->position < bottom ? bottom : top;
+        car_g->velocity = 0.0;
+    }
+}
+
+
+
+static void sim_release_buttons() {
+    for (int i = 0; i < car_g->held_count;) {
+        int floor = car_g->held[i] / 3;
+        int type = car_g->held[i] % 3;
+        if (car_g->release_at[floor][type] > now_g) {
+            i++;
+            continue;
+        }
+        if (car_g->release_at[floor][type])
+            sim_put_bit(sim_order_bits[floor][type], 0);
+        car_g->release_at[floor][type] = 0;
+        car_g->held[i] = car_g->held[--car_g->held_count];
+    }
+}
+
+
+
+static void sim_integrate_to(long long target_ns) {
+    SimCar *selected = car_g;
+    long long start_ns = now_g;
+    if (target_ns > now_g)
+        now_g = target_ns;
+
+    for (int car = 0; car < car_count_g; car++) {
+        car_g = &cars_g[car];
+        for (long long t = start_ns; t < target_ns;) {
+            long long step = target_ns - t;
+            if (step > SIM_STEP_NS)
+                step = SIM_STEP_NS;
+            sim_step(step * 1e-9);
+            t += step;
+        }
+        sim_update_sensors();
+        sim_release_buttons();
+    }
+    car_g = selected;
+}
+
+
+
+// Reads one-line commands from stdin without blocking, so a headless
+// controller can be driven by hand or from a script:
+//   u <floor>  d <floor>  c <floor>   press up / down / cab button
+//   s          o                      toggle stop / obstruction
+//   p                                 print plant state
+// Commands act on car 0, which also carries the hall buttons of a bank.
+static void sim_poll_console() {
+    if (!console_open_g || now_g - console_polled_g < SIM_CONSOLE_POLL_NS)
+        return;
+    console_polled_g = now_g;
+
+    struct pollfd pfd = { .fd = STDIN_FILENO, .events = POLLIN };
+    if (poll(&pfd, 1, 0) <= 0)
+        return;
+
+    char line[64];
+    ssize_t n = read(STDIN_FILENO, line, sizeof(line) - 1);
+    if (n <= 0) {
+        console_open_g = 0;
+        return;
+    }
+    line[n] = '\0';
+
+    SimCar *selected = car_g;
+    car_g = &cars_g[0];
+    for (char *cmd = strtok(line, "\n"); cmd != NULL; cmd = strtok(NULL, "\n")) {
+        int floor = 0;
+        sscanf(cmd + 1, "%d", &floor);
+        switch (cmd[0]) {
+        case 'u':
+            sim_press_order(floor, HARDWARE_ORDER_UP);
+            break;
+        case 'd':
+            sim_press_order(floor, HARDWARE_ORDER_DOWN);
+            break;
+        case 'c':
+            sim_press_order(floor, HARDWARE_ORDER_INSIDE);
+            break;
+        case 's':
+            sim_set_stop(!sim_get_bit(STOP));
+            break;
+        case 'o':
+            sim_set_obstruction(!sim_get_bit(OBSTRUCTION));
+            break;
+        case 'p':
+            printf("t=%.3f pos=%.3f vel=%.3f motor=%d door=%d\n",
+                   now_g * 1e-9, car_g->position, car_g->velocity, car_g->motor, sim_get_door_open());
+            fflush(stdout);
+            break;
+        }
+    }
+    car_g = selected;
+}
+
+
+
+static void sim_sync() {
+    if (!virtual_clock_g) {
+        sim_integrate_to(sim_monotonic_ns() - epoch_g);
+        sim_poll_console();
+    }
+}
+
+
+
+int io_init() {
+    memset(car_g, 0, sizeof(*car_g));
+    car_g->active_sensor = -1;
+
+    // The clock is shared by the bank and restarts with its first car
+    if (car_g == &cars_g[0]) {
+        now_g = 0;
+        epoch_g = sim_monotonic_ns();
+    }
+
+    // ELEVATOR_SIM_START lets a run begin between floors, e.g. to exercise homing
+    const char *start = getenv("ELEVATOR_SIM_START");
+    car_g->position = start ? atof(start) : 0.0;
+    sim_update_sensors();
+
+    return 1;
+}
+
+
+
+int io_select_car(int car) {
+    if (car < 0 || car >= HARDWARE_MAX_CARS)
+        return 0;
+    car_g = &cars_g[car];
+    if (car >= car_count_g)
+        car_count_g = car + 1;
+    return 1;
+}
+
+
+
+void io_set_bit(int channel) {
+    sim_sync();
+    sim_put_bit(channel, 1);
+}
+
+
+
+void io_clear_bit(int channel) {
+    sim_sync();
+    sim_put_bit(channel, 0);
+}
+
+
+
+void io_write_bitfield(int subdevice, unsigned int write_mask, unsigned int bits, int base_channel) {
+    sim_sync();
+    unsigned int *word = &car_g->dio[subdevice][base_channel >> 5];
+    int shift = base_channel & 0x1f;
+    *word = (*word & ~(write_mask << shift)) | ((bits & write_mask) << shift);
+}
+
+
+
+void io_write_analog(int channel, int value) {
+    sim_sync();
+    if (channel == MOTOR) {
+        if (car_g->motor == 0 && value != 0)
+            car_g->motor_starts++;
+        car_g->motor = value;
+    }
+}
+
+
+
+int io_read_bit(int channel) {
+    sim_sync();
+    return sim_get_bit(channel);
+}
+
+
+
+unsigned int io_read_bitfield(int subdevice, int base_channel) {
+    sim_sync();
+    return car_g->dio[subdevice][base_channel >> 5] >> (base_channel & 0x1f);
+}
+
+
+
+int io_read_analog(int channel) {
+    sim_sync();
+    return (channel == MOTOR) ? car_g->motor : 0;
+}
+
+
+
+void io_flush() {
+}
+
+
+
+int io_get_stats(IoStats *stats) {
+    return 0;
+}
+
+
+
+void sim_use_virtual_clock() {
+    virtual_clock_g = 1;
+    now_g = 0;
+    console_open_g = 0;
+}
+
+
+
+void sim_close_console() {
+    console_open_g = 0;
+}
+
+
+
+void sim_advance(long long ns) {
+    if (virtual_clock_g)
+        sim_integrate_to(now_g + ns);
+}
+
+
+
+long long sim_now_ns() {
+    sim_sync();
+    return now_g;
+}
+
+
+
+void sim_set_position(double position) {
+    car_g->position = position;
+    car_g->velocity = 0.0;
+    sim_update_sensors();
+}
+
+
+
+double sim_get_position() {
+    sim_sync();
+    return car_g->position;
+}
+
+
+
+double sim_get_velocity() {
+    sim_sync();
+    return car_g->velocity;
+}
+
+
+
+double sim_get_distance() {
+    sim_sync();
+    return car_g->distance;
+}
+
+
+
+long long sim_get_motor_starts() {
+    return car_g->motor_starts;
+}
+
+
+
+void sim_set_order(int floor, HardwareOrder order_type, int pressed) {
+    int type = sim_type_index(order_type);
+    if (floor < 0 || floor >= HARDWARE_NUMBER_OF_FLOORS || type < 0)
+        return;
+    sim_put_bit(sim_order_bits[floor][type], pressed);
+    car_g->release_at[floor][type] = 0;
+}
+
+
+
+void sim_press_order(int floor, HardwareOrder order_type) {
+    int type = sim_type_index(order_type);
+    if (floor < 0 || floor >= HARDWARE_NUMBER_OF_FLOORS || type < 0)
+        return;
+    sim_put_bit(sim_order_bits[floor][type], 1);
+    if (!car_g->release_at[floor][type])
+        car_g->held[car_g->held_count++] = floor * 3 + type;
+    car_g->release_at[floor][type] = now_g + SIM_PRESS_NS;
+}
+
+
+
+void sim_set_stop(int pressed) {
+    sim_put_bit(STOP, pressed);
+}
+
+
+
+void sim_set_obstruction(int obstructed) {
+    sim_put_bit(OBSTRUCTION, obstructed);
+}
+
+
+
+int sim_get_door_open() {
+    return sim_get_bit(LIGHT_DOOR_OPEN);
+}
+
+
+
+int sim_get_order_light(int floor, HardwareOrder order_type) {
+    int type = sim_type_index(order_type);
+    if (floor < 0 || floor >= HARDWARE_NUMBER_OF_FLOORS || type < 0)
+        return 0;
+    return sim_get_bit(sim_light_bits[floor][type]);
+}
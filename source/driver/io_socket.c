@@ -0,0 +1,237 @@
+// Socket replacement for the libComedi wrapper in io.c.
+// Implements the io_* interface against a simulator in another process,
+// sim_server.c, over a Unix domain socket, so the controller can be run
+// against one building model together with other controllers.
+// Link with this file instead of io.c, and without -lcomedi.
+//
+// The io_* calls are batched as described in sim_protocol.h. Writes are
+// held until the driver flushes its outputs, and a read takes the channels
+// of every car in one round trip, which then answers the reads of the other
+// channels and cars. The next round trip is made when a channel is read
+// again, which is when the driver samples again, so a control cycle makes
+// one round trip however many channels and cars it reads.
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "io.h"
+#include "channels.h"
+#include "sim_protocol.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+
+static int socket_g = -1;
+
+static int car_g = 0;
+static int car_count_g = 1;         // Cars that have been selected, whose channels are asked for
+
+// The channels of every car as last answered, and which of them have been read since
+static unsigned int words_g[HARDWARE_MAX_CARS][SIM_WORDS_PER_CAR];
+static unsigned char read_g[HARDWARE_MAX_CARS][SIM_WORDS_PER_CAR];
+static int answered_cars_g = 0;     // Cars in the last answer; none before the first
+
+static int motor_g[HARDWARE_MAX_CARS];
+
+static SimRequest request_g;
+static SimInputs inputs_g;
+
+static IoStats stats_g;
+
+
+
+static long long socket_now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+
+
+// The controller cannot go on without its plant
+static void socket_lost(const char *what) {
+    fprintf(stderr, "Lost the simulator: %s\n", what);
+    exit(1);
+}
+
+
+
+static void socket_send(int type) {
+    if (type == SIM_MESSAGE_WRITE)
+        request_g.header.cars = 0;
+    size_t bytes = sizeof(SimHeader) + request_g.header.writes * sizeof(SimWrite);
+    request_g.header.type = type;
+    if (send(socket_g, &request_g, bytes, MSG_NOSIGNAL) != (ssize_t)bytes)
+        socket_lost("send");
+    stats_g.writes += request_g.header.writes;
+    request_g.header.writes = 0;
+}
+
+
+
+// Adds a write to the request, merged with an earlier one of the same channels
+static void socket_add_write(int kind, int index, unsigned int mask, int value) {
+    for (unsigned int i = 0; i < request_g.header.writes; i++) {
+        SimWrite *write = &request_g.writes[i];
+        if (write->car == car_g && write->kind == kind && write->index == index) {
+            write->value = (kind == SIM_WRITE_DIGITAL) ? (int)((write->value & ~mask) | (value & mask)) : value;
+            write->mask |= mask;
+            return;
+        }
+    }
+
+    if (request_g.header.writes == SIM_MAX_WRITES) {
+        socket_send(SIM_MESSAGE_WRITE);
+        stats_g.write_batches++;
+    }
+    request_g.writes[request_g.header.writes++] = (SimWrite){
+        .car = car_g, .kind = kind, .index = index, .mask = mask, .value = value
+    };
+}
+
+
+
+static void socket_exchange() {
+    long long start = socket_now_ns();
+
+    request_g.header.cars = car_count_g;
+    socket_send(SIM_MESSAGE_EXCHANGE);
+    ssize_t expected = sizeof(SimHeader) + car_count_g * sizeof(inputs_g.words[0]);
+    if (recv(socket_g, &inputs_g, sizeof(inputs_g), 0) != expected || inputs_g.header.cars != (uint32_t)car_count_g)
+        socket_lost("short answer");
+
+    memcpy(words_g, inputs_g.words, car_count_g * sizeof(words_g[0]));
+    memset(read_g, 0, sizeof(read_g));
+    answered_cars_g = car_count_g;
+
+    long long round_trip = socket_now_ns() - start;
+    stats_g.round_trips++;
+    stats_g.round_trip_sum_ns += round_trip;
+    if (round_trip > stats_g.round_trip_max_ns)
+        stats_g.round_trip_max_ns = round_trip;
+}
+
+
+
+// A word of the selected car, from the last answer, or from a new one if it has been read since
+static unsigned int socket_read_word(int subdevice, int word) {
+    int index = subdevice * SIM_WORDS_PER_SUBDEVICE + word;
+    stats_g.calls++;
+    if (car_g >= answered_cars_g || read_g[car_g][index])
+        socket_exchange();
+    read_g[car_g][index] = 1;
+    return words_g[car_g][index];
+}
+
+
+
+int io_init() {
+    // Every car of a bank is initialized, and they share the connection
+    if (socket_g >= 0)
+        return 1;
+
+    const char *path = getenv("ELEVATOR_SIM_SOCKET");
+    struct sockaddr_un address = { .sun_family = AF_UNIX };
+    strncpy(address.sun_path, path ? path : SIM_SOCKET_PATH, sizeof(address.sun_path) - 1);
+
+    socket_g = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (socket_g < 0)
+        return 0;
+
+    SimHeader hello = { .type = SIM_MESSAGE_HELLO, .version = SIM_PROTOCOL_VERSION, .floors = HARDWARE_NUMBER_OF_FLOORS };
+    SimHeader answer;
+    if (connect(socket_g, (struct sockaddr *)&address, sizeof(address)) != 0
+        || send(socket_g, &hello, sizeof(hello), MSG_NOSIGNAL) != sizeof(hello)
+        || recv(socket_g, &answer, sizeof(answer), 0) != sizeof(answer)
+        || answer.type != SIM_MESSAGE_HELLO) {
+        close(socket_g);
+        socket_g = -1;
+        return 0;
+    }
+    return 1;
+}
+
+
+
+int io_select_car(int car) {
+    if (car < 0 || car >= HARDWARE_MAX_CARS)
+        return 0;
+    car_g = car;
+    if (car >= car_count_g)
+        car_count_g = car + 1;
+    return 1;
+}
+
+
+
+void io_set_bit(int channel) {
+    stats_g.calls++;
+    socket_add_write(SIM_WRITE_DIGITAL, (channel >> 8) * SIM_WORDS_PER_SUBDEVICE + ((channel & 0xff) >> 5),
+                     1u << (channel & 0x1f), -1);
+}
+
+
+
+void io_clear_bit(int channel) {
+    stats_g.calls++;
+    socket_add_write(SIM_WRITE_DIGITAL, (channel >> 8) * SIM_WORDS_PER_SUBDEVICE + ((channel & 0xff) >> 5),
+                     1u << (channel & 0x1f), 0);
+}
+
+
+
+void io_write_bitfield(int subdevice, unsigned int write_mask, unsigned int bits, int base_channel) {
+    stats_g.calls++;
+    int shift = base_channel & 0x1f;
+    socket_add_write(SIM_WRITE_DIGITAL, subdevice * SIM_WORDS_PER_SUBDEVICE + (base_channel >> 5),
+                     write_mask << shift, (bits & write_mask) << shift);
+}
+
+
+
+void io_write_analog(int channel, int value) {
+    stats_g.calls++;
+    motor_g[car_g] = value;
+    socket_add_write(SIM_WRITE_ANALOG, channel, 0, value);
+}
+
+
+
+int io_read_bit(int channel) {
+    return (socket_read_word(channel >> 8, (channel & 0xff) >> 5) >> (channel & 0x1f)) & 1;
+}
+
+
+
+unsigned int io_read_bitfield(int subdevice, int base_channel) {
+    return socket_read_word(subdevice, base_channel >> 5) >> (base_channel & 0x1f);
+}
+
+
+
+// The only analog channel is the motor, which is only written
+int io_read_analog(int channel) {
+    stats_g.calls++;
+    return (channel == MOTOR) ? motor_g[car_g] : 0;
+}
+
+
+
+void io_flush() {
+    if (request_g.header.writes > 0) {
+        socket_send(SIM_MESSAGE_WRITE);
+        stats_g.write_batches++;
+    }
+}
+
+
+
+int io_get_stats(IoStats *stats) {
+    *stats = stats_g;
+    return 1;
+}
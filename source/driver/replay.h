@@ -0,0 +1,71 @@
+/**
+ * @file
+ * @brief Control interface for the replay backend.
+ *
+ * The replay backend (io_replay.c) implements the same @c io_* functions as the libComedi
+ * wrapper, but answers the reads from a recording made with io_record.h. The inputs of every car
+ * take the values they were recorded with at the recorded times, on a virtual clock that only
+ * moves through @c replay_advance_to(), so an unmodified controller sees the same input
+ * sequence as on site, as fast as the CPU allows and the same way on every run.
+ *
+ * Output records are skipped, and what the controller writes is only kept so that it can be
+ * read back. To compare a replay with the original, record the replay as well and decode both.
+ */
+#ifndef REPLAY_H
+#define REPLAY_H
+
+
+/**
+ * @brief Map a recording and rewind the virtual clock to its start.
+ * Must be called before @c hardware_init() .
+ *
+ * @param path The recording.
+ *
+ * @return 0 on success, and -1 if the file could not be mapped or is not a recording.
+ */
+int replay_open(const char *path);
+
+/**
+ * @brief Control rate of the recorded controller.
+ */
+int replay_rate_hz();
+
+/**
+ * @brief Number of cars of the recorded controller.
+ */
+int replay_cars();
+
+/**
+ * @brief Current time of the virtual clock, in nanoseconds since the start of the recording.
+ */
+long long replay_now_ns();
+
+/**
+ * @brief Time of the next input record, or -1 if there are no more.
+ * The recorded controller sampled the input at that time, so a replay ticks there too.
+ */
+long long replay_next_input_ns();
+
+/**
+ * @brief Time of the last record of any kind.
+ */
+long long replay_end_ns();
+
+/**
+ * @brief Move the virtual clock forward, applying every input recorded up to then.
+ *
+ * @param ns Nanoseconds since the start of the recording.
+ */
+void replay_advance_to(long long ns);
+
+/**
+ * @brief Number of records applied or skipped so far.
+ */
+long long replay_records();
+
+/**
+ * @brief Unmap the recording.
+ */
+void replay_close();
+
+#endif //REPLAY_H
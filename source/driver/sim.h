@@ -0,0 +1,124 @@
+/**
+ * @file
+ * @brief Control interface for the simulated elevator plant.
+ *
+ * The simulated backend (io_sim.c) implements the same @c io_* functions as
+ * the libComedi wrapper, but answers them from an in-process physics model of
+ * elevator cars in their shafts. This header exposes the knobs of that model, so that
+ * programs linked against the simulated driver can press buttons, flip the stop
+ * and obstruction switches, and observe the car.
+ *
+ * The plant holds a car for every car the driver has selected through
+ * @c io_select_car() , each in its own shaft. The functions below act on the
+ * selected car, so select a car with @c hardware_select_car() before using them.
+ *
+ * By default the plant runs on wall-clock time. Calling @c sim_use_virtual_clock()
+ * freezes the clock, after which time only moves through @c sim_advance(); this
+ * allows experiments to run as fast as the CPU allows.
+ */
+#ifndef SIM_H
+#define SIM_H
+
+#include "hardware.h"
+
+#define SIM_PRESS_NS 200000000LL   /**< How long @c sim_press_order() holds a button down, in nanoseconds */
+
+/**
+ * @brief Switch the plant to a virtual clock that only moves through
+ * @c sim_advance(). The virtual clock starts at 0.
+ */
+void sim_use_virtual_clock();
+
+/**
+ * @brief Advance the virtual clock, integrating the plant on the way.
+ *
+ * @param ns Nanoseconds to advance. Ignored when running on wall-clock time.
+ */
+void sim_advance(long long ns);
+
+/**
+ * @brief Stop reading commands from stdin, for a program that reads stdin itself.
+ */
+void sim_close_console();
+
+/**
+ * @brief Current simulation time.
+ *
+ * @return Nanoseconds since the plant was initialized (or since
+ * @c sim_use_virtual_clock() was called).
+ */
+long long sim_now_ns();
+
+/**
+ * @brief Place the car at @p position, measured in floors from the bottom floor.
+ * The car is left standing still.
+ *
+ * @param position Car position; 0.0 is the bottom floor sensor, 1.5 is
+ * halfway between the second and third floor.
+ */
+void sim_set_position(double position);
+
+/**
+ * @brief Car position, measured in floors from the bottom floor.
+ */
+double sim_get_position();
+
+/**
+ * @brief Car velocity in floors per second. Positive is upwards.
+ */
+double sim_get_velocity();
+
+/**
+ * @brief Distance the car has travelled since it was initialized, in floors.
+ */
+double sim_get_distance();
+
+/**
+ * @brief Number of times the motor has been started from standstill since the
+ * car was initialized.
+ */
+long long sim_get_motor_starts();
+
+/**
+ * @brief Press and hold, or release, an order button.
+ *
+ * @param floor The floor of the button.
+ * @param order_type The type of button.
+ * @param pressed 1 to hold the button down; 0 to release it.
+ */
+void sim_set_order(int floor, HardwareOrder order_type, int pressed);
+
+/**
+ * @brief Give an order button a short press. The button is released
+ * automatically after @c SIM_PRESS_NS of simulation time.
+ *
+ * @param floor The floor of the button.
+ * @param order_type The type of button.
+ */
+void sim_press_order(int floor, HardwareOrder order_type);
+
+/**
+ * @brief Set the stop button. 1 = pressed in, 0 = released.
+ */
+void sim_set_stop(int pressed);
+
+/**
+ * @brief Set the obstruction switch. 1 = obstructed, 0 = clear.
+ */
+void sim_set_obstruction(int obstructed);
+
+/**
+ * @brief State of the door lamp as last commanded by the controller.
+ *
+ * @return 1 if the door is open; 0 if it is closed.
+ */
+int sim_get_door_open();
+
+/**
+ * @brief State of an order button lamp as last commanded by the controller.
+ *
+ * @return 1 if the lamp is lit; 0 if not, or if the button does not exist.
+ */
+int sim_get_order_light(int floor, HardwareOrder order_type);
+
+#endif //SIM_H
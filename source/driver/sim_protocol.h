@@ -0,0 +1,73 @@
+// Messages between io_socket.c and the simulator process, sim_server.c.
+// They go over a Unix domain socket of type SOCK_SEQPACKET, which keeps the
+// boundaries of the messages, so every message is one send() and one recv().
+//
+// A controller batches what its driver does in a tick instead of making a
+// round trip per io_* call:
+//  - SIM_MESSAGE_WRITE carries the writes of a flush of the outputs. It is
+//    not answered, since the driver needs nothing back from a write.
+//  - SIM_MESSAGE_EXCHANGE carries the writes not yet sent and asks for the
+//    channels of every car. The answer holds the channels after the writes,
+//    and answers every read until the driver samples again.
+// The messages of a connection are handled in the order they are sent.
+#ifndef __INCLUDE_DRIVER_SIM_PROTOCOL_H__
+#define __INCLUDE_DRIVER_SIM_PROTOCOL_H__
+
+#include "hardware.h"
+
+#include <stdint.h>
+
+
+#define SIM_PROTOCOL_VERSION        1
+#define SIM_SOCKET_PATH             "/tmp/elevator_sim.sock"    // Unless ELEVATOR_SIM_SOCKET names another
+#define SIM_WORDS_PER_SUBDEVICE     8                           // 256 channels in words of 32
+#define SIM_WORDS_PER_CAR           (BUILDING_SUBDEVICES * SIM_WORDS_PER_SUBDEVICE)
+#define SIM_MAX_WRITES              256                         // Writes in one message; more are sent in another first
+
+
+typedef enum {
+    SIM_MESSAGE_HELLO,      // Sent on connecting, and answered with the same message
+    SIM_MESSAGE_WRITE,      // Writes, not answered
+    SIM_MESSAGE_EXCHANGE    // Writes, answered with SimInputs
+} SimMessageType;
+
+
+typedef enum {
+    SIM_WRITE_DIGITAL,      // index is subdevice * SIM_WORDS_PER_SUBDEVICE + word; mask and value are its bits
+    SIM_WRITE_ANALOG        // index is the channel, and value its value
+} SimWriteKind;
+
+
+typedef struct {
+    uint8_t car;
+    uint8_t kind;
+    uint16_t index;
+    uint32_t mask;
+    int32_t value;
+} SimWrite;
+
+
+// The first bytes of every message
+typedef struct {
+    uint32_t type;
+    uint32_t version;       // SIM_PROTOCOL_VERSION in a hello, to check both ends are the same build
+    uint32_t floors;        // HARDWARE_NUMBER_OF_FLOORS in a hello
+    uint32_t cars;          // Cars whose channels are asked for, or answered
+    uint32_t writes;        // Writes that follow
+} SimHeader;
+
+
+typedef struct {
+    SimHeader header;
+    SimWrite writes[SIM_MAX_WRITES];
+} SimRequest;
+
+
+typedef struct {
+    SimHeader header;
+    uint32_t words[HARDWARE_MAX_CARS][SIM_WORDS_PER_CAR];
+} SimInputs;
+
+
+
+#endif //#ifndef __INCLUDE_DRIVER_SIM_PROTOCOL_H__
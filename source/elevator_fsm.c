@@ -1,13 +1,47 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <math.h>
 #include <stdio.h>
+#include <string.h>
 
 #include "elevator_fsm.h"
+#include "elevator_fsm_table.h"
 #include "elevator_io.h"
 #include "globals.h"
+#include "journal.h"
+#include "latency.h"
 #include "queue.h"
 #include "timer.h"
 
 
 elevator_data_t elevator_init() {
+    elevator_data_t elevator_data;
+    elevator_init_from_snapshot(&elevator_data, NULL, 0);
+    return elevator_data;
+}
+
+
+/**
+ * @brief Take back what the elevator had learned about its travel times and hall stops
+ */
+static void elevator_restore_learned(elevator_data_t* p_elevator_data, const snapshot_state_t* p_state) {
+    position_t* p_position = &p_elevator_data->position;
+    p_position->gain = p_state->gain;
+    p_position->gain_samples = (int)p_state->gain_samples;
+    for(int f = 0; f < HARDWARE_NUMBER_OF_FLOORS; f++) {
+        p_position->pass_ns[f] = p_state->pass_ns[f];
+        p_elevator_data->door.hall_stops[f] = p_state->hall_stops[f];
+    }
+    p_position->floor_ns = p_state->floor_ns;
+    p_position->landing_ns[0] = p_state->landing_ns[0];
+    p_position->landing_ns[1] = p_state->landing_ns[1];
+    p_elevator_data->door.hall_total = p_state->hall_total;
+}
+
+
+int elevator_init_from_snapshot(elevator_data_t* p_elevator_data, snapshot_t* p_snapshot, int car) {
+    const snapshot_state_t* p_state = (p_snapshot != NULL) ? snapshot_restored(p_snapshot, car) : NULL;
+
     //Turn off all button lights and clear all order light arrays (just in case)
     for(int floor = 0; floor < HARDWARE_NUMBER_OF_FLOORS; floor++) {
         hardware_command_order_light(floor, HARDWARE_ORDER_UP,     LIGHT_OFF);
@@ -18,199 +52,293 @@ elevator_data_t elevator_init() {
     hardware_command_stop_light(LIGHT_OFF);
     hardware_command_door_open(DOOR_CLOSE); 
 
-    hardware_command_movement(HARDWARE_MOVEMENT_DOWN);
-    while(get_current_floor() == BETWEEN_FLOORS) {}
+    int current_floor = get_current_floor();
+    int homing = (current_floor == BETWEEN_FLOORS);
+    // A car standing at the floor it last saved its snapshot at is where its orders were accepted
+    int warm = (p_state != NULL && current_floor == p_state->last_floor);
+
+    // Between floors, the car homes towards the floor nearest to where its snapshot last saw it, or else down
+    int start_floor = homing ? MIN_FLOOR : current_floor;
+    HardwareMovement homing_dir = HARDWARE_MOVEMENT_DOWN;
+    if(homing && p_state != NULL) {
+        double position = (double)p_state->position_steps / SNAPSHOT_POSITION_STEPS;
+        start_floor = (int)lround(position);
+        start_floor = (start_floor < MIN_FLOOR) ? MIN_FLOOR : (start_floor >= HARDWARE_NUMBER_OF_FLOORS) ? HARDWARE_NUMBER_OF_FLOORS - 1 : start_floor;
+        homing_dir = (start_floor > position) ? HARDWARE_MOVEMENT_UP : HARDWARE_MOVEMENT_DOWN;
+    }
+
     hardware_command_movement(HARDWARE_MOVEMENT_STOP);
+    set_floor_indicator_light(current_floor);
+    hardware_flush_outputs();
+
+    elevator_data_t elevator_data = { .last_floor = homing ? FLOOR_NOT_INIT : current_floor,
+                                      .last_dir = homing ? homing_dir : HARDWARE_MOVEMENT_STOP,
+                                      .state = homing ? STATE_HOMING : STATE_IDLE,
+                                      .next_action = homing ? ACTION_DO_NOTHING : ACTION_STOP_MOVEMENT,
+                                      .event = EVENT_NO_EVENT,
+                                      .in_group = 0,
+                                      .car = car,
+                                      .policy = QUEUE_POLICY_LOOK,
+                                      .park_floor = FLOOR_NOT_INIT,
+                                      .p_demand = NULL,
+                                      .p_snapshot = p_snapshot,
+                                      .homing_started_ns = timer_now_ns(),
+                                      .homing_ns = homing ? -1 : 0,
+                                      .run_dir = HARDWARE_MOVEMENT_STOP,
+                                      .p_live = NULL
+                                    };
+    queue_init(&elevator_data.queue);
+    timer_init(&elevator_data.timers);
+    motion_init(&elevator_data.motion);
+    position_init(&elevator_data.position, start_floor);
+    door_init(&elevator_data.door);
+    elevator_data.sensors = read_sensors();
+    elevator_data.inputs.known = 0;
+
+    if(p_state != NULL) {
+        elevator_restore_learned(&elevator_data, p_state);
+    }
+    if(warm) {
+        // Pushed oldest first, so they are served in the order they were accepted; the lights follow on the first tick
+        elevator_data.last_dir = p_state->last_dir;
+        for(int i = 0; i < p_state->order_count; i++) {
+            int slot = p_state->orders[i];
+            queue_push_back(&elevator_data.queue, slot % HARDWARE_NUMBER_OF_FLOORS, slot / HARDWARE_NUMBER_OF_FLOORS);
+        }
+    }
 
-    hardware_command_floor_indicator_on(get_current_floor());
+    *p_elevator_data = elevator_data;
+    return warm;
+}
 
-    queue_init();
 
-    elevator_data_t elevator_data = { .last_floor = get_current_floor(),
-                                      .last_dir = HARDWARE_MOVEMENT_STOP,
-                                      .state = STATE_IDLE,
-                                      .next_action = ACTION_STOP_MOVEMENT
-                                    };
+static const elevator_transition_t elevator_fsm_transitions[] = ELEVATOR_FSM_TRANSITIONS;
 
-    return elevator_data;
+static const struct{
+    uint8_t first;
+    uint8_t count;
+} elevator_fsm_index[STATE_COUNT][EVENT_COUNT] = ELEVATOR_FSM_INDEX;
+
+
+static int elevator_input(elevator_data_t* p_elevator_data, elevator_input_t input);
+
+
+/**
+ * @brief Compute one of the inputs of the FSM
+ */
+static int elevator_evaluate_input(elevator_data_t* p_elevator_data, elevator_input_t input) {
+    switch(input) {
+        // A parking elevator drives to its parking floor as if it had an order there
+        case INPUT_QUEUE_EMPTY:
+            return queue_empty(&p_elevator_data->queue) && p_elevator_data->park_floor == FLOOR_NOT_INIT;
+
+        case INPUT_TARGET_FLOOR:
+            if(queue_empty(&p_elevator_data->queue)) {
+                return p_elevator_data->park_floor;
+            }
+            return queue_next_target(&p_elevator_data->queue, p_elevator_data->policy, p_elevator_data->last_floor, p_elevator_data->last_dir);
+
+        case INPUT_ORDER_MATCH:
+            if(queue_empty(&p_elevator_data->queue) && p_elevator_data->park_floor != FLOOR_NOT_INIT) {
+                return p_elevator_data->sensors.current_floor == p_elevator_data->park_floor;
+            }
+            return queue_check_order_match(&p_elevator_data->queue, p_elevator_data->sensors.current_floor,
+                                           elevator_input(p_elevator_data, INPUT_TARGET_FLOOR), p_elevator_data->last_dir);
+
+        case INPUT_DOOR_TIMER_DONE:
+            return timer_check(&p_elevator_data->timers, TIMER_DOOR);
+
+        case INPUT_STOP_HOLD_DONE:
+            return timer_check(&p_elevator_data->timers, TIMER_STOP_HOLD);
+    }
+    return 0;
 }
 
 
-elevator_action_t elevator_update_state(elevator_data_t* p_elevator_data) {
+/**
+ * @brief Get an input of the FSM, evaluating it only on its first use in the tick
+ */
+static int elevator_input(elevator_data_t* p_elevator_data, elevator_input_t input) {
+    elevator_inputs_t* p_inputs = &p_elevator_data->inputs;
 
-    int current_floor = get_current_floor();
-    Order current_order = QUEUE[0];
+    if(!(p_inputs->known & (1u << input))) {
+        p_inputs->value[input] = elevator_evaluate_input(p_elevator_data, input);
+        p_inputs->known |= 1u << input;
+    }
+    return p_inputs->value[input];
+}
 
-    elevator_event_t current_event = elevator_update_event(p_elevator_data);
-    elevator_guard_t guards = elevator_update_guards(p_elevator_data);
 
-    failsafe_invalid_state(p_elevator_data);
+/**
+ * @brief Run the "enter" actions of the state diagram. They are run on every update while in the state.
+ */
+static void elevator_state_actions(elevator_data_t* p_elevator_data, int current_floor) {
     switch(p_elevator_data->state) {
-        case STATE_IDLE: {
-            // Entry actions:
+        case STATE_DOOR_OPEN:
+            hardware_command_door_open(DOOR_OPEN);
+            queue_clear_served_orders(&p_elevator_data->queue, p_elevator_data->policy, current_floor, p_elevator_data->last_dir);
+            // Fall through: the motor is stopped in all of these states
+        case STATE_IDLE:
+        case STATE_EMERGENCY:
             hardware_command_movement(HARDWARE_MOVEMENT_STOP);
+            break;
 
-            switch (current_event)  {
-                case EVENT_STOP_BUTTON_HIGH:{
-                    p_elevator_data->state = STATE_EMERGENCY;
-                    return ACTION_EMERGENCY;
-                }
-
-                case EVENT_QUEUE_EMPTY:{
-                    p_elevator_data->state = STATE_IDLE;
-                    return ACTION_DO_NOTHING;
-                }
-                
-                case EVENT_QUEUE_NOT_EMPTY:{
-                    if(guards.TARGET_FLOOR_ABOVE) {
-                        p_elevator_data->state = STATE_MOVING_UP;
-                        return ACTION_MOVE_UP;
-                    }
-
-                    if(guards.TARGET_FLOOR_EQUAL) {
-                        p_elevator_data->state = STATE_DOOR_OPEN;
-                        return ACTION_START_DOOR_TIMER;
-                    }
-
-                    if(guards.TARGET_FLOOR_BELOW) {
-                        p_elevator_data->state = STATE_MOVING_DOWN;
-                        return ACTION_MOVE_DOWN;
-                    }
-                }
-
-                case EVENT_NO_EVENT: {
-                    p_elevator_data->state = STATE_IDLE;
-                    return ACTION_DO_NOTHING;
-                }
-            }
-        }
+        case STATE_HOMING:
+            hardware_command_movement(p_elevator_data->last_dir);
+            break;
+    }
+}
 
-        case STATE_DOOR_OPEN: {
-            // Entry actions:
+
+/**
+ * @brief Run the "exit" actions of the state diagram when leaving @p state
+ */
+static void elevator_exit_actions(elevator_data_t* p_elevator_data) {
+    switch(p_elevator_data->state) {
+        case STATE_MOVING_UP:
+        case STATE_MOVING_DOWN:
             hardware_command_movement(HARDWARE_MOVEMENT_STOP);
-            hardware_command_door_open(DOOR_OPEN);
-            queue_clear_order_at_floor(p_elevator_data->orders_cab, p_elevator_data->orders_up, p_elevator_data->orders_down, current_floor);
-
-            switch (current_event) {
-                
-                case EVENT_STOP_BUTTON_HIGH:{
-                    p_elevator_data->state = STATE_EMERGENCY;
-                    return ACTION_EMERGENCY;
-                }
-
-                case EVENT_QUEUE_EMPTY:{
-                    p_elevator_data->state = STATE_IDLE;
-                    return ACTION_CLOSE_DOOR;
-                }
-
-                case EVENT_OBSTRUCTION_HIGH: {
-                    p_elevator_data->state = STATE_DOOR_OPEN;
-                    return ACTION_START_DOOR_TIMER;
-                } 
-
-                case EVENT_TARGET_FLOOR_DIFF: {
-                    if(guards.TARGET_FLOOR_ABOVE && guards.TIMER_DONE) {
-                        p_elevator_data->state = STATE_MOVING_UP;
-                        hardware_command_door_open(DOOR_CLOSE);
-                        return ACTION_MOVE_UP;
-                    }
-
-                    if(guards.TARGET_FLOOR_BELOW && guards.TIMER_DONE) {
-                        p_elevator_data->state = STATE_MOVING_DOWN;
-                        hardware_command_door_open(DOOR_CLOSE);
-                        return ACTION_MOVE_DOWN;
-                    }  
-                }
-
-                case EVENT_NO_EVENT: {
-                    if(guards.TIMER_DONE) {
-                        p_elevator_data->state = STATE_IDLE;
-                        return ACTION_CLOSE_DOOR;
-                    }
-
-                    p_elevator_data->state = STATE_DOOR_OPEN;
-                    return ACTION_DO_NOTHING;
-                }
-            }    
-        }
+            break;
 
-        case STATE_MOVING_UP: {
-            switch (current_event) {
-
-                case EVENT_STOP_BUTTON_HIGH:{
-                    hardware_command_movement(HARDWARE_MOVEMENT_STOP);
-                    p_elevator_data->state = STATE_EMERGENCY;
-                    return ACTION_EMERGENCY;
-                }
-                
-                case EVENT_FLOOR_MATCH: {
-                    if(guards.DIRECTION) {
-                        hardware_command_movement(HARDWARE_MOVEMENT_STOP);
-                        p_elevator_data->state = STATE_DOOR_OPEN;
-                        return ACTION_START_DOOR_TIMER;
-                    }
-                }
-                
-                case EVENT_NO_EVENT: {
-                    p_elevator_data->state = STATE_MOVING_UP;
-                    return ACTION_DO_NOTHING;
-                }
-            }
-        }
+        case STATE_DOOR_OPEN:
+            hardware_command_door_open(DOOR_CLOSE);
+            door_close(&p_elevator_data->door);
+            break;
 
-        case STATE_MOVING_DOWN: {
-            switch (current_event) {
-            
-                case EVENT_STOP_BUTTON_HIGH:{
-                    hardware_command_movement(HARDWARE_MOVEMENT_STOP);
-                    p_elevator_data->state = STATE_EMERGENCY;
-                    return ACTION_EMERGENCY;
-                }
-                
-                case EVENT_FLOOR_MATCH: {
-                    if(guards.DIRECTION) {
-                        hardware_command_movement(HARDWARE_MOVEMENT_STOP);
-                        p_elevator_data->state = STATE_DOOR_OPEN;
-                        return ACTION_START_DOOR_TIMER;
-                    }
-                }
-
-                case EVENT_NO_EVENT: {
-                    p_elevator_data->state = STATE_MOVING_DOWN;
-                    return ACTION_DO_NOTHING;
-                }  
+        case STATE_HOMING:
+            hardware_command_movement(HARDWARE_MOVEMENT_STOP);
+            if(p_elevator_data->sensors.current_floor != BETWEEN_FLOORS) {
+                p_elevator_data->homing_ns = timer_now_ns() - p_elevator_data->homing_started_ns;
             }
+            break;
+    }
+}
+
+
+/**
+ * @brief Find the first transition of the table whose guards match @p guard_mask
+ */
+static elevator_transition_t elevator_fsm_match(elevator_state_t state, elevator_event_t event, unsigned int guard_mask) {
+    int first = elevator_fsm_index[state][event].first;
+    int last = first + elevator_fsm_index[state][event].count;
+
+    for(int i = first; i < last; i++) {
+        const elevator_transition_t* p_transition = &elevator_fsm_transitions[i];
+        if((guard_mask & p_transition->required) == p_transition->required && !(guard_mask & p_transition->forbidden)) {
+            return *p_transition;
         }
+    }
+
+    elevator_transition_t stay = { .required = 0, .forbidden = 0, .next_state = state, .action = ACTION_DO_NOTHING };
+    return stay;
+}
+
+
+// The table matched against every possible guard mask, so a lookup is a single load
+static elevator_transition_t elevator_fsm_resolved[STATE_COUNT][EVENT_COUNT][GUARD_MASK_COUNT];
+static uint8_t elevator_fsm_consulted[STATE_COUNT][EVENT_COUNT];
+static int elevator_fsm_is_resolved = 0;
 
-        case STATE_EMERGENCY: {
-            hardware_command_movement(HARDWARE_MOVEMENT_STOP);
 
-            switch(current_event) {
-                case EVENT_STOP_BUTTON_HIGH: {
-                    return ACTION_EMERGENCY;
-                }
-
-                case EVENT_STOP_BUTTON_LOW: {
-                    if(guards.TIMER_DONE && guards.AT_FLOOR) {
-                        p_elevator_data->state = STATE_DOOR_OPEN;
-                        return ACTION_DO_NOTHING;
-                    }
-
-                    if(guards.TIMER_DONE && !guards.AT_FLOOR) {
-                        p_elevator_data->state = STATE_IDLE;
-                        return ACTION_DO_NOTHING;
-                    }
-                }
-
-                case EVENT_NO_EVENT: {
-                    p_elevator_data->state = STATE_EMERGENCY;
-                    return ACTION_DO_NOTHING;
-                }
+static void elevator_fsm_resolve() {
+    for(int state = 0; state < STATE_COUNT; state++) {
+        for(int event = 0; event < EVENT_COUNT; event++) {
+            for(unsigned int guard_mask = 0; guard_mask < GUARD_MASK_COUNT; guard_mask++) {
+                elevator_fsm_resolved[state][event][guard_mask] = elevator_fsm_match(state, event, guard_mask);
+            }
+
+            int first = elevator_fsm_index[state][event].first;
+            for(int i = first; i < first + elevator_fsm_index[state][event].count; i++) {
+                elevator_fsm_consulted[state][event] |= elevator_fsm_transitions[i].required | elevator_fsm_transitions[i].forbidden;
             }
         }
-    } //switch(p_elevator_data->state)
-    
-    return ACTION_DO_NOTHING; // Default action if no hits (shouldnt be possible to get here)
+    }
+    elevator_fsm_is_resolved = 1;
+}
+
+
+elevator_transition_t elevator_fsm_lookup(elevator_state_t state, elevator_event_t event, unsigned int guard_mask) {
+    if(!elevator_fsm_is_resolved) {
+        elevator_fsm_resolve();
+    }
+    return elevator_fsm_resolved[state][event][guard_mask & (GUARD_MASK_COUNT - 1)];
+}
+
+
+unsigned int elevator_fsm_consulted_guards(elevator_state_t state, elevator_event_t event) {
+    if(!elevator_fsm_is_resolved) {
+        elevator_fsm_resolve();
+    }
+    return elevator_fsm_consulted[state][event];
+}
+
+
+unsigned int elevator_guard_mask(const elevator_guard_t* p_guards) {
+    return (p_guards->TIMER_DONE         ? GUARD_TIMER_DONE         : 0)
+         | (p_guards->DIRECTION          ? GUARD_DIRECTION          : 0)
+         | (p_guards->TARGET_FLOOR_ABOVE ? GUARD_TARGET_FLOOR_ABOVE : 0)
+         | (p_guards->TARGET_FLOOR_EQUAL ? GUARD_TARGET_FLOOR_EQUAL : 0)
+         | (p_guards->TARGET_FLOOR_BELOW ? GUARD_TARGET_FLOOR_BELOW : 0)
+         | (p_guards->AT_FLOOR           ? GUARD_AT_FLOOR           : 0)
+         | (p_guards->NOT_AT_FLOOR       ? GUARD_NOT_AT_FLOOR       : 0);
+}
+
+
+elevator_action_t elevator_update_state(elevator_data_t* p_elevator_data) {
+    elevator_event_t current_event = elevator_update_event(p_elevator_data);
+    p_elevator_data->event = current_event;
+
+    failsafe_invalid_state(p_elevator_data);
+
+    elevator_state_t from_state = p_elevator_data->state;
+    unsigned int consulted = elevator_fsm_consulted_guards(from_state, current_event);
+    unsigned int guard_mask = elevator_update_guard_mask(p_elevator_data, consulted);
+    elevator_action_t action = elevator_take_transition(p_elevator_data, current_event, guard_mask);
+
+    if(journal_is_open()) {
+        journal_record_t record = { .time_ns = timer_now_ns(),
+                                    .car = p_elevator_data->car,
+                                    .event = current_event,
+                                    .from_state = from_state,
+                                    .to_state = p_elevator_data->state,
+                                    .action = action,
+                                    .guards = guard_mask,
+                                    .consulted = consulted,
+                                    .direction = (p_elevator_data->last_dir == HARDWARE_MOVEMENT_UP) ? 1
+                                               : (p_elevator_data->last_dir == HARDWARE_MOVEMENT_DOWN) ? -1 : 0,
+                                    .floor = p_elevator_data->sensors.current_floor,
+                                    .last_floor = p_elevator_data->last_floor
+                                  };
+        journal_append(&record);
+    }
+    return action;
+}
+
+
+elevator_action_t elevator_take_transition(elevator_data_t* p_elevator_data, elevator_event_t event, unsigned int guard_mask) {
+    elevator_state_actions(p_elevator_data, p_elevator_data->sensors.current_floor);
+
+    elevator_transition_t transition = elevator_fsm_lookup(p_elevator_data->state, event, guard_mask);
+    if(transition.next_state != p_elevator_data->state) {
+        elevator_exit_actions(p_elevator_data);
+        p_elevator_data->state = transition.next_state;
+        p_elevator_data->counters.door_cycles += (transition.next_state == STATE_DOOR_OPEN);
+        p_elevator_data->counters.emergency_stops += (transition.next_state == STATE_EMERGENCY);
+    }
+
+    return transition.action;
+}
+
+
+/**
+ * @brief Count a run the elevator starts in @p dir , and whether it reverses the run before
+ */
+static void elevator_count_run(elevator_data_t* p_elevator_data, HardwareMovement dir) {
+    p_elevator_data->counters.trips++;
+    if(p_elevator_data->run_dir != HARDWARE_MOVEMENT_STOP && p_elevator_data->run_dir != dir) {
+        p_elevator_data->counters.motor_reversals++;
+    }
+    p_elevator_data->run_dir = dir;
 }
 
 
@@ -222,7 +350,7 @@ void elevator_execute_next_action(elevator_data_t* p_elevator_data){
         break;
 
     case ACTION_START_DOOR_TIMER:
-        timer_start();
+        timer_start(&p_elevator_data->timers, TIMER_DOOR, door_dwell_ns(&p_elevator_data->door, &p_elevator_data->queue, p_elevator_data->sensors.current_floor));
         break;
 
     case ACTION_OPEN_DOOR:
@@ -230,23 +358,23 @@ void elevator_execute_next_action(elevator_data_t* p_elevator_data){
         break;
 
     case ACTION_CLOSE_DOOR:
-        queue_update();
         hardware_command_door_open(DOOR_CLOSE);
         break;
 
     case ACTION_MOVE_UP:
-        if(get_current_floor() != BETWEEN_FLOORS) {
-            p_elevator_data->last_dir = HARDWARE_MOVEMENT_UP;
-        }
+        // Also between floors, where the position estimate rather than the direction tells which side of last_floor the elevator is on
+        elevator_count_run(p_elevator_data, HARDWARE_MOVEMENT_UP);
+        p_elevator_data->last_dir = HARDWARE_MOVEMENT_UP;
         hardware_command_movement(HARDWARE_MOVEMENT_UP);
+        timer_start(&p_elevator_data->timers, TIMER_MOTOR_TIMEOUT, MOTOR_TIMEOUT_NS);
         p_elevator_data->state = STATE_MOVING_UP;
         break;
 
     case ACTION_MOVE_DOWN:
-        if(get_current_floor() != BETWEEN_FLOORS) {
-            p_elevator_data->last_dir = HARDWARE_MOVEMENT_DOWN;
-        }
+        elevator_count_run(p_elevator_data, HARDWARE_MOVEMENT_DOWN);
+        p_elevator_data->last_dir = HARDWARE_MOVEMENT_DOWN;
         hardware_command_movement(HARDWARE_MOVEMENT_DOWN);
+        timer_start(&p_elevator_data->timers, TIMER_MOTOR_TIMEOUT, MOTOR_TIMEOUT_NS);
         p_elevator_data->state = STATE_MOVING_DOWN;
         break;
 
@@ -257,9 +385,9 @@ void elevator_execute_next_action(elevator_data_t* p_elevator_data){
         break;
 
     case ACTION_EMERGENCY: {
-        queue_erase(p_elevator_data->orders_up, p_elevator_data->orders_down, p_elevator_data->orders_cab);
-        timer_start();
-        if (get_current_floor() != BETWEEN_FLOORS && hardware_read_stop_signal()){
+        queue_erase(&p_elevator_data->queue);
+        timer_start(&p_elevator_data->timers, TIMER_STOP_HOLD, STOP_HOLD_TIME_NS);
+        if (p_elevator_data->sensors.current_floor != BETWEEN_FLOORS && p_elevator_data->sensors.stop){
             hardware_command_door_open(DOOR_OPEN);
         }
     }
@@ -272,121 +400,137 @@ void elevator_execute_next_action(elevator_data_t* p_elevator_data){
 }
 
 
-elevator_guard_t elevator_update_guards(elevator_data_t* p_elevator_data) {
-    elevator_guard_t guards;
-
-    int target = QUEUE[0].target_floor;
-    int current_floor = get_current_floor();
-    int last_valid_floor = p_elevator_data->last_floor;
-                  
-    guards.DIRECTION = queue_check_order_match(current_floor, p_elevator_data->last_dir);                  
-    guards.AT_FLOOR = (current_floor != BETWEEN_FLOORS);              
-    guards.NOT_AT_FLOOR = (current_floor == BETWEEN_FLOORS);
-    guards.TIMER_DONE = timer_check(DOOR_TIME_REQ);
+/**
+ * @brief Evaluate one of the target floor guards
+ */
+static int elevator_target_guard(elevator_data_t* p_elevator_data, elevator_guard_bit_t guard, int current_floor) {
+    int target = elevator_input(p_elevator_data, INPUT_TARGET_FLOOR);
 
     // Normal check for the usual case (elevator at floor)
     if(current_floor != BETWEEN_FLOORS) {
-        guards.TARGET_FLOOR_ABOVE = (target > current_floor);
-        guards.TARGET_FLOOR_EQUAL = (target == current_floor);
-        guards.TARGET_FLOOR_BELOW = (target < current_floor);
-        return guards;
+        return (guard == GUARD_TARGET_FLOOR_ABOVE) ? (target > current_floor)
+             : (guard == GUARD_TARGET_FLOOR_EQUAL) ? (target == current_floor)
+             : (target < current_floor);
     }
 
     // Perform no checks for invalid orders
     if(target == FLOOR_NOT_INIT) {
-        guards.TARGET_FLOOR_ABOVE = 0;       
-        guards.TARGET_FLOOR_EQUAL = 0;    
-        guards.TARGET_FLOOR_BELOW = 0;
-        return guards;
+        return 0;
     }
 
-    // Stopped between floors (emergency)
-    if(current_floor == BETWEEN_FLOORS && p_elevator_data->next_action == ACTION_DO_NOTHING) {
-        guards.TARGET_FLOOR_EQUAL = 0;
+    // Stopped between floors (emergency): the estimate is never at a floor there, so every target is above or below it
+    if(p_elevator_data->next_action == ACTION_DO_NOTHING && guard != GUARD_TARGET_FLOOR_EQUAL) {
+        double position = p_elevator_data->position.floor;
+        return (guard == GUARD_TARGET_FLOOR_ABOVE) ? (target > position) : (target < position);
+    }
 
-        if (p_elevator_data->last_dir == HARDWARE_MOVEMENT_UP) {
-            last_valid_floor++;
-            guards.TARGET_FLOOR_ABOVE = (target >= last_valid_floor);
-            guards.TARGET_FLOOR_BELOW = (target < last_valid_floor);   
-        }
-        if (p_elevator_data->last_dir == HARDWARE_MOVEMENT_DOWN) {
-            last_valid_floor--;
-            guards.TARGET_FLOOR_ABOVE = (target > last_valid_floor);
-            guards.TARGET_FLOOR_BELOW = (target <= last_valid_floor);   
-        }
+    return 0;
+}
+
+
+/**
+ * @brief Evaluate a single guard
+ */
+static int elevator_guard(elevator_data_t* p_elevator_data, elevator_guard_bit_t guard) {
+    switch(guard) {
+        case GUARD_TIMER_DONE:
+            // In emergency the guard waits for the stop-hold time; everywhere else for the door
+            return elevator_input(p_elevator_data, p_elevator_data->state == STATE_EMERGENCY ? INPUT_STOP_HOLD_DONE : INPUT_DOOR_TIMER_DONE);
+
+        case GUARD_DIRECTION:
+            return elevator_input(p_elevator_data, INPUT_ORDER_MATCH);
+
+        case GUARD_AT_FLOOR:
+            return (p_elevator_data->sensors.current_floor != BETWEEN_FLOORS);
 
+        case GUARD_NOT_AT_FLOOR:
+            return (p_elevator_data->sensors.current_floor == BETWEEN_FLOORS);
+
+        default:
+            return elevator_target_guard(p_elevator_data, guard, p_elevator_data->sensors.current_floor);
     }
+}
+
+
+elevator_guard_t elevator_update_guards(elevator_data_t* p_elevator_data) {
+    elevator_guard_t guards = { 0 };
+
+    guards.TIMER_DONE         = elevator_guard(p_elevator_data, GUARD_TIMER_DONE);
+    guards.DIRECTION          = elevator_guard(p_elevator_data, GUARD_DIRECTION);
+    guards.TARGET_FLOOR_ABOVE = elevator_guard(p_elevator_data, GUARD_TARGET_FLOOR_ABOVE);
+    guards.TARGET_FLOOR_EQUAL = elevator_guard(p_elevator_data, GUARD_TARGET_FLOOR_EQUAL);
+    guards.TARGET_FLOOR_BELOW = elevator_guard(p_elevator_data, GUARD_TARGET_FLOOR_BELOW);
+    guards.AT_FLOOR           = elevator_guard(p_elevator_data, GUARD_AT_FLOOR);
+    guards.NOT_AT_FLOOR       = elevator_guard(p_elevator_data, GUARD_NOT_AT_FLOOR);
 
     return guards;
 }
 
 
-elevator_event_t elevator_update_event(elevator_data_t* p_elevator_data) {
-    // Update truth values for all possible events
-    int queue_is_empty = queue_empty();
-    int target_floor_diff = check_floor_diff(QUEUE[0].target_floor, p_elevator_data->last_floor);
-    int floor_match = queue_check_order_match(get_current_floor(), p_elevator_data->last_dir);
-    int obstruction_state = hardware_read_obstruction_signal();
-    int stop_button_state = hardware_read_stop_signal();
-    int timer_done = timer_check(DOOR_TIME_REQ);
+unsigned int elevator_update_guard_mask(elevator_data_t* p_elevator_data, unsigned int consulted) {
+    unsigned int guard_mask = 0;
+
+    for(unsigned int remaining = consulted; remaining; remaining &= remaining - 1) {
+        elevator_guard_bit_t guard = remaining & -remaining;
+        if(elevator_guard(p_elevator_data, guard)) {
+            guard_mask |= guard;
+        }
+    }
+
+    return guard_mask;
+}
+
 
+elevator_event_t elevator_update_event(elevator_data_t* p_elevator_data) {
+    // Every input is evaluated on first use, so each state only pays for the events it checks for
     switch(p_elevator_data->state) {
         case STATE_IDLE: {
-            if(stop_button_state) {
+            if(p_elevator_data->sensors.stop) {
                 return EVENT_STOP_BUTTON_HIGH;
             }
-            if(queue_is_empty) {
+            if(elevator_input(p_elevator_data, INPUT_QUEUE_EMPTY)) {
                 return EVENT_QUEUE_EMPTY;
             }
-            if(!queue_is_empty) {
-                return EVENT_QUEUE_NOT_EMPTY;
-            }
-            break;
+            return EVENT_QUEUE_NOT_EMPTY;
         }                        
         case STATE_DOOR_OPEN: {
-            if(stop_button_state) {
+            if(p_elevator_data->sensors.stop) {
                 return EVENT_STOP_BUTTON_HIGH;
             }
-            if(obstruction_state) {
+            if(p_elevator_data->sensors.obstruction) {
                 return EVENT_OBSTRUCTION_HIGH;
             }
-            if(queue_is_empty && timer_done) {
+            if(elevator_input(p_elevator_data, INPUT_QUEUE_EMPTY) && elevator_input(p_elevator_data, INPUT_DOOR_TIMER_DONE)) {
                 return EVENT_QUEUE_EMPTY;
             }
-            if(target_floor_diff) {
+            if(check_floor_diff(elevator_input(p_elevator_data, INPUT_TARGET_FLOOR), p_elevator_data->last_floor)) {
                 return EVENT_TARGET_FLOOR_DIFF;
             }
             break;
         }
-        case STATE_MOVING_UP: {
-            if(stop_button_state) {
+        case STATE_MOVING_UP:
+        case STATE_MOVING_DOWN: {
+            if(p_elevator_data->sensors.stop) {
                 return EVENT_STOP_BUTTON_HIGH;
             }
-            if(floor_match) {
+            if(elevator_input(p_elevator_data, INPUT_ORDER_MATCH)) {
                 return EVENT_FLOOR_MATCH;
             }
-
             break;
-        }        
-        case STATE_MOVING_DOWN: {
-            if(stop_button_state) {
+        }             
+        case STATE_HOMING: {
+            if(p_elevator_data->sensors.stop) {
                 return EVENT_STOP_BUTTON_HIGH;
             }
-            if(floor_match) {
-                return EVENT_FLOOR_MATCH;
-            }
             break;
-        }             
+        }
         case STATE_EMERGENCY: {
-            if(stop_button_state) {
+            if(p_elevator_data->sensors.stop) {
                 hardware_command_stop_light(LIGHT_ON);
                 return EVENT_STOP_BUTTON_HIGH;
             }
-            if(!stop_button_state) {
-                hardware_command_stop_light(LIGHT_OFF);
-                return EVENT_STOP_BUTTON_LOW;
-            }
-            break;
+            hardware_command_stop_light(LIGHT_OFF);
+            return EVENT_STOP_BUTTON_LOW;
         } 
         default: {
             fprintf(stderr, "Default reached in elevator_event_handler; should not happen");
@@ -399,11 +543,39 @@ elevator_event_t elevator_update_event(elevator_data_t* p_elevator_data) {
 
 
 void failsafe_invalid_state(elevator_data_t* p_elevator_data) {
-    if(p_elevator_data->state == STATE_MOVING_UP && get_current_floor() == HARDWARE_NUMBER_OF_FLOORS - 1) {
+    if(p_elevator_data->state == STATE_IDLE && p_elevator_data->last_floor == FLOOR_NOT_INIT) {
+        p_elevator_data->state = STATE_HOMING;
+        p_elevator_data->last_dir = HARDWARE_MOVEMENT_DOWN;
+    }
+
+    if(p_elevator_data->state == STATE_MOVING_UP || p_elevator_data->state == STATE_MOVING_DOWN) {
+        if(p_elevator_data->sensors.current_floor != BETWEEN_FLOORS) {
+            timer_start(&p_elevator_data->timers, TIMER_MOTOR_TIMEOUT, MOTOR_TIMEOUT_NS);
+        }
+        else if(timer_check(&p_elevator_data->timers, TIMER_MOTOR_TIMEOUT)) {
+            fprintf(stderr, "No floor reached within the motor timeout; stopping the elevator\n");
+            p_elevator_data->state = STATE_EMERGENCY;
+        }
+    }
+    else if(p_elevator_data->state == STATE_HOMING) {
+        if(!timer_running(&p_elevator_data->timers, TIMER_MOTOR_TIMEOUT)) {
+            timer_start(&p_elevator_data->timers, TIMER_MOTOR_TIMEOUT, MOTOR_TIMEOUT_NS);
+        }
+        else if(timer_check(&p_elevator_data->timers, TIMER_MOTOR_TIMEOUT) && p_elevator_data->last_dir != HARDWARE_MOVEMENT_DOWN) {
+            fprintf(stderr, "No floor reached homing up within the motor timeout; homing down\n");
+            p_elevator_data->last_dir = HARDWARE_MOVEMENT_DOWN;
+            timer_start(&p_elevator_data->timers, TIMER_MOTOR_TIMEOUT, MOTOR_TIMEOUT_NS);
+        }
+    }
+    else {
+        timer_cancel(&p_elevator_data->timers, TIMER_MOTOR_TIMEOUT);
+    }
+
+    if(p_elevator_data->state == STATE_MOVING_UP && p_elevator_data->sensors.current_floor == HARDWARE_NUMBER_OF_FLOORS - 1) {
         p_elevator_data->state = STATE_IDLE;
     }
 
-    if(p_elevator_data->state == STATE_MOVING_DOWN && get_current_floor() == MIN_FLOOR) {
+    if(p_elevator_data->state == STATE_MOVING_DOWN && p_elevator_data->sensors.current_floor == MIN_FLOOR) {
         p_elevator_data->state = STATE_IDLE;
     }
 }
@@ -414,7 +586,206 @@ int check_floor_diff(int target_floor, int current_floor) {
 }
 
 
+/**
+ * @brief Drive the motor of a moving elevator along its speed profile, and tell the hardware's
+ * sampler where the elevator will stop next, so it can stop the motor on arrival
+ */
+static void elevator_command_motion(elevator_data_t* p_elevator_data) {
+    // Homing runs at the speed hardware_command_movement() starts the motor at, to the first floor reached
+    if(p_elevator_data->state == STATE_HOMING) {
+        motion_stop(&p_elevator_data->motion);
+        hardware_set_stop_floor(HARDWARE_STOP_FLOOR_NEXT);
+        return;
+    }
+    if(p_elevator_data->state != STATE_MOVING_UP && p_elevator_data->state != STATE_MOVING_DOWN) {
+        motion_stop(&p_elevator_data->motion);
+        hardware_set_stop_floor(HARDWARE_STOP_FLOOR_NONE);
+        return;
+    }
+
+    int up = (p_elevator_data->state == STATE_MOVING_UP);
+    int last_floor = p_elevator_data->last_floor;
+    int target = elevator_input(p_elevator_data, INPUT_TARGET_FLOOR);
+    int ahead = up ? (target > last_floor) : (target >= MIN_FLOOR && target < last_floor);
+
+    // The target may be the end of a sweep, with stops on the way to it
+    int passing = queue_nearest_passing_stop(&p_elevator_data->queue, last_floor,
+                                             up ? HARDWARE_MOVEMENT_UP : HARDWARE_MOVEMENT_DOWN);
+    if(ahead && passing != FLOOR_NOT_INIT && (up ? passing < target : passing > target)) {
+        target = passing;
+    }
+
+    // With nothing ahead, the elevator stops at the first floor it reaches
+    hardware_set_stop_floor(ahead ? target : HARDWARE_STOP_FLOOR_NEXT);
+    double distance = ahead ? position_distance_to(&p_elevator_data->position, target) : -1.0;
+    hardware_command_motor_speed(motion_update(&p_elevator_data->motion, distance));
+}
+
+
 void update_button_state(elevator_data_t* p_elevator_data){
-    update_cab_buttons(p_elevator_data->orders_cab);
-    update_floor_buttons(p_elevator_data->orders_up, p_elevator_data->orders_down);
+    update_order_buttons(&p_elevator_data->queue, p_elevator_data->in_group, p_elevator_data->p_demand);
+    update_order_lights(&p_elevator_data->queue, p_elevator_data->in_group);
+}
+
+
+/**
+ * @brief Give up parking once the elevator has an order, has arrived or has stopped
+ */
+static void elevator_update_parking(elevator_data_t* p_elevator_data) {
+    if(p_elevator_data->park_floor == FLOOR_NOT_INIT) {
+        return;
+    }
+    int moving = (p_elevator_data->state == STATE_MOVING_UP || p_elevator_data->state == STATE_MOVING_DOWN);
+    if(!queue_empty(&p_elevator_data->queue) || p_elevator_data->state == STATE_EMERGENCY ||
+       (!moving && p_elevator_data->sensors.current_floor == p_elevator_data->park_floor)) {
+        p_elevator_data->park_floor = FLOOR_NOT_INIT;
+    }
+}
+
+
+int elevator_ready_to_park(elevator_data_t* p_elevator_data) {
+    timer_set_t* p_timers = &p_elevator_data->timers;
+    if(p_elevator_data->state != STATE_IDLE || !queue_empty(&p_elevator_data->queue) ||
+       p_elevator_data->park_floor != FLOOR_NOT_INIT || p_elevator_data->sensors.current_floor == BETWEEN_FLOORS) {
+        timer_cancel(p_timers, TIMER_IDLE_PARK);
+        return 0;
+    }
+    if(!timer_running(p_timers, TIMER_IDLE_PARK)) {
+        timer_start(p_timers, TIMER_IDLE_PARK, DEMAND_PARK_DELAY_NS);
+        return 0;
+    }
+    if(!timer_check(p_timers, TIMER_IDLE_PARK)) {
+        return 0;
+    }
+    timer_start(p_timers, TIMER_IDLE_PARK, DEMAND_PARK_DELAY_NS);
+    return 1;
+}
+
+
+void elevator_park(elevator_data_t* p_elevator_data, int floor) {
+    if(floor != FLOOR_NOT_INIT && floor != p_elevator_data->sensors.current_floor) {
+        p_elevator_data->park_floor = floor;
+    }
+}
+
+
+/**
+ * @brief Save the elevator's snapshot, which only writes the file if it has changed
+ */
+static void elevator_save_snapshot(elevator_data_t* p_elevator_data) {
+    snapshot_state_t state;
+    memset(&state, 0, sizeof(state));
+    state.last_floor = p_elevator_data->last_floor;
+    state.last_dir = p_elevator_data->last_dir;
+    state.position_steps = (int32_t)lround(p_elevator_data->position.floor * SNAPSHOT_POSITION_STEPS);
+
+    Order orders[QUEUE_SIZE];
+    state.order_count = queue_get_orders(&p_elevator_data->queue, orders);
+    for(int i = 0; i < state.order_count; i++) {
+        state.orders[i] = orders[i].order_type * HARDWARE_NUMBER_OF_FLOORS + orders[i].target_floor;
+    }
+
+    const position_t* p_position = &p_elevator_data->position;
+    state.gain = p_position->gain;
+    state.gain_samples = p_position->gain_samples;
+    for(int f = 0; f < HARDWARE_NUMBER_OF_FLOORS; f++) {
+        state.pass_ns[f] = p_position->pass_ns[f];
+        state.hall_stops[f] = p_elevator_data->door.hall_stops[f];
+    }
+    state.floor_ns = p_position->floor_ns;
+    state.landing_ns[0] = p_position->landing_ns[0];
+    state.landing_ns[1] = p_position->landing_ns[1];
+    state.hall_total = p_elevator_data->door.hall_total;
+
+    snapshot_save(p_elevator_data->p_snapshot, p_elevator_data->car, &state);
+}
+
+
+/**
+ * @brief Publish the elevator's live state, which the controller makes no system call for
+ */
+static void elevator_publish_live(elevator_data_t* p_elevator_data) {
+    live_car_t car;
+    memset(&car, 0, sizeof(car));
+    car.time_ns = timer_now_ns();
+    car.position = p_elevator_data->position.floor;
+    car.state = p_elevator_data->state;
+    car.event = p_elevator_data->event;
+    car.action = p_elevator_data->next_action;
+    car.last_floor = p_elevator_data->last_floor;
+    car.current_floor = p_elevator_data->sensors.current_floor;
+    car.last_dir = p_elevator_data->last_dir;
+    car.park_floor = p_elevator_data->park_floor;
+    car.door_open = hardware_get_door_open();
+    car.motor_speed = hardware_get_motor_speed();
+    car.stop = p_elevator_data->sensors.stop;
+    car.obstruction = p_elevator_data->sensors.obstruction;
+
+    Order orders[QUEUE_SIZE];
+    car.order_count = queue_get_orders(&p_elevator_data->queue, orders);
+    for(int i = 0; i < car.order_count; i++) {
+        car.orders[i] = orders[i].order_type * HARDWARE_NUMBER_OF_FLOORS + orders[i].target_floor;
+    }
+
+    p_elevator_data->counters.io_calls = hardware_get_io_calls(p_elevator_data->car);
+    car.counters = p_elevator_data->counters;
+    live_publish(p_elevator_data->p_live, p_elevator_data->car, &car);
+}
+
+
+void elevator_print_homing(const elevator_data_t* p_elevator_data, FILE* stream) {
+    if(p_elevator_data->homing_ns < 0) {
+        fprintf(stream, "Homing car %d: not finished after %.3f s\n", p_elevator_data->car,
+                (timer_now_ns() - p_elevator_data->homing_started_ns) * 1e-9);
+    }
+    else if(p_elevator_data->homing_ns == 0) {
+        fprintf(stream, "Homing car %d: skipped, started at floor\n", p_elevator_data->car);
+    }
+    else {
+        fprintf(stream, "Homing car %d: %.3f s\n", p_elevator_data->car, p_elevator_data->homing_ns * 1e-9);
+    }
+}
+
+
+void elevator_begin_tick(elevator_data_t* p_elevator_data) {
+    hardware_sample_inputs();
+    p_elevator_data->sensors = read_sensors();
+    p_elevator_data->inputs.known = 0;
+}
+
+
+void elevator_tick(elevator_data_t* p_elevator_data) {
+    LATENCY_BEGIN(probe);
+    p_elevator_data->counters.ticks++;
+    elevator_begin_tick(p_elevator_data);
+
+    p_elevator_data->last_floor = update_valid_floor(&p_elevator_data->sensors, p_elevator_data->last_floor);
+    position_update(&p_elevator_data->position, p_elevator_data->sensors.current_floor,
+                    (p_elevator_data->state == STATE_MOVING_DOWN) ? -p_elevator_data->motion.speed : p_elevator_data->motion.speed);
+
+    set_floor_indicator_light(p_elevator_data->sensors.current_floor);
+    LATENCY_LAP(probe, LATENCY_SENSORS);
+    update_button_state(p_elevator_data);
+    elevator_update_parking(p_elevator_data);
+    if(p_elevator_data->p_demand != NULL && elevator_ready_to_park(p_elevator_data)) {
+        elevator_park(p_elevator_data, demand_park_floor(p_elevator_data->p_demand, NULL));
+    }
+    LATENCY_LAP(probe, LATENCY_BUTTONS);
+
+    p_elevator_data->next_action = elevator_update_state(p_elevator_data);
+    LATENCY_LAP(probe, LATENCY_UPDATE_STATE);
+    elevator_execute_next_action(p_elevator_data);
+    elevator_command_motion(p_elevator_data);
+    LATENCY_LAP(probe, LATENCY_EXECUTE);
+
+    hardware_flush_outputs();
+    LATENCY_LAP(probe, LATENCY_OUTPUTS);
+    if(p_elevator_data->p_snapshot != NULL) {
+        elevator_save_snapshot(p_elevator_data);
+    }
+    if(p_elevator_data->p_live != NULL) {
+        elevator_publish_live(p_elevator_data);
+    }
+    LATENCY_LAP(probe, LATENCY_PUBLISH);
+    LATENCY_END(probe);
 }
@@ -6,7 +6,19 @@
 #ifndef ELEVATOR_FSM_H
 #define ELEVATOR_FSM_H
 
+#include <stdint.h>
+#include <stdio.h>
+
 #include "driver/hardware.h"
+#include "demand.h"
+#include "door.h"
+#include "elevator_io.h"
+#include "live.h"
+#include "motion.h"
+#include "position.h"
+#include "queue.h"
+#include "snapshot.h"
+#include "timer.h"
 
 
 /**
@@ -17,7 +29,9 @@ typedef enum{
     STATE_DOOR_OPEN,            /**< Elevator's door is open, handling a floor order */
     STATE_MOVING_UP,            /**< Elevator moving up*/
     STATE_MOVING_DOWN,          /**< Elevator moving down*/
-    STATE_EMERGENCY             /**< Elevator !!EMERGENCY!!*/
+    STATE_EMERGENCY,            /**< Elevator !!EMERGENCY!!*/
+    STATE_HOMING,               /**< Elevator driving to the nearest floor, to find out where it is*/
+    STATE_COUNT                 /**< Number of states, not a state*/
 } elevator_state_t;
 
 
@@ -33,6 +47,7 @@ typedef enum{
     EVENT_STOP_BUTTON_HIGH,     /**< The stop button is high/is pressed in*/
     EVENT_STOP_BUTTON_LOW,      /**< The stop button is low/is not pressed in*/
     EVENT_NO_EVENT,             /**< No particular event has occured*/
+    EVENT_COUNT                 /**< Number of events, not an event*/
 } elevator_event_t;
 
 
@@ -66,6 +81,57 @@ typedef struct{
 } elevator_guard_t;
 
 
+/**
+ * Bits of a guard mask, one for every field of @c elevator_guard_t . The transition table
+ * matches guards as masks, so a transition is checked with two AND operations.
+ */
+typedef enum{
+    GUARD_TIMER_DONE         = 1 << 0,  /**< @c elevator_guard_t::TIMER_DONE */
+    GUARD_DIRECTION          = 1 << 1,  /**< @c elevator_guard_t::DIRECTION */
+    GUARD_TARGET_FLOOR_ABOVE = 1 << 2,  /**< @c elevator_guard_t::TARGET_FLOOR_ABOVE */
+    GUARD_TARGET_FLOOR_EQUAL = 1 << 3,  /**< @c elevator_guard_t::TARGET_FLOOR_EQUAL */
+    GUARD_TARGET_FLOOR_BELOW = 1 << 4,  /**< @c elevator_guard_t::TARGET_FLOOR_BELOW */
+    GUARD_AT_FLOOR           = 1 << 5,  /**< @c elevator_guard_t::AT_FLOOR */
+    GUARD_NOT_AT_FLOOR       = 1 << 6   /**< @c elevator_guard_t::NOT_AT_FLOOR */
+} elevator_guard_bit_t;
+
+#define GUARD_MASK_COUNT (1 << 7)       /**< Number of distinct guard masks */
+
+
+/**
+ * Enum for the inputs the events and guards are computed from. Each is evaluated at most
+ * once per tick, and only if the current state consults it.
+ */
+typedef enum{
+    INPUT_QUEUE_EMPTY,          /**< Whether the queue has no orders*/
+    INPUT_TARGET_FLOOR,         /**< The floor the dispatch policy picks next from the queue*/
+    INPUT_ORDER_MATCH,          /**< Whether the elevator should stop at the current floor*/
+    INPUT_DOOR_TIMER_DONE,      /**< Whether @c TIMER_DOOR is done*/
+    INPUT_STOP_HOLD_DONE,       /**< Whether @c TIMER_STOP_HOLD is done*/
+    INPUT_COUNT                 /**< Number of inputs, not an input*/
+} elevator_input_t;
+
+
+/**
+ * The inputs of the FSM evaluated so far in the current tick
+ */
+typedef struct{
+    unsigned int known;         /**< Bit @c (1 << input) is set once the @c elevator_input_t has been evaluated this tick*/
+    int value[INPUT_COUNT];     /**< Value of every evaluated input*/
+} elevator_inputs_t;
+
+
+/**
+ * One entry of the FSM's transition table, generated from UML_ELEVATOR_FINAL.drawio by tools/gen_fsm.py
+ */
+typedef struct{
+    uint8_t required;           /**< Guard bits that must be set for the transition to be taken*/
+    uint8_t forbidden;          /**< Guard bits that must be clear for the transition to be taken*/
+    uint8_t next_state;         /**< The @c elevator_state_t to go to*/
+    uint8_t action;             /**< The @c elevator_action_t to execute*/
+} elevator_transition_t;
+
+
 /**
  * A struct holding all the data related to the elevator 
  */
@@ -74,9 +140,25 @@ typedef struct{
     HardwareMovement last_dir;                  /**< The last direction the elevator was moving in*/
     elevator_state_t state;                     /**< The state of the elevator*/
     elevator_action_t next_action;              /**< The next action to be performed by the elevator*/
-    int orders_up[HARDWARE_NUMBER_OF_FLOORS];   /**< The elevator's orders going up*/
-    int orders_down[HARDWARE_NUMBER_OF_FLOORS]; /**< The elevator's orders going down*/
-    int orders_cab[HARDWARE_NUMBER_OF_FLOORS];  /**< The elevator's cab-orders.*/
+    elevator_event_t event;                     /**< The event of the current control cycle*/
+    queue_t queue;                              /**< The elevator's pending up, down and cab orders*/
+    timer_set_t timers;                         /**< The elevator's door, motor, stop and idle timers*/
+    elevator_sensors_t sensors;                 /**< The sensors as sampled at the start of the current tick*/
+    elevator_inputs_t inputs;                   /**< The inputs evaluated in the current tick*/
+    int in_group;                               /**< 1 if a group controller owns the hall buttons and lights, and assigns hall calls to the queue*/
+    queue_policy_t policy;                      /**< How the next target floor is picked from the queue*/
+    int car;                                    /**< The elevator's number in its group, or 0*/
+    motion_t motion;                            /**< The speed profile of the elevator's runs*/
+    position_t position;                        /**< Where the elevator is estimated to be, and its learned travel times*/
+    door_t door;                                /**< How long the door dwells at a stop, and the hall stops learned for it*/
+    int park_floor;                             /**< The floor the elevator is parking at while it has no orders, or @c FLOOR_NOT_INIT*/
+    demand_t* p_demand;                         /**< Model the elevator counts its hall calls in and parks by, or NULL. NULL in a group, which parks its cars*/
+    snapshot_t* p_snapshot;                     /**< Snapshots the elevator saves its state to at the end of every control cycle, or NULL*/
+    long long homing_started_ns;                /**< When the elevator was initialized*/
+    long long homing_ns;                        /**< How long homing took, 0 if the elevator started at a floor, or -1 while it homes*/
+    HardwareMovement run_dir;                   /**< The direction of the elevator's last run, or @c HARDWARE_MOVEMENT_STOP before the first*/
+    live_counters_t counters;                   /**< What the elevator has counted since it was initialized*/
+    live_t* p_live;                             /**< Segment the elevator publishes its live state in at the end of every control cycle, or NULL*/
 } elevator_data_t;
 
 
@@ -85,12 +167,35 @@ typedef struct{
  * 
  * @return Elevator data initialized to its default values.
  * 
- * Initiailize the elevator by setting all connected values to its default values, and, 
- * if the elevator isn't already at a floor, drive the elevator down to the first valid floor.
+ * Initiailize the elevator by setting all connected values to its default values. An elevator that
+ * isn't already at a floor starts in @c STATE_HOMING , and drives down to the first floor it reaches
+ * as the control cycles run.
  */
 elevator_data_t elevator_init();
 
 
+/**
+ * @brief Initialize the elevator from its snapshot, if the sensors agree with it
+ * 
+ * @param[out] p_elevator_data  The elevator data to initialize
+ * @param[in] p_snapshot        Snapshots the elevator restarts from and saves to, or NULL to initialize
+ *                              it as @c elevator_init() does
+ * @param[in] car               The elevator's number in its group, or 0
+ * 
+ * @return 1 if the elevator restarted warm, and 0 if not
+ * 
+ * An elevator standing at the floor of its snapshot takes back the orders it had accepted, in the
+ * order it accepted them, and the direction it last moved in. Its button lights are lit again on the
+ * first control cycle. Anywhere else, it starts without orders, and one between floors homes towards
+ * the floor nearest to the position of its snapshot. Either way it keeps the travel times and hall
+ * stops it had learned.
+ * 
+ * Homing runs in the control cycles, so the buttons are read and lit while it lasts. If no floor is
+ * reached within @c MOTOR_TIMEOUT_NS , homing goes on downwards.
+ */
+int elevator_init_from_snapshot(elevator_data_t* p_elevator_data, snapshot_t* p_snapshot, int car);
+
+
 /**
  * @brief Update the elevator state
  * 
@@ -98,13 +203,61 @@ elevator_data_t elevator_init();
  * 
  * @return One of the possible @c elevator_action_t resulting from the current state.
  * 
- * This function updates the elevator's state machine, and yields a resulting
- * function to be executed for any given state. It contains most of the logic flow
- * used to control the elevator's movements, depending on the given inputs.
+ * This function computes the event, runs the failsafe, computes the guards the transition
+ * table consults for the resulting state and event, and hands the result to @c elevator_take_transition() .
  */
 elevator_action_t elevator_update_state(elevator_data_t* p_elevator_data);
 
 
+/**
+ * @brief Run the actions of the current state and take the transition for @p event
+ * 
+ * @param[in, out] p_elevator_data     A pointer to the elevator data, updates on transitions.
+ * @param[in] event         The current event
+ * @param[in] guard_mask    The guards that hold, as @c elevator_guard_bit_t bits
+ * 
+ * @return The @c elevator_action_t of the transition
+ * 
+ * The transition is looked up with @c elevator_fsm_lookup() . The exit actions of the current
+ * state are run if the transition leaves it.
+ */
+elevator_action_t elevator_take_transition(elevator_data_t* p_elevator_data, elevator_event_t event, unsigned int guard_mask);
+
+
+/**
+ * @brief Find the transition the FSM takes from @p state on @p event
+ * 
+ * @param[in] state         The current state
+ * @param[in] event         The current event
+ * @param[in] guard_mask    The guards that hold, as @c elevator_guard_bit_t bits
+ * 
+ * @return The first transition of the generated table whose guards match @p guard_mask , or a
+ * transition back into @p state with @c ACTION_DO_NOTHING if there is none.
+ */
+elevator_transition_t elevator_fsm_lookup(elevator_state_t state, elevator_event_t event, unsigned int guard_mask);
+
+
+/**
+ * @brief Find the guards the FSM consults in @p state on @p event
+ * 
+ * @param[in] state         The current state
+ * @param[in] event         The current event
+ * 
+ * @return The @c elevator_guard_bit_t bits that appear in any transition of @p state on @p event
+ */
+unsigned int elevator_fsm_consulted_guards(elevator_state_t state, elevator_event_t event);
+
+
+/**
+ * @brief Pack the guards into a mask of @c elevator_guard_bit_t bits
+ * 
+ * @param[in] p_guards      The guards to pack
+ * 
+ * @return The bits of the guards that hold
+ */
+unsigned int elevator_guard_mask(const elevator_guard_t* p_guards);
+
+
 /**
  * @brief Execute the elevator's next action.
  * 
@@ -125,6 +278,17 @@ void elevator_execute_next_action(elevator_data_t* p_elevator_data);
 elevator_guard_t elevator_update_guards(elevator_data_t* p_elevator_data);
 
 
+/**
+ * @brief Calculate only the guards in @p consulted
+ * 
+ * @param[in] p_elevator_data   Pointer to an @c elevator_data_t that contains the required data to calculate the guards
+ * @param[in] consulted         The @c elevator_guard_bit_t bits to calculate
+ * 
+ * @return The bits of @p consulted whose guards hold. Bits outside @p consulted are 0.
+ */
+unsigned int elevator_update_guard_mask(elevator_data_t* p_elevator_data, unsigned int consulted);
+
+
 /**
  * @brief Calculate the next event, based on the elevator's current state @c elevator_data_t . The events will be used
  * to differentiate between the states in the fsm.
@@ -142,7 +306,9 @@ elevator_event_t elevator_update_event(elevator_data_t* p_elevator_data);
  * @param[in] p_elevator_data   Pointer to an @c elevator_data_t that contains the data needed to check for invalid states 
  *  
  * The function is meant to be used as extra protective measures before entering the FSM, by making sure that the elevator does not perform
- * any action it is not supposed to do.
+ * any action it is not supposed to do. This includes the motor watchdog: if the elevator has been moving for @c MOTOR_TIMEOUT_NS
+ * without reaching a floor, it is sent to @c STATE_EMERGENCY . An idle elevator that has never been at a floor, as after an emergency
+ * stop while homing, homes again.
  */
 void failsafe_invalid_state(elevator_data_t* p_elevator_data);
 
@@ -163,9 +329,65 @@ int check_floor_diff(int target_floor, int current_floor);
  * 
  * @param[in/out] p_elevator_data   Pointer to the @c elevator_data that contain the elevator's data
  * 
- * The function collectively polls and updates both the cab and floor buttons
+ * The function adds the orders of every pressed button to the queue, and updates the button
+ * lights whose orders were added or cleared since the last call. An elevator in a group only
+ * handles its cab buttons and lights.
  */
 void update_button_state(elevator_data_t* p_elevator_data);
 
 
+/**
+ * @brief Check whether the elevator should be sent to park now
+ * 
+ * @param[in/out] p_elevator_data   Pointer to the @c elevator_data that contain the elevator's data
+ * 
+ * @return 1 once the elevator has stood idle at a floor with no orders, and not parking, for
+ * @c DEMAND_PARK_DELAY_NS , and every @c DEMAND_PARK_DELAY_NS after that while it still does. 0 otherwise.
+ * 
+ * Should be called once per control cycle, since it keeps @c TIMER_IDLE_PARK running while the elevator is idle.
+ */
+int elevator_ready_to_park(elevator_data_t* p_elevator_data);
+
+
+/**
+ * @brief Send an idle elevator to park at @p floor
+ * 
+ * @param[in/out] p_elevator_data   Pointer to the @c elevator_data that contain the elevator's data
+ * @param[in] floor                 The floor to park at. The elevator stays where it is if this is
+ *                                  @c FLOOR_NOT_INIT or the floor it stands at.
+ * 
+ * The elevator drives to the floor as if it had an order there, without lighting a button. It opens
+ * its door on arrival, and gives up parking as soon as it gets an order.
+ */
+void elevator_park(elevator_data_t* p_elevator_data, int floor);
+
+
+/**
+ * @brief Print how long the elevator took to home after it was initialized, as a startup metric
+ * 
+ * @param[in] p_elevator_data   Pointer to the @c elevator_data that contain the elevator's data
+ * @param[in] stream            The stream to print to
+ */
+void elevator_print_homing(const elevator_data_t* p_elevator_data, FILE* stream);
+
+
+/**
+ * @brief Sample the inputs of a new control cycle
+ * 
+ * @param[in/out] p_elevator_data   Pointer to the @c elevator_data that contain the elevator's data
+ * 
+ * Samples the hardware once into @c elevator_data_t::sensors , which every decision of the
+ * cycle is made from, and forgets the inputs evaluated in the previous cycle.
+ */
+void elevator_begin_tick(elevator_data_t* p_elevator_data);
+
+
+/**
+ * @brief Run one control cycle: sample inputs, update the FSM and write outputs
+ * 
+ * @param[in/out] p_elevator_data   Pointer to the @c elevator_data that contain the elevator's data
+ */
+void elevator_tick(elevator_data_t* p_elevator_data);
+
+
 #endif //ELEVATOR_FSM_H
\ No newline at end of file
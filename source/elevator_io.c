@@ -1,10 +1,20 @@
+#include <stddef.h>
+
 #include "elevator_io.h"
 #include "globals.h"
-#include "queue.h"
 
 
-int update_valid_floor(int valid_floor) {
-    return (get_current_floor() == BETWEEN_FLOORS ? valid_floor : get_current_floor());
+elevator_sensors_t read_sensors() {
+    elevator_sensors_t sensors = { .current_floor = get_current_floor(),
+                                   .stop = hardware_read_stop_signal(),
+                                   .obstruction = hardware_read_obstruction_signal()
+                                 };
+    return sensors;
+}
+
+
+int update_valid_floor(const elevator_sensors_t* p_sensors, int valid_floor) {
+    return (p_sensors->current_floor == BETWEEN_FLOORS ? valid_floor : p_sensors->current_floor);
 }
 
 
@@ -16,42 +26,48 @@ void set_floor_indicator_light(int floor) {
 
 
 int get_current_floor() {
-    for(int floor = MIN_FLOOR; floor < HARDWARE_NUMBER_OF_FLOORS; floor++) {
-       if(hardware_read_floor_sensor(floor)) {
-           return floor;
-       }
-    }
-    return BETWEEN_FLOORS;
+    int floor = hardware_read_current_floor();
+    return (floor < MIN_FLOOR ? BETWEEN_FLOORS : floor);
 }
 
 
-void update_cab_buttons(int* p_orders_cab) {
-    for(int floor = MIN_FLOOR; floor < HARDWARE_NUMBER_OF_FLOORS; floor++) {
-        if(p_orders_cab[floor] == 0 && hardware_read_order(floor, HARDWARE_ORDER_INSIDE)) {
-            queue_push_back(floor, HARDWARE_ORDER_INSIDE);
-            p_orders_cab[floor] = 1;
+void update_order_buttons(queue_t* p_queue, int cab_only, demand_t* p_demand) {
+    int floors[QUEUE_SIZE];
+    HardwareOrder order_types[QUEUE_SIZE];
+    int pressed = hardware_read_pressed_orders(floors, order_types, QUEUE_SIZE);
+
+    // Cab orders are queued ahead of hall orders pressed in the same cycle
+    for(int i = 0; i < pressed; i++) {
+        if(order_types[i] == HARDWARE_ORDER_INSIDE) {
+            queue_push_back(p_queue, floors[i], HARDWARE_ORDER_INSIDE);
         }
-        hardware_command_order_light(floor, HARDWARE_ORDER_INSIDE, p_orders_cab[floor]);
+    }
+    for(int i = 0; i < pressed && !cab_only; i++) {
+        if(order_types[i] == HARDWARE_ORDER_INSIDE) {
+            continue;
+        }
+        if(p_demand != NULL && !queue_has_order(p_queue, floors[i], order_types[i])) {
+            demand_record(p_demand, floors[i], order_types[i]);
+        }
+        queue_push_back(p_queue, floors[i], order_types[i]);
     }
 }
 
 
-void update_floor_buttons(int* p_orders_up, int* p_orders_down) {
-    // The last floor does not have an up-button: Start at 0.
-    for(int floor_up = MIN_FLOOR; floor_up < HARDWARE_NUMBER_OF_FLOORS - 1; floor_up++) {
-        if(p_orders_up[floor_up] == 0 && hardware_read_order(floor_up, HARDWARE_ORDER_UP) == 1){
-            queue_push_back(floor_up, HARDWARE_ORDER_UP);
-            p_orders_up[floor_up] = 1;
+void update_order_lights(queue_t* p_queue, int cab_only) {
+    for(int type = 0; type < QUEUE_ORDER_TYPES; type++) {
+        if(cab_only && type != HARDWARE_ORDER_INSIDE) {
+            continue;
         }
-        hardware_command_order_light(floor_up, HARDWARE_ORDER_UP, p_orders_up[floor_up]);
-    }
-
-    // The first floor does not have a down-button: Start at 1.
-    for(int floor_down = MIN_FLOOR + 1; floor_down < HARDWARE_NUMBER_OF_FLOORS; floor_down++) {
-        if(p_orders_down[floor_down] == 0 && hardware_read_order(floor_down, HARDWARE_ORDER_DOWN) == 1){
-            queue_push_back(floor_down, HARDWARE_ORDER_DOWN);
-            p_orders_down[floor_down] = 1;
+        for(int word = 0; word < QUEUE_WORDS; word++) {
+            uint64_t changed = p_queue->pending[type][word] ^ p_queue->lit[type][word];
+            while(changed) {
+                int bit = __builtin_ctzll(changed);
+                int floor = word * QUEUE_WORD_BITS + bit;
+                hardware_command_order_light(floor, type, queue_has_order(p_queue, floor, type));
+                changed &= changed - 1;
+            }
+            p_queue->lit[type][word] = p_queue->pending[type][word];
         }
-        hardware_command_order_light(floor_down, HARDWARE_ORDER_DOWN, p_orders_down[floor_down]);
     }
-}
\ No newline at end of file
+}
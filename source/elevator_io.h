@@ -5,18 +5,44 @@
 #ifndef ELEVATOR_IO_H
 #define ELEVATOR_IO_H
 
+#include "demand.h"
+#include "queue.h"
+
+
+/**
+ * The elevator's sensors as seen by one control cycle. They are read once at the start of the
+ * cycle, so every decision in it agrees on where the elevator is.
+ */
+typedef struct{
+    int current_floor;      /**< The floor the elevator is at, or @c BETWEEN_FLOORS */
+    int stop;               /**< 1 if the stop button is pressed in, 0 if not */
+    int obstruction;        /**< 1 if the obstruction switch is high, 0 if not */
+} elevator_sensors_t;
+
+
+/**
+ * @brief Read the elevator's sensors from the latest input sample
+ * 
+ * @return The current floor, stop button and obstruction switch
+ * 
+ * The floor sensors are scanned once per call, so this should be called once per control cycle,
+ * after @c hardware_sample_inputs() , and the result passed on to whatever needs it.
+ */
+elevator_sensors_t read_sensors();
+
 
 /**
  * @brief Updates the a floor value to a valid floor
  * 
- * @param[in] floor     The last valid floor
+ * @param[in] p_sensors     The sensors of the current cycle
+ * @param[in] valid_floor   The last valid floor
  * 
  * @return A new valid floor if the elevator is at a valid floor, and @p valid_floor if the
  * elevator is between floors.
  * 
  * @warning Correct usage of this function requires @p valid_floor to actually be a valid floor. 
  */
-int update_valid_floor(int valid_floor);
+int update_valid_floor(const elevator_sensors_t* p_sensors, int valid_floor);
 
 
 /**
@@ -43,29 +69,29 @@ int get_current_floor();
 
 
 /**
- * @brief Polls the cab buttons, and updates the cab orders for the current input
+ * @brief Adds an order to the queue for every button pressed in the latest input sample
  * 
- * @param[in, out] p_orders_cab      A pointer to an array of the cab-button states
+ * @param[in, out] p_queue      A pointer to the queue the orders are added to
+ * @param[in] cab_only          1 to only read the cab buttons, when the hall buttons belong to a group controller
+ * @param[in, out] p_demand     Model that every new hall order is counted in, or NULL
+ * 
+ * Only the pressed buttons are visited, so the cost does not grow with the number of floors.
+ * Orders already in @p p_queue are left where they are. Cab orders pressed in the same cycle
+ * as hall orders are queued first.
  */
-void update_cab_buttons(int* p_orders_cab);
+void update_order_buttons(queue_t* p_queue, int cab_only, demand_t* p_demand);
 
 
 /**
- * @brief Updates the floor buttons based on current input
- * 
- * @param[in, out] p_orders_up      A pointer to an array of the up-button states
- * @param[in, out] p_orders_down    A pointer to an array of the down-button states
- * 
- * @warning This function operates on the assumption that @p p_orders_up and @p p_orders_down are 
- * set with 0's and 1's, respectively for "button not clicked" and "button clicked"
+ * @brief Sets every button light to whether its order is in the queue
  * 
- * @warning This function also uses @c hardware_command_order_light() to set the button lights
+ * @param[in, out] p_queue      A pointer to the queue whose orders are shown
+ * @param[in] cab_only          1 to only set the cab lights, when the hall lights belong to a group controller
  * 
- * The function checks every external elevator button, from the first floor to the last floor.
- * Upon finding a button that is clicked, that has not already been clicked ( by checking
- * the @p p_orders_up and @p p_orders_down arrays), the corresponding value in the array is set to 1.
+ * Only lights whose order was added or cleared since the last call are commanded, found by
+ * comparing the pending bits of @p p_queue with the bits it last showed.
  */
-void update_floor_buttons(int* p_orders_up, int* p_orders_down);
+void update_order_lights(queue_t* p_queue, int cab_only);
 
 
 #endif //ELEVATOR_IO_H
\ No newline at end of file
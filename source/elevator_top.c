@@ -0,0 +1,175 @@
+/**
+ * @file
+ * @brief Shows the live state of a running controller, from the segment it publishes with -l.
+ *
+ * Every interval, the record of every car is copied out of the segment as live.h describes and
+ * shown with the rates of its counters since the last interval. The segment is only mapped for
+ * reading, so the controller is not slowed down or stopped however often it is read. A segment
+ * whose controller is no longer running is shown as such, with the state its cars were left in.
+ *
+ * Usage: elevator-top [-i interval_ms] [-1] [live_segment], with the segment @c LIVE_NAME by
+ * default. With -1, the cars are shown once, without clearing the screen.
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "elevator_fsm.h"
+#include "globals.h"
+#include "live.h"
+
+
+#define TOP_INTERVAL_MS 500     /**< Default time between two screens */
+
+
+static const char* const top_state_names[STATE_COUNT] = {
+    [STATE_IDLE] = "idle",
+    [STATE_DOOR_OPEN] = "door open",
+    [STATE_MOVING_UP] = "moving up",
+    [STATE_MOVING_DOWN] = "moving down",
+    [STATE_EMERGENCY] = "emergency",
+    [STATE_HOMING] = "homing"
+};
+
+static const char* const top_event_names[EVENT_COUNT] = {
+    [EVENT_QUEUE_EMPTY] = "queue empty",
+    [EVENT_QUEUE_NOT_EMPTY] = "queue not empty",
+    [EVENT_TARGET_FLOOR_DIFF] = "target floor diff",
+    [EVENT_FLOOR_MATCH] = "floor match",
+    [EVENT_OBSTRUCTION_HIGH] = "obstruction high",
+    [EVENT_STOP_BUTTON_HIGH] = "stop button high",
+    [EVENT_STOP_BUTTON_LOW] = "stop button low",
+    [EVENT_NO_EVENT] = "no event"
+};
+
+static const char* const top_action_names[] = {
+    [ACTION_DO_NOTHING] = "-",
+    [ACTION_START_DOOR_TIMER] = "start door timer",
+    [ACTION_OPEN_DOOR] = "open door",
+    [ACTION_CLOSE_DOOR] = "close door",
+    [ACTION_MOVE_UP] = "move up",
+    [ACTION_MOVE_DOWN] = "move down",
+    [ACTION_STOP_MOVEMENT] = "stop movement",
+    [ACTION_EMERGENCY] = "emergency"
+};
+
+
+static const char* top_name(const char* const* names, int count, int value) {
+    return (value >= 0 && value < count && names[value] != NULL) ? names[value] : "?";
+}
+
+
+static long long top_now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+
+/**
+ * @brief Print the pending orders of @p p_car as floor and type, such as 3^ 0v 2c
+ */
+static void top_print_orders(const live_car_t* p_car, FILE* stream) {
+    static const char type_marks[] = { [HARDWARE_ORDER_UP] = '^', [HARDWARE_ORDER_INSIDE] = 'c', [HARDWARE_ORDER_DOWN] = 'v' };
+    if(p_car->order_count == 0) {
+        fprintf(stream, " -");
+    }
+    for(int i = 0; i < p_car->order_count && i < QUEUE_SIZE; i++) {
+        int slot = p_car->orders[i];
+        int type = slot / HARDWARE_NUMBER_OF_FLOORS;
+        fprintf(stream, " %d%c", slot % HARDWARE_NUMBER_OF_FLOORS, (type >= 0 && type < 3) ? type_marks[type] : '?');
+    }
+    fprintf(stream, "\n");
+}
+
+
+static void top_print_car(int car, const live_car_t* p_car, const live_counters_t* p_before, double seconds, FILE* stream) {
+    const live_counters_t* p_counters = &p_car->counters;
+    char floor[16];
+    if(p_car->current_floor == BETWEEN_FLOORS) {
+        snprintf(floor, sizeof(floor), "%.2f", p_car->position);
+    }
+    else {
+        snprintf(floor, sizeof(floor), "%d", p_car->current_floor);
+    }
+
+    fprintf(stream, "car %-2d %-11s floor %-5s door %-6s motor %5d%s%s  event %s, action %s\n", car,
+            top_name(top_state_names, STATE_COUNT, p_car->state), floor, p_car->door_open ? "open" : "closed",
+            p_car->motor_speed, p_car->stop ? "  STOP" : "", p_car->obstruction ? "  OBSTRUCTION" : "",
+            top_name(top_event_names, EVENT_COUNT, p_car->event),
+            top_name(top_action_names, sizeof(top_action_names) / sizeof(top_action_names[0]), p_car->action));
+    fprintf(stream, "       ticks %llu (%.0f/s)  io calls %llu (%.0f/s)  trips %llu  door cycles %llu  emergency stops %llu  reversals %llu\n",
+            (unsigned long long)p_counters->ticks, seconds > 0.0 ? (p_counters->ticks - p_before->ticks) / seconds : 0.0,
+            (unsigned long long)p_counters->io_calls, seconds > 0.0 ? (p_counters->io_calls - p_before->io_calls) / seconds : 0.0,
+            (unsigned long long)p_counters->trips, (unsigned long long)p_counters->door_cycles,
+            (unsigned long long)p_counters->emergency_stops, (unsigned long long)p_counters->motor_reversals);
+    fprintf(stream, "       orders");
+    top_print_orders(p_car, stream);
+}
+
+
+int main(int argc, char** argv) {
+    int interval_ms = TOP_INTERVAL_MS;
+    int once = 0;
+    int opt;
+    while((opt = getopt(argc, argv, "i:1")) != -1) {
+        if(opt == 'i' && atoi(optarg) > 0) {
+            interval_ms = atoi(optarg);
+        }
+        else if(opt == '1') {
+            once = 1;
+        }
+        else {
+            fprintf(stderr, "Usage: %s [-i interval_ms] [-1] [live_segment]\n", argv[0]);
+            exit(1);
+        }
+    }
+    const char* name = (optind < argc) ? argv[optind] : LIVE_NAME;
+
+    const live_segment_t* p_segment = live_attach(name);
+    if(p_segment == NULL) {
+        fprintf(stderr, "No live segment %s of this building; start the controller with -l %s\n", name, name);
+        exit(1);
+    }
+
+    live_counters_t before[HARDWARE_MAX_CARS];
+    memset(before, 0, sizeof(before));
+    long long before_ns = 0;
+    int cars = (p_segment->cars > 0 && p_segment->cars <= HARDWARE_MAX_CARS) ? p_segment->cars : 0;
+
+    for(;;) {
+        long long now = top_now_ns();
+        double seconds = (before_ns > 0) ? (now - before_ns) * 1e-9 : 0.0;
+        // Signal 0 only checks that the process exists
+        int running = (kill(p_segment->pid, 0) == 0 || errno == EPERM);
+
+        if(!once) {
+            printf("\033[H\033[2J");
+        }
+        printf("%s: controller %d%s, %d cars, %s of %d floors\n\n", name, p_segment->pid, running ? "" : " (not running)",
+               cars, BUILDING_NAME, HARDWARE_NUMBER_OF_FLOORS);
+        for(int car = 0; car < cars; car++) {
+            live_car_t copy;
+            if(live_read(p_segment, car, &copy) != 0) {
+                printf("car %-2d -\n", car);
+                continue;
+            }
+            top_print_car(car, &copy, &before[car], seconds, stdout);
+            before[car] = copy.counters;
+        }
+        fflush(stdout);
+        if(once) {
+            return 0;
+        }
+
+        before_ns = now;
+        struct timespec interval = { .tv_sec = interval_ms / 1000, .tv_nsec = (interval_ms % 1000) * 1000000L };
+        nanosleep(&interval, NULL);
+    }
+}
@@ -6,17 +6,27 @@
 #define GLOBALS_H
 
 
-#define QUEUE_SIZE 16       /** Size of the QUEUE. Mathematical impossible to have more than 10 orders for this elevator, but 16 is a power of 2 :), and it is better to be on the safe side. */
-
 #define MIN_FLOOR 0         /**The bottom floor that the elevator runs to. Note that this is 0-indexed, meaning that the lowest floor is always 0 */
 
-#define DOOR_TIME_REQ 3.0   /** Macro for the standard amount of time, in seconds, that the door should stay open*/
+#define DOOR_TIME_NS 3000000000LL       /** Macro for the standard amount of time, in nanoseconds, that the door should stay open*/
+#define STOP_HOLD_TIME_NS 3000000000LL  /** Macro for the time, in nanoseconds, the elevator stays in emergency after the stop button is released*/
+#define MOTOR_TIMEOUT_NS 10000000000LL  /** Macro for the longest time, in nanoseconds, the motor may run without the elevator reaching a floor */
 #define DOOR_CLOSE 0        /** Macro for door closed/close door */
 #define DOOR_OPEN 1         /** Macro for door open/open door */
 
 #define LIGHT_OFF 0         /** Macro for light off */
 #define LIGHT_ON 1          /** Macro for light on */
 
+#define CONTROL_RATE_HZ 200 /** Default number of control cycles per second. Can be overridden with the -r flag */
+#define SAMPLE_RATE_HZ 1000 /** Default number of input samples per second of the sampler thread. Can be overridden with the -s flag; 0 samples once per control cycle */
+
+#define MOTOR_SPEED_MAX 4095       /** Full scale of the motor's 12-bit DAC */
+#define MOTOR_CRUISE_SPEED 4000    /** Default motor speed between floors, as a DAC value. Can be overridden with the -m flag */
+#define MOTOR_LANDING_SPEED 2800   /** Motor speed over the last floor before a stop, which the floor sensors stop the elevator accurately from */
+#define MOTOR_RAMP_PER_S 14000     /** Most the motor speed changes by in a second, as a DAC value */
+#define MOTOR_LANDING_FLOORS 0.5   /** How far from a stop the motor slows down to the landing speed, in floors */
+#define FLOOR_TRAVEL_TIME_NS 2500000000LL  /** Time to travel one floor at the landing speed, until the elevator has learned its travel times */
+
 #define BETWEEN_FLOORS -1   /** Macro for the elevator being between floors */
 #define FLOOR_NOT_INIT -2   /** Macro for invalid order */
 
@@ -0,0 +1,390 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "group.h"
+#include "globals.h"
+#include "timer.h"
+
+
+/**
+ * @brief The direction a car is committed to: 1 for up, -1 for down and 0 if it has nothing to do
+ */
+static int group_car_direction(const elevator_data_t* p_car) {
+    if(p_car->state == STATE_MOVING_UP) {
+        return 1;
+    }
+    if(p_car->state == STATE_MOVING_DOWN) {
+        return -1;
+    }
+
+    int target = queue_next_target(&p_car->queue, p_car->policy, p_car->last_floor, p_car->last_dir);
+    if(target == FLOOR_NOT_INIT || target == p_car->last_floor) {
+        return 0;
+    }
+    return (target > p_car->last_floor) ? 1 : -1;
+}
+
+
+/**
+ * @brief Number of floors with an order strictly between @p from and @p to, whose expected dwell is added to @p p_dwell_ns
+ */
+static int group_stops_between(const elevator_data_t* p_car, int from, int to, long long* p_dwell_ns) {
+    HardwareMovement movement = (to > from) ? HARDWARE_MOVEMENT_UP : HARDWARE_MOVEMENT_DOWN;
+    int stops = 0;
+    int stop = from;
+    while(abs(to - stop) >= 2 && (stop = queue_nearest_stop(&p_car->queue, stop, movement)) != FLOOR_NOT_INIT
+          && (to - stop) * (to - from) > 0) {
+        stops++;
+        *p_dwell_ns += door_expected_dwell_ns(&p_car->door, &p_car->queue, stop);
+    }
+    return stops;
+}
+
+
+long long group_eta(const group_t* p_group, int car, int floor, HardwareOrder order_type) {
+    const elevator_data_t* p_car = &p_group->cars[car];
+    if(p_car->state == STATE_EMERGENCY || p_car->state == STATE_HOMING) {
+        return GROUP_ETA_NEVER;
+    }
+
+    int direction = group_car_direction(p_car);
+    int position = p_car->last_floor;
+    // Between floors the car can no longer stop at the floor it left
+    if(p_car->sensors.current_floor == BETWEEN_FLOORS) {
+        position += direction;
+    }
+    const position_t* p_estimate = &p_car->position;
+
+    long long eta = 0;
+    if(p_car->state == STATE_DOOR_OPEN) {
+        eta += timer_remaining_ns(&p_car->timers, TIMER_DOOR);
+    }
+
+    int call_direction = (order_type == HARDWARE_ORDER_UP) ? 1 : -1;
+    int ahead = (floor - position) * direction >= 0;
+    HardwareMovement movement = (direction > 0) ? HARDWARE_MOVEMENT_UP : HARDWARE_MOVEMENT_DOWN;
+    int turn = (direction != 0) ? queue_farthest_stop(&p_car->queue, position, movement) : FLOOR_NOT_INIT;
+    int beyond = (turn != FLOOR_NOT_INIT) && (turn - floor) * direction > 0;
+
+    int floors;
+    int stops;
+    long long travel;
+    long long dwell = 0;
+    if(direction == 0 || (ahead && (call_direction == direction || !beyond))) {
+        floors = abs(floor - position);
+        stops = group_stops_between(p_car, position, floor, &dwell);
+        travel = position_travel_ns(p_estimate, p_estimate->floor, floor);
+    }
+    else {
+        // Served on the way back, after the last stop in the car's direction
+        if(turn == FLOOR_NOT_INIT) {
+            turn = position;
+        }
+        floors = abs(turn - position) + abs(turn - floor);
+        stops = group_stops_between(p_car, position, turn, &dwell) + group_stops_between(p_car, turn, floor, &dwell);
+        if(turn != position) {
+            stops++;
+            dwell += door_expected_dwell_ns(&p_car->door, &p_car->queue, turn);
+        }
+        travel = position_travel_ns(p_estimate, p_estimate->floor, turn) + position_travel_ns(p_estimate, turn, floor);
+    }
+
+    // Every stop on the way splits the travel into one more run, which starts and lands
+    int runs = (floors > 0) ? stops + 1 : 0;
+    if(runs > 0) {
+        travel += runs * position_landing_ns(p_estimate, floors / runs);
+    }
+    return eta + travel + dwell;
+}
+
+
+static int group_pick_car(const group_t* p_group, int floor, HardwareOrder order_type) {
+    int best = 0;
+    long long best_cost = GROUP_ETA_NEVER + 1;
+
+    for(int car = 0; car < p_group->car_count; car++) {
+        const elevator_data_t* p_car = &p_group->cars[car];
+        long long cost;
+        if(p_group->policy == GROUP_POLICY_NEAREST) {
+            cost = (p_car->state == STATE_EMERGENCY || p_car->state == STATE_HOMING) ? GROUP_ETA_NEVER : abs(p_car->last_floor - floor);
+        }
+        else {
+            cost = group_eta(p_group, car, floor, order_type);
+        }
+
+        if(cost < best_cost) {
+            best = car;
+            best_cost = cost;
+        }
+    }
+    return best;
+}
+
+
+static void group_assign(group_t* p_group, group_call_t* p_call, int car) {
+    p_call->car = car;
+    queue_push_back(&p_group->cars[car].queue, p_call->floor, p_call->order_type);
+}
+
+
+static void group_take_hall_calls(group_t* p_group) {
+    int floors[QUEUE_SIZE];
+    HardwareOrder order_types[QUEUE_SIZE];
+    int pressed = hardware_read_pressed_orders(floors, order_types, QUEUE_SIZE);
+
+    uint64_t held[2][QUEUE_WORDS] = { { 0 } };
+    for(int i = 0; i < pressed; i++) {
+        if(order_types[i] == HARDWARE_ORDER_INSIDE) {
+            continue;
+        }
+
+        // A button held down makes one call, not one for every tick it is held
+        int direction = (order_types[i] == HARDWARE_ORDER_DOWN);
+        uint64_t bit = (uint64_t)1 << (floors[i] % QUEUE_WORD_BITS);
+        held[direction][floors[i] / QUEUE_WORD_BITS] |= bit;
+        if(p_group->held[direction][floors[i] / QUEUE_WORD_BITS] & bit) {
+            continue;
+        }
+
+        int is_new = 1;
+        for(int call = 0; call < p_group->call_count && is_new; call++) {
+            is_new = !(p_group->calls[call].floor == floors[i] && p_group->calls[call].order_type == order_types[i]);
+        }
+        if(!is_new) {
+            continue;
+        }
+
+        group_call_t* p_call = &p_group->calls[p_group->call_count++];
+        p_call->floor = floors[i];
+        p_call->order_type = order_types[i];
+        p_call->pressed_ns = timer_now_ns();
+        group_assign(p_group, p_call, group_pick_car(p_group, floors[i], order_types[i]));
+
+        hardware_command_order_light(floors[i], order_types[i], LIGHT_ON);
+        p_group->stats.calls++;
+        if(p_group->p_demand != NULL) {
+            demand_record(p_group->p_demand, floors[i], order_types[i]);
+        }
+    }
+
+    memcpy(p_group->held, held, sizeof(held));
+}
+
+
+static void group_clear_served_calls(group_t* p_group) {
+    for(int call = 0; call < p_group->call_count;) {
+        group_call_t* p_call = &p_group->calls[call];
+        elevator_data_t* p_car = &p_group->cars[p_call->car];
+
+        if(queue_has_order(&p_car->queue, p_call->floor, p_call->order_type)) {
+            call++;
+            continue;
+        }
+
+        if(p_car->state != STATE_DOOR_OPEN || p_car->sensors.current_floor != p_call->floor) {
+            // The car dropped the call without serving it
+            int car = group_pick_car(p_group, p_call->floor, p_call->order_type);
+            p_group->stats.reassigned += (car != p_call->car);
+            group_assign(p_group, p_call, car);
+            call++;
+            continue;
+        }
+
+        long long wait_ns = timer_now_ns() - p_call->pressed_ns;
+        p_group->stats.served++;
+        p_group->stats.wait_sum_ns += wait_ns;
+        if(wait_ns > p_group->stats.wait_max_ns) {
+            p_group->stats.wait_max_ns = wait_ns;
+        }
+        hardware_command_order_light(p_call->floor, p_call->order_type, LIGHT_OFF);
+        if(p_group->on_served != NULL) {
+            p_group->on_served(p_group->on_served_arg, p_call->car, p_call);
+        }
+
+        *p_call = p_group->calls[--p_group->call_count];
+    }
+}
+
+
+static void group_reevaluate(group_t* p_group) {
+    for(int call = 0; call < p_group->call_count; call++) {
+        group_call_t* p_call = &p_group->calls[call];
+
+        int best = group_pick_car(p_group, p_call->floor, p_call->order_type);
+        if(best == p_call->car) {
+            continue;
+        }
+
+        long long current_eta = group_eta(p_group, p_call->car, p_call->floor, p_call->order_type);
+        if(group_eta(p_group, best, p_call->floor, p_call->order_type) + GROUP_REASSIGN_MARGIN_NS < current_eta) {
+            queue_remove(&p_group->cars[p_call->car].queue, p_call->floor, p_call->order_type);
+            group_assign(p_group, p_call, best);
+            p_group->stats.reassigned++;
+        }
+    }
+}
+
+
+/**
+ * @brief Park the cars that have stood idle long enough, each at a floor no other car stands or parks at
+ */
+static void group_park_idle_cars(group_t* p_group) {
+    int cars_at[HARDWARE_NUMBER_OF_FLOORS] = { 0 };
+    for(int car = 0; car < p_group->car_count; car++) {
+        const elevator_data_t* p_car = &p_group->cars[car];
+        if(p_car->park_floor != FLOOR_NOT_INIT) {
+            cars_at[p_car->park_floor]++;
+        }
+        else if(p_car->state == STATE_IDLE && queue_empty(&p_car->queue) && p_car->sensors.current_floor != BETWEEN_FLOORS) {
+            cars_at[p_car->sensors.current_floor]++;
+        }
+    }
+
+    for(int car = 0; car < p_group->car_count; car++) {
+        elevator_data_t* p_car = &p_group->cars[car];
+        if(!elevator_ready_to_park(p_car)) {
+            continue;
+        }
+        int floor = p_car->sensors.current_floor;
+        cars_at[floor]--;
+        elevator_park(p_car, demand_park_floor(p_group->p_demand, cars_at));
+        cars_at[(p_car->park_floor != FLOOR_NOT_INIT) ? p_car->park_floor : floor]++;
+    }
+}
+
+
+int group_init(group_t* p_group, int car_count, group_policy_t policy) {
+    return (group_init_from_snapshot(p_group, car_count, policy, NULL) < 0) ? -1 : 0;
+}
+
+
+/**
+ * @brief Make the hall orders a car restarted with pending calls of the group again
+ */
+static void group_restore_hall_calls(group_t* p_group, const snapshot_t* p_snapshot, int car) {
+    elevator_data_t* p_car = &p_group->cars[car];
+    const snapshot_state_t* p_state = snapshot_restored(p_snapshot, car);
+    Order orders[QUEUE_SIZE];
+    int order_count = queue_get_orders(&p_car->queue, orders);
+
+    for(int i = 0; i < order_count; i++) {
+        int floor = orders[i].target_floor;
+        HardwareOrder order_type = orders[i].order_type;
+        if(order_type == HARDWARE_ORDER_INSIDE) {
+            continue;
+        }
+
+        int is_new = 1;
+        for(int call = 0; call < p_group->call_count && is_new; call++) {
+            is_new = !(p_group->calls[call].floor == floor && p_group->calls[call].order_type == order_type);
+        }
+        if(!is_new) {
+            queue_remove(&p_car->queue, floor, order_type);
+            continue;
+        }
+
+        group_call_t* p_call = &p_group->calls[p_group->call_count++];
+        p_call->floor = floor;
+        p_call->order_type = order_type;
+        p_call->car = car;
+        p_call->pressed_ns = snapshot_timer_ns(p_snapshot, p_state->accepted_ns[order_type * HARDWARE_NUMBER_OF_FLOORS + floor]);
+        hardware_command_order_light(floor, order_type, LIGHT_ON);
+    }
+}
+
+
+int group_init_from_snapshot(group_t* p_group, int car_count, group_policy_t policy, snapshot_t* p_snapshot) {
+    p_group->car_count = car_count;
+    p_group->policy = policy;
+    p_group->call_count = 0;
+    memset(p_group->held, 0, sizeof(p_group->held));
+    p_group->reevaluate_at_ns = 0;
+    p_group->stats = (group_stats_t){ 0 };
+    p_group->on_served = NULL;
+    p_group->on_served_arg = NULL;
+    p_group->p_demand = NULL;
+
+    int warm = 0;
+    for(int car = 0; car < car_count; car++) {
+        if(hardware_select_car(car) != 0 || hardware_init() != 0) {
+            return -1;
+        }
+        warm += elevator_init_from_snapshot(&p_group->cars[car], p_snapshot, car);
+        p_group->cars[car].in_group = 1;
+    }
+
+    if(p_snapshot != NULL) {
+        // The hall buttons and lights are on the first car's I/O
+        hardware_select_car(0);
+        for(int car = 0; car < car_count; car++) {
+            group_restore_hall_calls(p_group, p_snapshot, car);
+        }
+        hardware_flush_outputs();
+    }
+    return warm;
+}
+
+
+void group_tick(group_t* p_group) {
+    for(int car = 0; car < p_group->car_count; car++) {
+        hardware_select_car(car);
+        elevator_tick(&p_group->cars[car]);
+    }
+
+    // The hall buttons and lights are on the first car's I/O
+    hardware_select_car(0);
+    group_take_hall_calls(p_group);
+    group_clear_served_calls(p_group);
+    if(p_group->p_demand != NULL) {
+        group_park_idle_cars(p_group);
+    }
+
+    if(p_group->policy == GROUP_POLICY_ETA && timer_now_ns() >= p_group->reevaluate_at_ns) {
+        group_reevaluate(p_group);
+        p_group->reevaluate_at_ns = timer_now_ns() + GROUP_REEVALUATE_NS;
+    }
+
+    hardware_flush_outputs();
+}
+
+
+long long group_until_next_deadline(group_t* p_group) {
+    long long next = -1;
+    for(int car = 0; car < p_group->car_count; car++) {
+        long long until = timer_until_next_deadline(&p_group->cars[car].timers);
+        if(until >= 0 && (next < 0 || until < next)) {
+            next = until;
+        }
+    }
+    return next;
+}
+
+
+void group_stop(group_t* p_group) {
+    for(int car = 0; car < p_group->car_count; car++) {
+        hardware_select_car(car);
+        hardware_command_movement(HARDWARE_MOVEMENT_STOP);
+        hardware_flush_outputs();
+    }
+    hardware_select_car(0);
+}
+
+
+const char* group_policy_name(group_policy_t policy) {
+    switch(policy) {
+        case GROUP_POLICY_ETA:
+            return "eta";
+        case GROUP_POLICY_NEAREST:
+            return "nearest";
+    }
+    return "unknown";
+}
+
+
+void group_print_stats(const group_t* p_group, FILE* stream) {
+    double mean = (p_group->stats.served > 0) ? p_group->stats.wait_sum_ns / p_group->stats.served : 0.0;
+
+    fprintf(stream, "Group of %d cars (%s): %lld hall calls, %lld served, %lld reassigned\n",
+            p_group->car_count, group_policy_name(p_group->policy), p_group->stats.calls, p_group->stats.served, p_group->stats.reassigned);
+    fprintf(stream, "Hall call wait [s]: mean %.1f, max %.1f\n", mean / 1e9, p_group->stats.wait_max_ns / 1e9);
+}
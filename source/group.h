@@ -0,0 +1,179 @@
+/**
+ * @file
+ * @brief Group controller for a bank of elevator cars.
+ *
+ * The group owns the hall buttons and lights of the bank. They are wired to the first car's
+ * I/O. Each car runs its own FSM and reads only its cab buttons. Every hall call is given to
+ * the car that the assignment policy picks, and is kept in that car's queue until the car opens
+ * its door at the floor. Calls whose car loses them, for instance to an emergency stop, are
+ * assigned again.
+ *
+ * With a demand model, the group counts the hall calls in it and parks every car that stands idle
+ * at a different floor of high forecast demand, as described in demand.h.
+ *
+ * With snapshots, as described in snapshot.h, the hall calls of the cars that restart warm are
+ * pending calls of the group again.
+ */
+#ifndef GROUP_H
+#define GROUP_H
+
+#include <stdio.h>
+
+#include "elevator_fsm.h"
+
+
+#define GROUP_MAX_CARS HARDWARE_MAX_CARS                /**< Most cars a group can control */
+#define GROUP_MAX_CALLS (2 * HARDWARE_NUMBER_OF_FLOORS)  /**< Most hall calls that can be pending: one up and one down per floor */
+
+#define GROUP_REEVALUATE_NS 500000000LL         /**< How often the ETA policy reconsiders its assignments */
+#define GROUP_REASSIGN_MARGIN_NS 2000000000LL   /**< How much sooner another car must arrive before a call is moved to it */
+#define GROUP_ETA_NEVER (1LL << 62)             /**< ETA of a car that cannot serve calls */
+
+
+/**
+ * Enum for the ways hall calls can be assigned to cars
+ */
+typedef enum{
+    GROUP_POLICY_ETA,           /**< The car with the lowest estimated time of arrival, reconsidered as the cars move*/
+    GROUP_POLICY_NEAREST,       /**< The car nearest the call when it is made, never reconsidered*/
+    GROUP_POLICY_COUNT          /**< Number of policies, not a policy*/
+} group_policy_t;
+
+
+/**
+ * A pending hall call
+ */
+typedef struct{
+    int floor;                  /**< The floor of the call*/
+    HardwareOrder order_type;   /**< @c HARDWARE_ORDER_UP or @c HARDWARE_ORDER_DOWN*/
+    int car;                    /**< The car the call is assigned to*/
+    long long pressed_ns;       /**< When the call was made, on the timer clock*/
+} group_call_t;
+
+
+/**
+ * A struct holding the counters of a group
+ */
+typedef struct{
+    long long calls;            /**< Hall calls made*/
+    long long served;           /**< Hall calls served*/
+    long long reassigned;       /**< Hall calls moved from one car to another*/
+    double wait_sum_ns;         /**< Sum of the wait times of the served calls*/
+    long long wait_max_ns;      /**< Longest wait time of a served call*/
+} group_stats_t;
+
+
+/**
+ * A struct holding a bank of cars and the hall calls assigned to them
+ */
+typedef struct{
+    int car_count;                                  /**< Number of cars in the bank*/
+    group_policy_t policy;                          /**< How hall calls are assigned*/
+    elevator_data_t cars[GROUP_MAX_CARS];           /**< The cars, indexed by their @c hardware_select_car() number*/
+    group_call_t calls[GROUP_MAX_CALLS];            /**< The pending hall calls, in no particular order*/
+    int call_count;                                 /**< Number of pending hall calls*/
+    uint64_t held[2][QUEUE_WORDS];                  /**< Hall buttons, up and down, that were pressed in the previous tick*/
+    long long reevaluate_at_ns;                     /**< When the ETA policy next reconsiders its assignments*/
+    group_stats_t stats;                            /**< Counters since @c group_init()*/
+    void (*on_served)(void* arg, int car, const group_call_t* p_call);  /**< Called for every served call, or NULL*/
+    void* on_served_arg;                            /**< Passed unchanged to @c on_served*/
+    demand_t* p_demand;                             /**< Model the hall calls are counted in and idle cars are parked by, or NULL*/
+} group_t;
+
+
+/**
+ * @brief Initialize the hardware and the controller of every car of a bank
+ *
+ * @param[out] p_group      The group to initialize
+ * @param[in] car_count     Number of cars, from 1 to @c GROUP_MAX_CARS
+ * @param[in] policy        How hall calls are assigned
+ *
+ * @return 0 on success, and -1 if the hardware of a car could not be initialized
+ */
+int group_init(group_t* p_group, int car_count, group_policy_t policy);
+
+
+/**
+ * @brief Initialize the hardware and the controller of every car of a bank, from their snapshots
+ *
+ * @param[out] p_group      The group to initialize
+ * @param[in] car_count     Number of cars, from 1 to @c GROUP_MAX_CARS
+ * @param[in] policy        How hall calls are assigned
+ * @param[in] p_snapshot    Snapshots the cars restart from and save to, or NULL to initialize the
+ *                          bank as @c group_init() does
+ *
+ * @return Number of cars that restarted warm, as in @c elevator_init_from_snapshot() , and -1 if the
+ * hardware of a car could not be initialized
+ *
+ * The hall orders of the cars that restarted warm are pending calls again, assigned to the same car,
+ * made when they were first accepted, and with their lights lit.
+ */
+int group_init_from_snapshot(group_t* p_group, int car_count, group_policy_t policy, snapshot_t* p_snapshot);
+
+
+/**
+ * @brief Run one control cycle of every car, then take, assign and clear hall calls
+ *
+ * @param[in, out] p_group  The group
+ */
+void group_tick(group_t* p_group);
+
+
+/**
+ * @brief Estimate when a car can serve a hall call
+ *
+ * @param[in] p_group       The group
+ * @param[in] car           The car
+ * @param[in] floor         The floor of the call
+ * @param[in] order_type    The direction of the call
+ *
+ * @return Nanoseconds until the car opens its door for the call, or @c GROUP_ETA_NEVER for a car in
+ * emergency or homing
+ *
+ * The car is assumed to keep going in its direction until it has served its last order in
+ * that direction before it turns. The travel, from where the car is estimated to be, and the
+ * starting and landing of every run it makes on the way cost what the car has learned they take,
+ * as kept in its @c position_t . Every committed stop on the way, and the rest of an open door,
+ * costs door time.
+ */
+long long group_eta(const group_t* p_group, int car, int floor, HardwareOrder order_type);
+
+
+/**
+ * @brief Time until the next timer of any car expires
+ *
+ * @param[in, out] p_group  The group
+ *
+ * @return Nanoseconds until the next deadline, or -1 if no timer is running
+ */
+long long group_until_next_deadline(group_t* p_group);
+
+
+/**
+ * @brief Stop every car
+ *
+ * @param[in] p_group   The group
+ */
+void group_stop(group_t* p_group);
+
+
+/**
+ * @brief Name of an assignment policy
+ *
+ * @param[in] policy    The policy
+ *
+ * @return A short lowercase name
+ */
+const char* group_policy_name(group_policy_t policy);
+
+
+/**
+ * @brief Print a summary of the group's counters to @p stream
+ *
+ * @param[in] p_group   The group
+ * @param[in] stream    Where to print the summary
+ */
+void group_print_stats(const group_t* p_group, FILE* stream);
+
+
+#endif //GROUP_H
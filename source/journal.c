@@ -0,0 +1,224 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "driver/hardware.h"
+#include "journal.h"
+
+
+static journal_record_t ring_g[JOURNAL_RING_RECORDS];
+static _Atomic uint64_t head_g;         // Written by the control loop only
+static _Atomic uint64_t tail_g;         // Written by the drain thread only
+
+// State of the control loop's side
+static int open_g = 0;
+static uint32_t sequence_g;
+static uint32_t dropped_g;
+static struct{
+    int valid;
+    journal_record_t record;
+} previous_g[HARDWARE_MAX_CARS];
+
+// State of the drain thread's side
+static pthread_t thread_g;
+static atomic_int running_g;
+static int fd_g = -1;
+static char path_g[PATH_MAX];
+static long long file_bytes_g;
+
+
+/**
+ * @brief Write all of @p size bytes, giving up on errors, which only lose journal records
+ */
+static void journal_write(const void* data, size_t size) {
+    const char* bytes = data;
+    while(size > 0) {
+        ssize_t written = write(fd_g, bytes, size);
+        if(written <= 0) {
+            return;
+        }
+        bytes += written;
+        size -= written;
+        file_bytes_g += written;
+    }
+}
+
+
+/**
+ * @brief Open a new journal file at @c path_g and write its header
+ */
+static int journal_start_file() {
+    fd_g = open(path_g, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if(fd_g < 0) {
+        return -1;
+    }
+
+    journal_file_header_t header = { .magic = JOURNAL_MAGIC, .version = JOURNAL_VERSION, .record_size = sizeof(journal_record_t) };
+    file_bytes_g = 0;
+    journal_write(&header, sizeof(header));
+    return 0;
+}
+
+
+/**
+ * @brief Close the current file, shift the older ones up by one and start a new one
+ */
+static void journal_rotate() {
+    close(fd_g);
+
+    char from[PATH_MAX + 8];
+    char to[PATH_MAX + 8];
+    for(int i = JOURNAL_FILES - 1; i > 0; i--) {
+        if(i > 1) {
+            snprintf(from, sizeof(from), "%s.%d", path_g, i - 1);
+        }
+        else {
+            snprintf(from, sizeof(from), "%s", path_g);
+        }
+        snprintf(to, sizeof(to), "%s.%d", path_g, i);
+        rename(from, to);
+    }
+    journal_start_file();
+}
+
+
+/**
+ * @brief Write every record in the ring to the file
+ */
+static void journal_drain() {
+    uint64_t tail = atomic_load_explicit(&tail_g, memory_order_relaxed);
+    uint64_t head = atomic_load_explicit(&head_g, memory_order_acquire);
+
+    while(tail != head) {
+        // The records up to the end of the ring are written in one go, and the rest in the next
+        uint64_t first = tail & (JOURNAL_RING_RECORDS - 1);
+        uint64_t count = head - tail;
+        if(count > JOURNAL_RING_RECORDS - first) {
+            count = JOURNAL_RING_RECORDS - first;
+        }
+
+        if(fd_g >= 0 && file_bytes_g >= JOURNAL_FILE_BYTES) {
+            journal_rotate();
+        }
+        if(fd_g >= 0) {
+            journal_write(&ring_g[first], count * sizeof(journal_record_t));
+        }
+
+        tail += count;
+        atomic_store_explicit(&tail_g, tail, memory_order_release);
+    }
+}
+
+
+static void* journal_thread(void* arg) {
+    struct timespec period = { .tv_sec = 0, .tv_nsec = JOURNAL_DRAIN_NS };
+    while(atomic_load(&running_g)) {
+        journal_drain();
+        nanosleep(&period, NULL);
+    }
+    journal_drain();
+    return NULL;
+}
+
+
+int journal_open(const char* path) {
+    if(open_g || strlen(path) >= sizeof(path_g)) {
+        return -1;
+    }
+    strcpy(path_g, path);
+    if(journal_start_file() != 0) {
+        return -1;
+    }
+
+    atomic_store(&head_g, 0);
+    atomic_store(&tail_g, 0);
+    sequence_g = 0;
+    dropped_g = 0;
+    memset(previous_g, 0, sizeof(previous_g));
+
+    // The thread blocks every signal, so SIGINT and friends reach the control loop's signalfd
+    sigset_t all;
+    sigset_t previous;
+    sigfillset(&all);
+    pthread_sigmask(SIG_SETMASK, &all, &previous);
+    atomic_store(&running_g, 1);
+    int created = pthread_create(&thread_g, NULL, journal_thread, NULL);
+    pthread_sigmask(SIG_SETMASK, &previous, NULL);
+    if(created != 0) {
+        close(fd_g);
+        fd_g = -1;
+        return -1;
+    }
+    open_g = 1;
+    return 0;
+}
+
+
+int journal_is_open() {
+    return open_g;
+}
+
+
+/**
+ * @brief Whether a tick adds nothing to the previous recorded tick of the same car
+ */
+static int journal_is_repeat(const journal_record_t* p_record) {
+    if(p_record->car >= HARDWARE_MAX_CARS) {
+        return 0;
+    }
+
+    const journal_record_t* p_previous = &previous_g[p_record->car].record;
+    int repeat = previous_g[p_record->car].valid
+              && p_record->from_state == p_record->to_state
+              && p_record->action == 0
+              && p_record->event == p_previous->event
+              && (p_record->guards & p_record->consulted) == (p_previous->guards & p_previous->consulted)
+              && p_record->from_state == p_previous->to_state
+              && p_record->floor == p_previous->floor;
+
+    previous_g[p_record->car].valid = 1;
+    previous_g[p_record->car].record = *p_record;
+    return repeat;
+}
+
+
+void journal_append(const journal_record_t* p_record) {
+    if(!open_g || journal_is_repeat(p_record)) {
+        return;
+    }
+
+    uint64_t head = atomic_load_explicit(&head_g, memory_order_relaxed);
+    uint64_t tail = atomic_load_explicit(&tail_g, memory_order_acquire);
+    sequence_g++;
+    if(head - tail >= JOURNAL_RING_RECORDS) {
+        dropped_g++;
+        return;
+    }
+
+    journal_record_t* p_slot = &ring_g[head & (JOURNAL_RING_RECORDS - 1)];
+    *p_slot = *p_record;
+    p_slot->sequence = sequence_g;
+    p_slot->dropped = dropped_g;
+    dropped_g = 0;
+    atomic_store_explicit(&head_g, head + 1, memory_order_release);
+}
+
+
+void journal_close() {
+    if(!open_g) {
+        return;
+    }
+    atomic_store(&running_g, 0);
+    pthread_join(thread_g, NULL);
+    close(fd_g);
+    fd_g = -1;
+    open_g = 0;
+}
@@ -0,0 +1,96 @@
+/**
+ * @file
+ * @brief Binary journal of the FSM's events, guards, transitions and actions.
+ *
+ * The control loop appends fixed-size records to a single-producer, single-consumer ring
+ * in memory, which costs a copy and an atomic store. A background thread drains the ring
+ * to a file every @c JOURNAL_DRAIN_NS and rotates the file when it grows past
+ * @c JOURNAL_FILE_BYTES , so the control loop never waits for the disk. When the ring is
+ * full, records are dropped and the next record that fits says how many were lost.
+ *
+ * Only ticks where something happens are recorded: the state changes, the action is not
+ * @c ACTION_DO_NOTHING , or the event or guards differ from the car's previous tick.
+ *
+ * A journal file starts with a @c journal_file_header_t , followed by records. Decode one with
+ * tools/journal_decode.py .
+ */
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <stdint.h>
+
+
+#define JOURNAL_MAGIC "ELVJRNL"             /**< First bytes of every journal file, with its terminating zero */
+#define JOURNAL_VERSION 1                   /**< Version of the record layout */
+#define JOURNAL_RING_RECORDS 4096           /**< Records the ring holds, a power of two */
+#define JOURNAL_DRAIN_NS 20000000LL         /**< How often the thread drains the ring */
+#define JOURNAL_FILE_BYTES (4 << 20)        /**< Size at which the file is rotated */
+#define JOURNAL_FILES 4                     /**< Number of files kept: the current one, and .1 to .3 from old to older */
+
+
+/**
+ * The header of a journal file
+ */
+typedef struct{
+    char magic[8];              /**< @c JOURNAL_MAGIC*/
+    uint32_t version;           /**< @c JOURNAL_VERSION*/
+    uint32_t record_size;       /**< @c sizeof(journal_record_t)*/
+} journal_file_header_t;
+
+
+/**
+ * One tick of one car, as recorded
+ */
+typedef struct{
+    int64_t time_ns;            /**< Timer clock at the start of the tick*/
+    uint32_t sequence;          /**< Number of the record, counting dropped ones*/
+    uint32_t dropped;           /**< Records dropped just before this one because the ring was full*/
+    uint8_t car;                /**< The car*/
+    uint8_t event;              /**< The @c elevator_event_t of the tick*/
+    uint8_t from_state;         /**< The @c elevator_state_t before the transition*/
+    uint8_t to_state;           /**< The @c elevator_state_t after the transition*/
+    uint8_t action;             /**< The @c elevator_action_t of the transition*/
+    uint8_t guards;             /**< The guard mask, of which only the @c consulted bits were evaluated*/
+    uint8_t consulted;          /**< The guard bits the transition depended on*/
+    int8_t direction;           /**< The car's last direction: 1 up, -1 down or 0*/
+    int16_t floor;              /**< The floor sensor, or -1 between floors*/
+    int16_t last_floor;         /**< The last floor the car was at*/
+    uint32_t reserved;          /**< Zero*/
+} journal_record_t;
+
+
+/**
+ * @brief Start journaling to @p path and start the thread that writes the file
+ *
+ * @param[in] path  The journal file. Older files are renamed to @p path .1 and so on.
+ *
+ * @return 0 on success, and -1 if the file could not be opened or the thread not started
+ */
+int journal_open(const char* path);
+
+
+/**
+ * @brief Append a record to the ring if the tick is worth recording. Does nothing unless the journal is open.
+ *
+ * @param[in] p_record  The record. The sequence and dropped fields are filled in here.
+ *
+ * Called from the control loop only; never blocks.
+ */
+void journal_append(const journal_record_t* p_record);
+
+
+/**
+ * @brief Check if the journal is open, so the caller can skip building a record
+ *
+ * @return 1 if the journal is open, and 0 if not
+ */
+int journal_is_open();
+
+
+/**
+ * @brief Stop the thread, write the rest of the ring and close the file
+ */
+void journal_close();
+
+
+#endif //JOURNAL_H
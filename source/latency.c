@@ -0,0 +1,186 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <string.h>
+#include <time.h>
+
+#include "latency.h"
+
+#ifdef ELEVATOR_LATENCY
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define LATENCY_USE_TSC
+#endif
+
+#define LATENCY_CALIBRATION_NS 10000000LL  // Shortest span the clock is converted over
+
+
+static latency_histogram_t histograms_g[LATENCY_PHASE_COUNT];
+
+// A reading of both clocks, taken at the first probe, which the conversion is measured from
+static uint64_t calibration_ticks_g;
+static long long calibration_ns_g;
+
+static const char* const latency_phase_names[LATENCY_PHASE_COUNT] = {
+    [LATENCY_TICK]          = "tick",
+    [LATENCY_SENSORS]       = "sensors",
+    [LATENCY_BUTTONS]       = "buttons",
+    [LATENCY_UPDATE_STATE]  = "update_state",
+    [LATENCY_EXECUTE]       = "execute",
+    [LATENCY_OUTPUTS]       = "outputs",
+    [LATENCY_PUBLISH]       = "publish"
+};
+
+
+static long long latency_monotonic_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+
+/**
+ * @brief The bucket of a duration: small values get a bucket each, larger ones share by leading bit and sub-bucket
+ */
+static int latency_bucket(uint64_t ticks) {
+    if(ticks < LATENCY_SUB_BUCKETS) {
+        return (int)ticks;
+    }
+    int msb = 63 - __builtin_clzll(ticks);
+    int sub = (int)(ticks >> (msb - LATENCY_SUB_BUCKET_BITS)) & (LATENCY_SUB_BUCKETS - 1);
+    return (msb - LATENCY_SUB_BUCKET_BITS + 1) * LATENCY_SUB_BUCKETS + sub;
+}
+
+
+/**
+ * @brief The largest duration that falls into @p bucket
+ */
+static uint64_t latency_bucket_upper(int bucket) {
+    if(bucket < LATENCY_SUB_BUCKETS) {
+        return (uint64_t)bucket;
+    }
+    int msb = bucket / LATENCY_SUB_BUCKETS + LATENCY_SUB_BUCKET_BITS - 1;
+    uint64_t sub = bucket % LATENCY_SUB_BUCKETS;
+    uint64_t step = (uint64_t)1 << (msb - LATENCY_SUB_BUCKET_BITS);
+    return ((uint64_t)1 << msb) + (sub + 1) * step - 1;
+}
+
+
+static void latency_calibrate_from_now() {
+    if(calibration_ns_g == 0) {
+        calibration_ticks_g = latency_now();
+        calibration_ns_g = latency_monotonic_ns();
+    }
+}
+
+
+/**
+ * @brief Nanoseconds per clock tick, measured since the first probe
+ */
+static double latency_ns_per_tick() {
+#ifdef LATENCY_USE_TSC
+    latency_calibrate_from_now();
+
+    long long elapsed_ns;
+    uint64_t now;
+    do {
+        now = latency_now();
+        elapsed_ns = latency_monotonic_ns() - calibration_ns_g;
+    } while(elapsed_ns < LATENCY_CALIBRATION_NS);
+    return (double)elapsed_ns / (now - calibration_ticks_g);
+#else
+    return 1.0;
+#endif
+}
+
+
+uint64_t latency_now() {
+#ifdef LATENCY_USE_TSC
+    return __rdtsc();
+#else
+    return (uint64_t)latency_monotonic_ns();
+#endif
+}
+
+
+void latency_record(latency_phase_t phase, uint64_t ticks) {
+    latency_histogram_t* p_histogram = &histograms_g[phase];
+
+    p_histogram->buckets[latency_bucket(ticks)]++;
+    p_histogram->count++;
+    p_histogram->sum += ticks;
+    if(ticks > p_histogram->max) {
+        p_histogram->max = ticks;
+    }
+}
+
+
+latency_probe_t latency_begin() {
+    latency_calibrate_from_now();
+    uint64_t now = latency_now();
+    return (latency_probe_t){ .start = now, .lap = now };
+}
+
+
+void latency_lap(latency_probe_t* p_probe, latency_phase_t phase) {
+    uint64_t now = latency_now();
+    latency_record(phase, now - p_probe->lap);
+    p_probe->lap = now;
+}
+
+
+void latency_end(const latency_probe_t* p_probe) {
+    // The last lap ended the tick, so its time is reused instead of reading the clock again
+    latency_record(LATENCY_TICK, p_probe->lap - p_probe->start);
+}
+
+
+/**
+ * @brief Quantile @p q of a phase, in clock ticks
+ */
+static uint64_t latency_quantile(latency_phase_t phase, double q) {
+    const latency_histogram_t* p_histogram = &histograms_g[phase];
+    if(p_histogram->count == 0) {
+        return 0;
+    }
+
+    uint64_t rank = (uint64_t)(q * (p_histogram->count - 1)) + 1;
+    uint64_t seen = 0;
+    for(int bucket = 0; bucket < LATENCY_BUCKETS; bucket++) {
+        seen += p_histogram->buckets[bucket];
+        if(seen >= rank) {
+            uint64_t upper = latency_bucket_upper(bucket);
+            return (upper < p_histogram->max) ? upper : p_histogram->max;
+        }
+    }
+    return p_histogram->max;
+}
+
+
+long long latency_quantile_ns(latency_phase_t phase, double q) {
+    return (long long)(latency_quantile(phase, q) * latency_ns_per_tick());
+}
+
+
+void latency_print(FILE* stream) {
+    double ns_per_tick = latency_ns_per_tick();
+
+    fprintf(stream, "Latency [ns]   %12s %10s %10s %10s %10s %10s\n", "count", "mean", "p50", "p99", "p99.9", "max");
+    for(int phase = 0; phase < LATENCY_PHASE_COUNT; phase++) {
+        const latency_histogram_t* p_histogram = &histograms_g[phase];
+        double mean = (p_histogram->count > 0) ? (double)p_histogram->sum / p_histogram->count : 0.0;
+
+        fprintf(stream, "  %-12s %12llu %10.0f %10.0f %10.0f %10.0f %10.0f\n", latency_phase_names[phase],
+                (unsigned long long)p_histogram->count, mean * ns_per_tick,
+                latency_quantile(phase, 0.5) * ns_per_tick, latency_quantile(phase, 0.99) * ns_per_tick,
+                latency_quantile(phase, 0.999) * ns_per_tick, p_histogram->max * ns_per_tick);
+    }
+    fflush(stream);
+}
+
+
+void latency_reset() {
+    memset(histograms_g, 0, sizeof(histograms_g));
+}
+
+#endif //ELEVATOR_LATENCY
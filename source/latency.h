@@ -0,0 +1,153 @@
+/**
+ * @file
+ * @brief Latency histograms of the phases of the control cycle.
+ *
+ * Every phase of @c elevator_tick() , and the tick as a whole, records its duration into a
+ * histogram with logarithmic buckets: a power of two split into @c LATENCY_SUB_BUCKETS linear
+ * steps, so every bucket is within 25 % of the values in it. Recording is a clock read and an
+ * increment, and the histograms are printed as percentiles on SIGUSR1 and when the controller exits.
+ *
+ * On x86 the clock is the time stamp counter, which is cheaper to read than @c clock_gettime() ,
+ * and durations are converted to nanoseconds against @c CLOCK_MONOTONIC only when printed.
+ * Elsewhere the clock is @c CLOCK_MONOTONIC itself.
+ *
+ * The probes are only built when @c ELEVATOR_LATENCY is defined, which the Makefile does
+ * unless it is run with @c LATENCY=0 . Without it the macros below expand to nothing and
+ * the controller carries no trace of them.
+ */
+#ifndef LATENCY_H
+#define LATENCY_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+
+#define LATENCY_SUB_BUCKET_BITS 2                               /**< Bits of a value below its leading bit that pick the sub-bucket */
+#define LATENCY_SUB_BUCKETS (1 << LATENCY_SUB_BUCKET_BITS)      /**< Linear steps per power of two */
+#define LATENCY_BUCKETS (64 * LATENCY_SUB_BUCKETS)              /**< Buckets per histogram, enough for any 64-bit duration */
+
+
+/**
+ * Enum for the measured parts of the control cycle
+ */
+typedef enum{
+    LATENCY_TICK,               /**< The whole of @c elevator_tick()*/
+    LATENCY_SENSORS,            /**< Sampling the inputs and updating the floor*/
+    LATENCY_BUTTONS,            /**< @c update_button_state()*/
+    LATENCY_UPDATE_STATE,       /**< @c elevator_update_state()*/
+    LATENCY_EXECUTE,            /**< @c elevator_execute_next_action()*/
+    LATENCY_OUTPUTS,            /**< @c hardware_flush_outputs()*/
+    LATENCY_PUBLISH,            /**< Saving the snapshot and publishing the live state, when they are open*/
+    LATENCY_PHASE_COUNT         /**< Number of phases, not a phase*/
+} latency_phase_t;
+
+
+/**
+ * A histogram of the durations of one phase
+ */
+typedef struct{
+    uint64_t buckets[LATENCY_BUCKETS];  /**< Number of durations in every bucket*/
+    uint64_t count;                     /**< Number of recorded durations*/
+    uint64_t sum;                       /**< Sum of the recorded durations, in clock ticks*/
+    uint64_t max;                       /**< Longest recorded duration, in clock ticks*/
+} latency_histogram_t;
+
+
+/**
+ * A probe timing consecutive phases of one tick
+ */
+typedef struct{
+    uint64_t start;             /**< When the tick started, in clock ticks*/
+    uint64_t lap;               /**< When the previous phase ended, in clock ticks*/
+} latency_probe_t;
+
+
+#ifdef ELEVATOR_LATENCY
+
+/** Start timing a tick with the probe @p probe */
+#define LATENCY_BEGIN(probe) latency_probe_t probe = latency_begin()
+/** Record the time since the previous lap of @p probe as @p phase */
+#define LATENCY_LAP(probe, phase) latency_lap(&(probe), (phase))
+/** Record the time since @c LATENCY_BEGIN as @c LATENCY_TICK */
+#define LATENCY_END(probe) latency_end(&(probe))
+/** Print the histograms to @p stream */
+#define LATENCY_PRINT(stream) latency_print(stream)
+
+#else
+
+#define LATENCY_BEGIN(probe)
+#define LATENCY_LAP(probe, phase)
+#define LATENCY_END(probe)
+#define LATENCY_PRINT(stream)
+
+#endif
+
+
+/**
+ * @brief Read the latency clock
+ *
+ * @return The time in clock ticks, which are nanoseconds where there is no time stamp counter
+ */
+uint64_t latency_now();
+
+
+/**
+ * @brief Add a duration to the histogram of a phase
+ *
+ * @param[in] phase     The phase
+ * @param[in] ticks     The duration, in clock ticks
+ */
+void latency_record(latency_phase_t phase, uint64_t ticks);
+
+
+/**
+ * @brief Start a probe at the current time
+ *
+ * @return The probe
+ */
+latency_probe_t latency_begin();
+
+
+/**
+ * @brief Record the phase that ends now
+ *
+ * @param[in, out] p_probe  The probe of the tick
+ * @param[in] phase         The phase that ends
+ */
+void latency_lap(latency_probe_t* p_probe, latency_phase_t phase);
+
+
+/**
+ * @brief Record the tick that ends now
+ *
+ * @param[in] p_probe   The probe of the tick
+ */
+void latency_end(const latency_probe_t* p_probe);
+
+
+/**
+ * @brief The upper bound of the bucket holding quantile @p q of a phase
+ *
+ * @param[in] phase     The phase
+ * @param[in] q         The quantile, from 0 to 1
+ *
+ * @return The duration in nanoseconds, or 0 if nothing was recorded
+ */
+long long latency_quantile_ns(latency_phase_t phase, double q);
+
+
+/**
+ * @brief Print p50, p99, p99.9 and the maximum of every phase to @p stream
+ *
+ * @param[in] stream    Where to print the table
+ */
+void latency_print(FILE* stream);
+
+
+/**
+ * @brief Forget everything recorded so far
+ */
+void latency_reset();
+
+
+#endif //LATENCY_H
@@ -0,0 +1,110 @@
+#define _DEFAULT_SOURCE
+
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "live.h"
+
+
+_Static_assert(sizeof(live_car_t) % sizeof(uint64_t) == 0, "live_car_t must be a whole number of words");
+
+
+int live_open(live_t* p_live, const char* name, int car_count) {
+    int fd = shm_open(name, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if(fd < 0) {
+        return -1;
+    }
+    if(ftruncate(fd, sizeof(live_segment_t)) != 0) {
+        close(fd);
+        return -1;
+    }
+    // The mapping keeps the segment open
+    live_segment_t* p_segment = mmap(NULL, sizeof(live_segment_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if(p_segment == MAP_FAILED) {
+        return -1;
+    }
+
+    // Invalid while it is set up, so a reader of an earlier controller's segment does not mix the two
+    p_segment->magic = 0;
+    atomic_thread_fence(memory_order_release);
+    memset(p_segment->records, 0, sizeof(p_segment->records));
+    p_segment->version = LIVE_VERSION;
+    p_segment->floors = HARDWARE_NUMBER_OF_FLOORS;
+    p_segment->cars = car_count;
+    p_segment->pid = getpid();
+    p_segment->record_size = sizeof(live_record_t);
+    atomic_thread_fence(memory_order_release);
+    p_segment->magic = LIVE_MAGIC;
+
+    p_live->p_segment = p_segment;
+    p_live->name = name;
+    return 0;
+}
+
+
+void live_close(live_t* p_live) {
+    if(p_live->p_segment != NULL) {
+        munmap(p_live->p_segment, sizeof(live_segment_t));
+        shm_unlink(p_live->name);
+        p_live->p_segment = NULL;
+    }
+}
+
+
+void live_publish(live_t* p_live, int car, const live_car_t* p_car) {
+    live_record_t* p_record = &p_live->p_segment->records[car];
+
+    // Only the controller writes the record, so the sequence number needs no read-modify-write
+    uint64_t seq = atomic_load_explicit(&p_record->seq, memory_order_relaxed);
+    atomic_store_explicit(&p_record->seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    p_record->car = *p_car;
+    atomic_store_explicit(&p_record->seq, seq + 2, memory_order_release);
+}
+
+
+const live_segment_t* live_attach(const char* name) {
+    int fd = shm_open(name, O_RDONLY | O_CLOEXEC, 0);
+    if(fd < 0) {
+        return NULL;
+    }
+    struct stat st;
+    if(fstat(fd, &st) != 0 || st.st_size != (off_t)sizeof(live_segment_t)) {
+        close(fd);
+        return NULL;
+    }
+    const live_segment_t* p_segment = mmap(NULL, sizeof(live_segment_t), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if(p_segment == MAP_FAILED) {
+        return NULL;
+    }
+
+    if(p_segment->magic != LIVE_MAGIC || p_segment->version != LIVE_VERSION || p_segment->floors != HARDWARE_NUMBER_OF_FLOORS
+       || p_segment->record_size != (int32_t)sizeof(live_record_t)) {
+        munmap((void*)p_segment, sizeof(live_segment_t));
+        return NULL;
+    }
+    return p_segment;
+}
+
+
+int live_read(const live_segment_t* p_segment, int car, live_car_t* p_car) {
+    const live_record_t* p_record = &p_segment->records[car];
+
+    for(int i = 0; i < LIVE_READ_TRIES; i++) {
+        uint64_t before = atomic_load_explicit(&p_record->seq, memory_order_acquire);
+        if(before & 1) {
+            continue;
+        }
+        memcpy(p_car, (const void*)&p_record->car, sizeof(live_car_t));
+        atomic_thread_fence(memory_order_acquire);
+        if(atomic_load_explicit(&p_record->seq, memory_order_relaxed) == before) {
+            return (before != 0) ? 0 : -1;
+        }
+    }
+    return -1;
+}
@@ -0,0 +1,151 @@
+/**
+ * @file
+ * @brief Live state of the controller, published in a POSIX shared-memory segment for monitors.
+ *
+ * Every car publishes what it did in a control cycle at the end of the cycle: its state, the
+ * event and action of the cycle, its floor and position, its door and motor, its pending orders,
+ * and counters that only ever grow. Publishing is a copy into the segment between two stores of
+ * a sequence number, which is odd while the record is written, so the controller makes no system
+ * call for it and never waits for a reader. A reader copies the record and retries if the number
+ * was odd or changed meanwhile; see @c live_read().
+ *
+ * The segment is made when the controller starts and removed when it exits, and it holds the
+ * process id of the controller, so a reader can tell the state of one that crashed from live state.
+ * elevator-top ( @c make top ) is such a reader.
+ */
+#ifndef LIVE_H
+#define LIVE_H
+
+#include <stdatomic.h>
+#include <stdint.h>
+
+#include "driver/hardware.h"
+#include "queue.h"
+
+
+#define LIVE_MAGIC 0x4556494cu          /**< "LIVE", which a live segment starts with */
+#define LIVE_VERSION 1                  /**< Layout of the live segment */
+#define LIVE_NAME "/elevator-live"      /**< Name of the segment unless another is given, under /dev/shm */
+#define LIVE_READ_TRIES 1000            /**< Copies @c live_read() makes of a record before it gives up */
+
+
+/**
+ * Counters of a car, from when the controller started
+ */
+typedef struct{
+    uint64_t ticks;                     /**< Control cycles*/
+    uint64_t io_calls;                  /**< @c io_* calls of the driver for the car, including those of the sampler*/
+    uint64_t trips;                     /**< Runs started*/
+    uint64_t door_cycles;               /**< Times the door opened*/
+    uint64_t emergency_stops;           /**< Times the stop button put the car in emergency*/
+    uint64_t motor_reversals;           /**< Runs started in the direction opposite to the run before*/
+} live_counters_t;
+
+
+/**
+ * What a car publishes, as laid out in the segment. Fields are ordered so the struct has no padding.
+ */
+typedef struct{
+    int64_t time_ns;                            /**< @c timer_now_ns() at the end of the control cycle*/
+    double position;                            /**< Estimated position, in floors from the bottom floor*/
+    int32_t state;                              /**< The @c elevator_state_t after the cycle*/
+    int32_t event;                              /**< The @c elevator_event_t of the cycle*/
+    int32_t action;                             /**< The @c elevator_action_t of the cycle*/
+    int32_t last_floor;                         /**< The floor whose sensor the car was last at*/
+    int32_t current_floor;                      /**< The floor whose sensor the car is at, or @c BETWEEN_FLOORS*/
+    int32_t last_dir;                           /**< The @c HardwareMovement the car last moved in*/
+    int32_t park_floor;                         /**< The floor the car is parking at, or @c FLOOR_NOT_INIT*/
+    int32_t door_open;                          /**< 1 if the door is commanded open*/
+    int32_t motor_speed;                        /**< Drive the motor is commanded, negative downwards, 0 when stopped*/
+    int32_t stop;                               /**< 1 while the stop button is pressed in*/
+    int32_t obstruction;                        /**< 1 while the door is obstructed*/
+    int32_t order_count;                        /**< Number of pending orders*/
+    int16_t orders[QUEUE_SIZE];                 /**< Slots of the pending orders, oldest first, as in @c snapshot_state_t::orders */
+    int16_t orders_pad[4 - QUEUE_SIZE % 4];     /**< Keeps the next field aligned; always 0*/
+    live_counters_t counters;                   /**< The counters of the car*/
+} live_car_t;
+
+
+/**
+ * The record of a car, on a cache line of its own
+ */
+typedef struct{
+    _Alignas(64) _Atomic uint64_t seq;          /**< Odd while the car is written; changes with every publication*/
+    live_car_t car;                             /**< The published car*/
+} live_record_t;
+
+
+/**
+ * The live segment
+ */
+typedef struct{
+    uint32_t magic;                             /**< @c LIVE_MAGIC once the segment is set up*/
+    uint32_t version;                           /**< Layout of the segment*/
+    int32_t floors;                             /**< Floors of the building*/
+    int32_t cars;                               /**< Cars of the controller*/
+    int32_t pid;                                /**< Process id of the controller*/
+    int32_t record_size;                        /**< Size of a record, in bytes*/
+    live_record_t records[HARDWARE_MAX_CARS];   /**< The record of every car*/
+} live_segment_t;
+
+
+/**
+ * The live segment of a controller
+ */
+typedef struct{
+    live_segment_t* p_segment;                  /**< The mapped segment*/
+    const char* name;                           /**< Name of the segment*/
+} live_t;
+
+
+/**
+ * @brief Make the live segment of a controller, replacing any left by an earlier one
+ *
+ * @param[out] p_live       The segment
+ * @param[in] name          Name of the segment, starting with a slash, which must outlive @p p_live
+ * @param[in] car_count     Number of cars that publish
+ *
+ * @return 0 on success, and -1 if the segment could not be made or mapped
+ */
+int live_open(live_t* p_live, const char* name, int car_count);
+
+
+/**
+ * @brief Unmap and remove the live segment
+ */
+void live_close(live_t* p_live);
+
+
+/**
+ * @brief Publish a car
+ *
+ * @param[in, out] p_live   The segment
+ * @param[in] car           The car
+ * @param[in] p_car         What the car publishes, with every padding byte 0
+ */
+void live_publish(live_t* p_live, int car, const live_car_t* p_car);
+
+
+/**
+ * @brief Map the live segment of a controller for reading
+ *
+ * @param[in] name  Name of the segment
+ *
+ * @return The segment, or NULL if there is no live segment of this layout and building by that name
+ */
+const live_segment_t* live_attach(const char* name);
+
+
+/**
+ * @brief Copy what a car last published
+ *
+ * @param[in] p_segment     The segment
+ * @param[in] car           The car
+ * @param[out] p_car        The copy
+ *
+ * @return 0 on success, and -1 if every try overlapped a publication or the car has not published
+ */
+int live_read(const live_segment_t* p_segment, int car, live_car_t* p_car);
+
+
+#endif //LIVE_H
@@ -2,14 +2,291 @@
  * @file
  * @brief main linker point of elevator program
  */
+#define _POSIX_C_SOURCE 200809L
+
+#include <signal.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
 
+#include "demand.h"
+#include "driver/io.h"
+#include "driver/io_record.h"
 #include "elevator_fsm.h"
 #include "elevator_io.h"
+#include "globals.h"
+#include "group.h"
+#include "journal.h"
+#include "latency.h"
+#include "live.h"
+#include "scheduler.h"
+#include "snapshot.h"
+
+
+/**
+ * @brief Run one control cycle of the elevator
+ *
+ * @param[in, out] arg  Pointer to the @c elevator_data_t of the elevator
+ */
+static void control_tick(void* arg) {
+    elevator_tick(arg);
+}
+
+
+/**
+ * @brief Time until the next timer of the elevator expires
+ *
+ * @param[in, out] arg  Pointer to the @c elevator_data_t of the elevator
+ *
+ * @return Nanoseconds until the next deadline, or -1 if no timer is running
+ */
+static long long control_until_deadline(void* arg) {
+    elevator_data_t* p_elevator_data = arg;
+    return timer_until_next_deadline(&p_elevator_data->timers);
+}
+
+
+/**
+ * @brief Run one control cycle of a bank of elevators
+ *
+ * @param[in, out] arg  Pointer to the @c group_t of the bank
+ */
+static void group_control_tick(void* arg) {
+    group_tick(arg);
+}
+
+
+/**
+ * @brief Time until the next timer of any car in a bank expires
+ *
+ * @param[in, out] arg  Pointer to the @c group_t of the bank
+ *
+ * @return Nanoseconds until the next deadline, or -1 if no timer is running
+ */
+static long long group_control_until_deadline(void* arg) {
+    return group_until_next_deadline(arg);
+}
+
+
+/**
+ * @brief Start the input sampler for @p car_count cars, unless @p sample_rate_hz is 0
+ */
+static void start_sampler(int car_count, int sample_rate_hz) {
+    if(sample_rate_hz > 0 && hardware_start_sampler(car_count, sample_rate_hz) != 0) {
+        fprintf(stderr, "Unable to start the input sampler; sampling once per control cycle\n");
+    }
+}
+
+
+/**
+ * @brief Stop the input sampler and print what it did for every car to @p stream
+ */
+static void stop_sampler(int car_count, int sample_rate_hz, FILE* stream) {
+    hardware_stop_sampler();
+    if(sample_rate_hz <= 0) {
+        return;
+    }
+
+    for(int car = 0; car < car_count; car++) {
+        HardwareSamplerStats stats = hardware_get_sampler_stats(car);
+        fprintf(stream, "Sampler car %d: %lld samples at %d Hz, %lld edges, %lld deferred, %lld reflex stops, edge age mean %.0f us max %.0f us\n",
+                car, stats.samples, sample_rate_hz, stats.edges, stats.deferred, stats.reflex_stops,
+                stats.drained > 0 ? stats.edge_age_sum_ns * 1e-3 / stats.drained : 0.0, stats.edge_age_max_ns * 1e-3);
+    }
+}
+
+
+/**
+ * @brief Print the round trips per control cycle of a driver that batches its I/O, and nothing for one that does not
+ */
+static void print_io_stats(const scheduler_stats_t* p_stats, FILE* stream) {
+    IoStats io;
+    if(!io_get_stats(&io)) {
+        return;
+    }
+    long long cycles = p_stats->ticks + p_stats->deadline_ticks;
+    fprintf(stream, "I/O: %lld calls in %lld round trips and %lld write batches, %.2f round trips and %.2f write batches per control cycle, round trip mean %.1f us max %.1f us\n",
+            io.calls, io.round_trips, io.write_batches,
+            cycles > 0 ? (double)io.round_trips / cycles : 0.0, cycles > 0 ? (double)io.write_batches / cycles : 0.0,
+            io.round_trips > 0 ? io.round_trip_sum_ns * 1e-3 / io.round_trips : 0.0, io.round_trip_max_ns * 1e-3);
+}
+
+
+/**
+ * @brief Run a bank of @p car_count elevators under a group controller until shutdown
+ */
+static void run_group(int rate_hz, int sample_rate_hz, int car_count, queue_policy_t policy, int cruise_speed,
+                      door_policy_t door_policy, demand_t* p_demand, snapshot_t* p_snapshot, live_t* p_live) {
+    static group_t group;
+    int warm = group_init_from_snapshot(&group, car_count, GROUP_POLICY_ETA, p_snapshot);
+    if(warm < 0) {
+        fprintf(stderr, "Unable to initialize hardware for %d cars\n", car_count);
+        exit(1);
+    }
+    if(p_snapshot != NULL) {
+        printf("Warm restart of %d of %d cars, with %d hall calls\n", warm, car_count, group.call_count);
+    }
+    for(int car = 0; car < car_count; car++) {
+        group.cars[car].policy = policy;
+        group.cars[car].motion.profile.cruise_speed = cruise_speed;
+        group.cars[car].door.policy = door_policy;
+        group.cars[car].p_live = p_live;
+    }
+    group.p_demand = p_demand;
+    start_sampler(car_count, sample_rate_hz);
+
+    scheduler_stats_t stats;
+    sigset_t previous_mask;
+    if(scheduler_run(rate_hz, group_control_tick, group_control_until_deadline, &group, &stats, &previous_mask) != 0) {
+        fprintf(stderr, "Unable to set up the control loop\n");
+        hardware_stop_sampler();
+        group_stop(&group);
+        exit(1);
+    }
+
+    printf("Terminating elevators\n");
+    stop_sampler(car_count, sample_rate_hz, stdout);
+    group_stop(&group);
+    sigprocmask(SIG_SETMASK, &previous_mask, NULL);
+
+    scheduler_print_stats(&stats, stdout);
+    print_io_stats(&stats, stdout);
+    for(int car = 0; car < car_count; car++) {
+        elevator_print_homing(&group.cars[car], stdout);
+    }
+    group_print_stats(&group, stdout);
+    LATENCY_PRINT(stdout);
+}
+
+
+/**
+ * @brief Wall clock time when @c timer_now_ns() is 0, for the snapshots
+ */
+static long long wall_offset_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec - timer_now_ns();
+}
+
+
+/**
+ * @brief Local time of day when @c timer_now_ns() is 0, for the demand model
+ */
+static long long day_offset_ns() {
+    struct timespec ts;
+    struct tm local;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    localtime_r(&ts.tv_sec, &local);
+    long long time_of_day = ((local.tm_hour * 60LL + local.tm_min) * 60 + local.tm_sec) * 1000000000LL + ts.tv_nsec;
+    return time_of_day - timer_now_ns();
+}
+
 
+int main(int argc, char** argv){
+    int rate_hz = CONTROL_RATE_HZ;
+    int sample_rate_hz = SAMPLE_RATE_HZ;
+    int car_count = 1;
+    int cruise_speed = MOTOR_CRUISE_SPEED;
+    queue_policy_t policy = QUEUE_POLICY_LOOK;
+    door_policy_t door_policy = DOOR_POLICY_ADAPTIVE;
+    int opt;
+    const char* journal_path = NULL;
+    const char* record_path = NULL;
+    const char* demand_path = NULL;
+    const char* snapshot_path = NULL;
+    const char* live_name = NULL;
+    while((opt = getopt(argc, argv, "r:s:c:m:p:d:D:S:l:j:R:")) != -1) {
+        if(opt == 'r' && atoi(optarg) > 0) {
+            rate_hz = atoi(optarg);
+        }
+        else if(opt == 's' && atoi(optarg) >= 0) {
+            sample_rate_hz = atoi(optarg);
+        }
+        else if(opt == 'c' && atoi(optarg) > 0 && atoi(optarg) <= GROUP_MAX_CARS) {
+            car_count = atoi(optarg);
+        }
+        else if(opt == 'm' && atoi(optarg) > 0 && atoi(optarg) <= MOTOR_SPEED_MAX) {
+            cruise_speed = atoi(optarg);
+        }
+        else if(opt == 'd' && door_policy_from_name(optarg, &door_policy) == 0) {
+            continue;
+        }
+        else if(opt == 'D') {
+            demand_path = optarg;
+        }
+        else if(opt == 'S') {
+            snapshot_path = optarg;
+        }
+        else if(opt == 'l') {
+            live_name = optarg;
+        }
+        else if(opt == 'j') {
+            journal_path = optarg;
+        }
+        else if(opt == 'R') {
+            record_path = optarg;
+        }
+        else if(opt != 'p' || queue_policy_from_name(optarg, &policy) != 0) {
+            fprintf(stderr, "Usage: %s [-r control_rate_hz] [-s sample_rate_hz] [-c cars] [-m cruise_speed] [-p fifo|look|nearest] [-d fixed|adaptive] [-D demand_file] [-S snapshot_file] [-l live_segment] [-j journal_file] [-R recording]\n", argv[0]);
+            exit(1);
+        }
+    }
+
+    if(journal_path != NULL && journal_open(journal_path) != 0) {
+        fprintf(stderr, "Unable to open journal %s\n", journal_path);
+        exit(1);
+    }
+
+    // Started before the hardware, so the recording holds the inputs the controller starts from
+    if(record_path != NULL && io_record_open(record_path, rate_hz, car_count) != 0) {
+        fprintf(stderr, "Unable to create recording %s\n", record_path);
+        exit(1);
+    }
+
+    // Idle cars are parked by a demand model that is kept across restarts
+    static demand_t demand;
+    demand_t* p_demand = NULL;
+    if(demand_path != NULL) {
+        if(demand_open(&demand, demand_path, day_offset_ns()) != 0) {
+            fprintf(stderr, "Unable to open demand model %s\n", demand_path);
+            exit(1);
+        }
+        p_demand = &demand;
+    }
+
+    // The cars restart from the snapshots of the last run, and save theirs as they go
+    static snapshot_t snapshot;
+    snapshot_t* p_snapshot = NULL;
+    if(snapshot_path != NULL) {
+        if(snapshot_open(&snapshot, snapshot_path, wall_offset_ns()) != 0) {
+            fprintf(stderr, "Unable to open snapshot file %s\n", snapshot_path);
+            exit(1);
+        }
+        p_snapshot = &snapshot;
+    }
+
+    // Monitors such as elevator-top read the live state of the cars from shared memory
+    static live_t live;
+    live_t* p_live = NULL;
+    if(live_name != NULL) {
+        if(live_open(&live, live_name, car_count) != 0) {
+            fprintf(stderr, "Unable to make live segment %s\n", live_name);
+            exit(1);
+        }
+        p_live = &live;
+    }
+
+    if(car_count > 1) {
+        run_group(rate_hz, sample_rate_hz, car_count, policy, cruise_speed, door_policy, p_demand, p_snapshot, p_live);
+        live_close(&live);
+        snapshot_close(&snapshot);
+        demand_close(&demand);
+        journal_close();
+        io_record_close();
+        return 0;
+    }
 
-int main(){
     // ELEVATOR INITIAL SETUP
     int error = hardware_init();
     if(error != 0){
@@ -17,15 +294,43 @@ int main(){
         exit(1);
     }
     
-    elevator_data_t elevator_data = elevator_init();
+    elevator_data_t elevator_data;
+    int warm = elevator_init_from_snapshot(&elevator_data, p_snapshot, 0);
+    if(p_snapshot != NULL) {
+        Order orders[QUEUE_SIZE];
+        printf("%s restart, with %d orders\n", warm ? "Warm" : "Cold", queue_get_orders(&elevator_data.queue, orders));
+    }
+    elevator_data.policy = policy;
+    elevator_data.motion.profile.cruise_speed = cruise_speed;
+    elevator_data.door.policy = door_policy;
+    elevator_data.p_demand = p_demand;
+    elevator_data.p_live = p_live;
+    start_sampler(1, sample_rate_hz);
 
-    while (1){
-        elevator_data.last_floor = update_valid_floor(elevator_data.last_floor);
+    scheduler_stats_t stats;
+    sigset_t previous_mask;
+    if(scheduler_run(rate_hz, control_tick, control_until_deadline, &elevator_data, &stats, &previous_mask) != 0) {
+        fprintf(stderr, "Unable to set up the control loop\n");
+        hardware_stop_sampler();
+        hardware_command_movement(HARDWARE_MOVEMENT_STOP);
+        hardware_flush_outputs();
+        exit(1);
+    }
 
-        set_floor_indicator_light(get_current_floor());
-        update_button_state(&elevator_data);
+    printf("Terminating elevator\n");
+    stop_sampler(1, sample_rate_hz, stdout);
+    hardware_command_movement(HARDWARE_MOVEMENT_STOP);
+    hardware_flush_outputs();
+    sigprocmask(SIG_SETMASK, &previous_mask, NULL);
 
-        elevator_data.next_action = elevator_update_state(&elevator_data);
-        elevator_execute_next_action(&elevator_data);
-    }
-}
\ No newline at end of file
+    scheduler_print_stats(&stats, stdout);
+    print_io_stats(&stats, stdout);
+    elevator_print_homing(&elevator_data, stdout);
+    LATENCY_PRINT(stdout);
+    live_close(&live);
+    snapshot_close(&snapshot);
+    demand_close(&demand);
+    journal_close();
+    io_record_close();
+    return 0;
+}
@@ -0,0 +1,61 @@
+#include "motion.h"
+#include "globals.h"
+#include "timer.h"
+
+
+void motion_init(motion_t* p_motion) {
+    p_motion->profile.cruise_speed = MOTOR_CRUISE_SPEED;
+    p_motion->profile.landing_speed = MOTOR_LANDING_SPEED;
+    p_motion->profile.landing_floors = MOTOR_LANDING_FLOORS;
+    p_motion->profile.ramp_per_s = MOTOR_RAMP_PER_S;
+    motion_stop(p_motion);
+}
+
+
+motion_profile_t motion_fixed_profile() {
+    motion_profile_t profile = { .cruise_speed = MOTOR_LANDING_SPEED, .landing_speed = MOTOR_LANDING_SPEED,
+                                 .landing_floors = MOTOR_LANDING_FLOORS, .ramp_per_s = 0 };
+    return profile;
+}
+
+
+int motion_update(motion_t* p_motion, double distance_to_stop) {
+    const motion_profile_t* p_profile = &p_motion->profile;
+    long long now = timer_now_ns();
+
+    // An unknown stop may be the next floor, so it is landed at
+    int target = (distance_to_stop > p_profile->landing_floors) ? p_profile->cruise_speed : p_profile->landing_speed;
+    if(p_motion->speed == 0) {
+        p_motion->ramp_from = 0;
+        p_motion->ramp_from_ns = now - 1000000000LL / CONTROL_RATE_HZ;
+        p_motion->ramp_to = target;
+    }
+    else if(target != p_motion->ramp_to) {
+        p_motion->ramp_from = p_motion->speed;
+        p_motion->ramp_from_ns = now;
+        p_motion->ramp_to = target;
+    }
+
+    int speed = target;
+    if(p_profile->ramp_per_s > 0) {
+        long long step = (long long)p_profile->ramp_per_s * (now - p_motion->ramp_from_ns) / 1000000000LL;
+        if(target > p_motion->ramp_from + step) {
+            speed = p_motion->ramp_from + step;
+        }
+        else if(target < p_motion->ramp_from - step) {
+            speed = p_motion->ramp_from - step;
+        }
+    }
+
+    // A motor commanded to 0 would stop instead of starting
+    p_motion->speed = (speed > 0) ? speed : 1;
+    return p_motion->speed;
+}
+
+
+void motion_stop(motion_t* p_motion) {
+    p_motion->speed = 0;
+    p_motion->ramp_to = 0;
+    p_motion->ramp_from = 0;
+    p_motion->ramp_from_ns = 0;
+}
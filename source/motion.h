@@ -0,0 +1,76 @@
+/**
+ * @file
+ * @brief Speed profile of the elevator's motor.
+ *
+ * A run ramps the motor up to a cruise speed, and back down to a landing speed once the elevator
+ * is within a landing distance of where it stops, so long runs are fast and every stop is made at
+ * the speed the floor sensors were sized for. The speed only changes by a bounded amount per second, on the
+ * clock of @c timer_now_ns() . The speed is a function of the time since the ramp it is on started,
+ * not of how many control cycles ran since, so the profile is the same against the simulated plant on
+ * a virtual clock and in a replay as on the lab rig.
+ *
+ * Speeds are values of the motor's DAC, as written by @c hardware_command_motor_speed() .
+ */
+#ifndef MOTION_H
+#define MOTION_H
+
+
+/**
+ * The shape of a run
+ */
+typedef struct{
+    int cruise_speed;           /**< Speed between floors when the stop is more than a floor away*/
+    int landing_speed;          /**< Speed over the landing distance before a stop*/
+    double landing_floors;      /**< The landing distance, in floors*/
+    int ramp_per_s;             /**< Most the speed may change by in a second, or 0 to change it at once*/
+} motion_profile_t;
+
+
+/**
+ * The motor of one elevator as the profile drives it
+ */
+typedef struct{
+    motion_profile_t profile;   /**< The profile runs follow*/
+    int speed;                  /**< Speed last commanded, or 0 if the motor is stopped*/
+    int ramp_to;                /**< Speed the current ramp heads for*/
+    int ramp_from;              /**< Speed the current ramp started from*/
+    long long ramp_from_ns;     /**< When the current ramp started*/
+} motion_t;
+
+
+/**
+ * @brief Initialize @p p_motion with the motor stopped and the default profile
+ *
+ * @param[out] p_motion     The motion to initialize
+ */
+void motion_init(motion_t* p_motion);
+
+
+/**
+ * @brief The profile that drives every run at one fixed speed, as the motor was driven before it had a profile
+ */
+motion_profile_t motion_fixed_profile();
+
+
+/**
+ * @brief Advance a run by one control cycle
+ *
+ * @param[in, out] p_motion     The motion of the elevator
+ * @param[in] distance_to_stop  Floors left to the stop, as far as is known, or a negative number if it
+ *                              is not known where the elevator stops
+ *
+ * @return The speed to command, never 0. The first cycle of a run counts as one control period at
+ * @c CONTROL_RATE_HZ since the motor started.
+ */
+int motion_update(motion_t* p_motion, double distance_to_stop);
+
+
+/**
+ * @brief Note that the motor has stopped, so the next run ramps up from standstill
+ *
+ * @param[in, out] p_motion     The motion of the elevator
+ */
+void motion_stop(motion_t* p_motion);
+
+
+#endif //MOTION_H
@@ -0,0 +1,160 @@
+#include <math.h>
+#include <stdlib.h>
+
+#include "position.h"
+#include "globals.h"
+#include "timer.h"
+
+
+void position_init(position_t* p_position, int floor) {
+    p_position->floor = floor;
+    p_position->velocity = 0.0;
+    p_position->gain = 1e9 / ((double)FLOOR_TRAVEL_TIME_NS * MOTOR_LANDING_SPEED);
+    p_position->gain_samples = 0;
+    p_position->last_sensor = floor;
+    p_position->at_sensor = 1;
+    p_position->last_direction = 1;
+    p_position->updated_ns = timer_now_ns();
+
+    p_position->pass_from = FLOOR_NOT_INIT;
+    p_position->pass_start_ns = 0;
+    p_position->pass_drive = 0.0;
+    p_position->run_from = FLOOR_NOT_INIT;
+    p_position->run_start_ns = 0;
+
+    for(int f = 0; f < HARDWARE_NUMBER_OF_FLOORS; f++) {
+        p_position->pass_ns[f] = -1;
+    }
+    p_position->floor_ns = FLOOR_TRAVEL_TIME_NS;
+    p_position->landing_ns[0] = 0;
+    p_position->landing_ns[1] = 0;
+}
+
+
+static long long position_learn(long long average, long long sample) {
+    return average + (sample - average) / POSITION_LEARNING_WEIGHT;
+}
+
+
+static long long position_pass_ns(const position_t* p_position, int floor) {
+    return (p_position->pass_ns[floor] >= 0) ? p_position->pass_ns[floor] : p_position->floor_ns;
+}
+
+
+/**
+ * @brief Learn from a pass between the sensors of two neighbouring floors, ending at @p floor now
+ */
+static void position_learn_pass(position_t* p_position, int floor, long long now) {
+    int below = (floor < p_position->pass_from) ? floor : p_position->pass_from;
+    long long sample = now - p_position->pass_start_ns;
+
+    p_position->pass_ns[below] = (p_position->pass_ns[below] >= 0) ? position_learn(p_position->pass_ns[below], sample) : sample;
+    p_position->floor_ns = position_learn(p_position->floor_ns, sample);
+
+    // The pass covers exactly one floor, from the edge of one sensor to the same edge of the next
+    if(p_position->pass_drive > 0.0) {
+        double gain = 1.0 / p_position->pass_drive;
+        p_position->gain = (p_position->gain_samples == 0) ? gain : p_position->gain + (gain - p_position->gain) / POSITION_LEARNING_WEIGHT;
+        p_position->gain_samples++;
+    }
+}
+
+
+/**
+ * @brief Learn from a run that started at a floor and ended at @p floor now
+ */
+static void position_learn_run(position_t* p_position, int floor, long long now) {
+    int floors = abs(floor - p_position->run_from);
+    if(floors == 0) {
+        return;
+    }
+    long long sample = now - p_position->run_start_ns - position_travel_ns(p_position, p_position->run_from, floor);
+    long long* p_landing = &p_position->landing_ns[floors > 1];
+    *p_landing = (*p_landing != 0) ? position_learn(*p_landing, sample) : sample;
+}
+
+
+void position_update(position_t* p_position, int current_floor, int speed) {
+    long long now = timer_now_ns();
+    double dt = (now - p_position->updated_ns) * 1e-9;
+    p_position->updated_ns = now;
+    int direction = (speed > 0) - (speed < 0);
+    int at_sensor = (current_floor != BETWEEN_FLOORS);
+
+    // A run starts when the motor does, and is learned from if it both starts and ends at a floor
+    if(speed != 0 && p_position->run_from == FLOOR_NOT_INIT) {
+        p_position->run_from = at_sensor ? current_floor : BETWEEN_FLOORS;
+        p_position->run_start_ns = now;
+    }
+    else if(speed == 0 && p_position->run_from != FLOOR_NOT_INIT) {
+        if(at_sensor && p_position->run_from != BETWEEN_FLOORS) {
+            position_learn_run(p_position, current_floor, now);
+        }
+        p_position->run_from = FLOOR_NOT_INIT;
+    }
+
+    if(speed != 0) {
+        p_position->last_direction = direction;
+        p_position->pass_drive += abs(speed) * dt;
+    }
+    else {
+        // A stop on the way breaks the pass
+        p_position->pass_from = FLOOR_NOT_INIT;
+    }
+
+    if(at_sensor) {
+        if(!p_position->at_sensor || current_floor != p_position->last_sensor) {
+            if(p_position->pass_from != FLOOR_NOT_INIT && abs(current_floor - p_position->pass_from) == 1) {
+                position_learn_pass(p_position, current_floor, now);
+            }
+            p_position->pass_from = (speed != 0) ? current_floor : FLOOR_NOT_INIT;
+            p_position->pass_start_ns = now;
+            p_position->pass_drive = 0.0;
+        }
+        p_position->floor = current_floor;
+        p_position->last_sensor = current_floor;
+    }
+    else {
+        p_position->floor += p_position->gain * speed * dt;
+
+        // Off the sensor the elevator is somewhere between the floors around it, but not at one
+        double offset = p_position->floor - p_position->last_sensor;
+        if(fabs(offset) < POSITION_SENSOR_MARGIN) {
+            offset = (offset != 0.0 ? (offset > 0.0 ? 1 : -1) : p_position->last_direction) * POSITION_SENSOR_MARGIN;
+        }
+        offset = fmax(offset, -1.0 + POSITION_SENSOR_MARGIN);
+        offset = fmin(offset, 1.0 - POSITION_SENSOR_MARGIN);
+        p_position->floor = p_position->last_sensor + offset;
+    }
+    p_position->at_sensor = at_sensor;
+    p_position->velocity = p_position->gain * speed;
+}
+
+
+double position_distance_to(const position_t* p_position, int floor) {
+    if(p_position->gain_samples >= POSITION_CALIBRATION_PASSES) {
+        return fabs(floor - p_position->floor);
+    }
+    int sensors = abs(floor - p_position->last_sensor) - 1;
+    return (sensors > 0) ? sensors : 0.0;
+}
+
+
+long long position_travel_ns(const position_t* p_position, double from, int to) {
+    double low = (from < to) ? from : to;
+    double high = (from < to) ? to : from;
+    long long travel = 0;
+
+    for(int f = (int)floor(low); f < high && f < HARDWARE_NUMBER_OF_FLOORS; f++) {
+        double covered = fmin(high, f + 1) - fmax(low, f);
+        if(f >= MIN_FLOOR && covered > 0.0) {
+            travel += (long long)(covered * position_pass_ns(p_position, f));
+        }
+    }
+    return travel;
+}
+
+
+long long position_landing_ns(const position_t* p_position, int floors) {
+    return (floors > 0) ? p_position->landing_ns[floors > 1] : 0;
+}
@@ -0,0 +1,103 @@
+/**
+ * @file
+ * @brief Estimate of where the elevator is between its floor sensors, and how long it takes to travel.
+ *
+ * The floor sensors only tell where the elevator is while it is at a floor. In between, the
+ * position is dead-reckoned from the speed commanded to the motor and the time since the last
+ * control cycle, through a gain from motor speed to floors per second. The estimate snaps to the
+ * floor at every sensor, and never leaves the floors around the sensor the elevator last passed.
+ *
+ * Everything the estimate needs is learned online, as exponentially weighted averages:
+ * - the gain, from the motor drive between the sensors of two neighbouring floors passed without stopping;
+ * - the time to pass every floor at speed, from the same passes;
+ * - the time a run spends starting and landing, from the runs that end at a floor, separately for runs of one floor.
+ *
+ * Until they have been seen, passes take @c FLOOR_TRAVEL_TIME_NS and runs take no time to start
+ * and land. Until the gain has been learned from @c POSITION_CALIBRATION_PASSES passes,
+ * @c position_distance_to() only counts the floors the elevator is sure to still pass.
+ */
+#ifndef POSITION_H
+#define POSITION_H
+
+#include "driver/hardware.h"
+
+
+#define POSITION_LEARNING_WEIGHT 8      /**< A new sample of a learned value weighs 1 / this */
+#define POSITION_CALIBRATION_PASSES 3   /**< Passes learned before the dead-reckoned position is trusted */
+#define POSITION_SENSOR_MARGIN 0.05     /**< Floors the estimate keeps away from a floor whose sensor is not active */
+
+
+/**
+ * Where one elevator is, and what has been learned about how it travels
+ */
+typedef struct{
+    double floor;                               /**< Estimated position, in floors from the bottom floor*/
+    double velocity;                            /**< Estimated velocity, in floors per second. Positive is upwards*/
+    double gain;                                /**< Floors per second per unit of motor speed*/
+    int gain_samples;                           /**< Passes the gain has been learned from*/
+    int last_sensor;                            /**< The floor whose sensor the elevator was last at*/
+    int at_sensor;                              /**< 1 if the elevator was at a floor sensor in the last update*/
+    int last_direction;                         /**< 1 or -1 for the direction the motor last drove the elevator in*/
+    long long updated_ns;                       /**< When the estimate was last updated*/
+
+    int pass_from;                              /**< Floor whose sensor a pass started at, or @c FLOOR_NOT_INIT*/
+    long long pass_start_ns;                    /**< When the pass started*/
+    double pass_drive;                          /**< Motor speed integrated over the pass, in speed units times seconds*/
+
+    int run_from;                               /**< Floor a run started from, or @c FLOOR_NOT_INIT if the motor is stopped*/
+    long long run_start_ns;                     /**< When the run started*/
+
+    long long pass_ns[HARDWARE_NUMBER_OF_FLOORS];   /**< Time to pass from every floor to the one above, or -1 if not yet seen*/
+    long long floor_ns;                         /**< Time to pass any floor, for the floors not yet seen*/
+    long long landing_ns[2];                    /**< Time a run spends starting and landing, for runs of one floor and of more*/
+} position_t;
+
+
+/**
+ * @brief Initialize @p p_position at a floor, with nothing learned
+ *
+ * @param[out] p_position   The estimate to initialize
+ * @param[in] floor         The floor the elevator stands at
+ */
+void position_init(position_t* p_position, int floor);
+
+
+/**
+ * @brief Advance the estimate by one control cycle, and learn from any sensor reached or run ended
+ *
+ * @param[in, out] p_position   The estimate
+ * @param[in] current_floor     The floor whose sensor is active, or @c BETWEEN_FLOORS
+ * @param[in] speed             The motor speed commanded since the last update, negative downwards, or 0 if stopped
+ */
+void position_update(position_t* p_position, int current_floor, int speed);
+
+
+/**
+ * @brief Distance from the elevator to a floor
+ *
+ * @param[in] p_position    The estimate
+ * @param[in] floor         The floor
+ *
+ * @return The estimated distance in floors once the gain has been learned, and before that the
+ * number of floor sensors between the next one ahead and @p floor , which the distance is at least
+ */
+double position_distance_to(const position_t* p_position, int floor);
+
+
+/**
+ * @brief Time to travel between two positions at speed, not counting starting and landing
+ *
+ * @param[in] p_position    The estimate with the learned travel times
+ * @param[in] from          Where to travel from, in floors; need not be a floor
+ * @param[in] to            The floor to travel to
+ */
+long long position_travel_ns(const position_t* p_position, double from, int to);
+
+
+/**
+ * @brief Time a run of @p floors floors spends starting and landing, on top of its travel time
+ */
+long long position_landing_ns(const position_t* p_position, int floors);
+
+
+#endif //POSITION_H
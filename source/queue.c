@@ -1,110 +1,322 @@
+#include <string.h>
+
 #include "queue.h"
-#include "elevator_io.h"
-#include <stdio.h>
 
 
-int queue_empty() {
-    queue_refactor();
-    return QUEUE[0].target_floor == FLOOR_NOT_INIT;
+static int queue_slot(int floor, HardwareOrder order_type) {
+    return order_type * HARDWARE_NUMBER_OF_FLOORS + floor;
 }
 
 
-void queue_init() {
-    for(int i = 0; i < QUEUE_SIZE; i++) {
-        queue_set_order(i, FLOOR_NOT_INIT, HARDWARE_ORDER_NOT_INIT);
-    }
+static uint64_t queue_floor_bit(int floor) {
+    return (uint64_t)1 << (floor % QUEUE_WORD_BITS);
 }
 
 
-void queue_set_order(int idx, int target_floor, HardwareOrder order_type) {
-    QUEUE[idx].target_floor = target_floor;
-    QUEUE[idx].order_type = order_type;
+static int queue_test(const queue_t* p_queue, HardwareOrder order_type, int floor) {
+    return (p_queue->pending[order_type][floor / QUEUE_WORD_BITS] & queue_floor_bit(floor)) != 0;
 }
 
 
-void queue_erase(int* p_orders_up, int* p_orders_down, int* p_orders_cab){
-    for(int floor = 0; floor < HARDWARE_NUMBER_OF_FLOORS; floor++) {
-        queue_clear_order_at_floor(p_orders_up, p_orders_down, p_orders_cab, floor);
+static void queue_unlink(queue_t* p_queue, int slot) {
+    int prev = p_queue->prev[slot];
+    int next = p_queue->next[slot];
+
+    if(prev >= 0) {
+        p_queue->next[prev] = next;
+    }
+    else {
+        p_queue->oldest = next;
+    }
+
+    if(next >= 0) {
+        p_queue->prev[next] = prev;
+    }
+    else {
+        p_queue->youngest = prev;
     }
 }
 
 
-void queue_push_back(int target_floor, HardwareOrder order_type) {
-    for(int order = 0; order < QUEUE_SIZE; order++) {
-        if(queue_check_order_match(target_floor, order_type) == 1) {
-            return; // Return if we have an order with the same parameters in the queue already
-        }
+void queue_remove(queue_t* p_queue, int floor, HardwareOrder order_type) {
+    if(!queue_test(p_queue, order_type, floor)) {
+        return;
     }
+    p_queue->pending[order_type][floor / QUEUE_WORD_BITS] &= ~queue_floor_bit(floor);
+    queue_unlink(p_queue, queue_slot(floor, order_type));
+}
+
+
+// Floors of one word with an order of any type
+static uint64_t queue_stops_word(const queue_t* p_queue, int word) {
+    return p_queue->pending[HARDWARE_ORDER_UP][word] | p_queue->pending[HARDWARE_ORDER_INSIDE][word] | p_queue->pending[HARDWARE_ORDER_DOWN][word];
+}
 
-    for(int order = 0; order < QUEUE_SIZE; order++) {
-        if(QUEUE[order].target_floor == FLOOR_NOT_INIT) {
-            queue_set_order(order, target_floor, order_type);
-            break;
+
+// Bits of the floors from bit @p low to bit @p high of a word, both included
+static uint64_t queue_bit_range(int low, int high) {
+    uint64_t below_high = (high == QUEUE_WORD_BITS - 1) ? ~(uint64_t)0 : ((uint64_t)1 << (high + 1)) - 1;
+    return below_high & ~(((uint64_t)1 << low) - 1);
+}
+
+
+int queue_empty(const queue_t* p_queue) {
+    return p_queue->oldest < 0;
+}
+
+
+static void queue_clear_pending(queue_t* p_queue) {
+    for(int type = 0; type < QUEUE_ORDER_TYPES; type++) {
+        for(int word = 0; word < QUEUE_WORDS; word++) {
+            p_queue->pending[type][word] = 0;
         }
     }
+    p_queue->oldest = -1;
+    p_queue->youngest = -1;
 }
 
 
-void queue_clear_order_at_floor(int* p_orders_up, int* p_orders_down, int* p_orders_cab, int current_floor) {
-    for(int order = 0; order < QUEUE_SIZE; order++) {
-        if(QUEUE[order].target_floor == current_floor) {
-            queue_set_order(order, FLOOR_NOT_INIT, HARDWARE_ORDER_NOT_INIT);
+void queue_init(queue_t* p_queue) {
+    queue_clear_pending(p_queue);
+    // hardware_init() turns every button light off
+    for(int type = 0; type < QUEUE_ORDER_TYPES; type++) {
+        for(int word = 0; word < QUEUE_WORDS; word++) {
+            p_queue->lit[type][word] = 0;
         }
     }
+}
 
-    p_orders_cab[current_floor] = 0;
-    p_orders_up[current_floor] = 0;
-    p_orders_down[current_floor] = 0;
 
-    queue_update();
+void queue_erase(queue_t* p_queue){
+    queue_clear_pending(p_queue);
 }
 
 
-void queue_refactor(){
-    for(int order = 0; order < QUEUE_SIZE; order++){
-        if(QUEUE[order].target_floor == FLOOR_NOT_INIT){
-            for(int hole = order; hole < QUEUE_SIZE; hole++){
-                if(QUEUE[hole].target_floor != FLOOR_NOT_INIT){
-                    queue_set_order(order, QUEUE[hole].target_floor, QUEUE[hole].order_type);
-                    queue_set_order(hole, FLOOR_NOT_INIT, HARDWARE_ORDER_NOT_INIT);
-                    break;
+void queue_push_back(queue_t* p_queue, int target_floor, HardwareOrder order_type) {
+    if(queue_test(p_queue, order_type, target_floor)) {
+        return; // Return if we have an order with the same parameters in the queue already
+    }
+    p_queue->pending[order_type][target_floor / QUEUE_WORD_BITS] |= queue_floor_bit(target_floor);
+
+    int slot = queue_slot(target_floor, order_type);
+    p_queue->prev[slot] = p_queue->youngest;
+    p_queue->next[slot] = -1;
+    if(p_queue->youngest >= 0) {
+        p_queue->next[p_queue->youngest] = slot;
+    }
+    else {
+        p_queue->oldest = slot;
+    }
+    p_queue->youngest = slot;
+}
+
+
+static HardwareOrder queue_hall_order(HardwareMovement direction) {
+    return (direction == HARDWARE_MOVEMENT_DOWN) ? HARDWARE_ORDER_DOWN : HARDWARE_ORDER_UP;
+}
+
+
+static HardwareMovement queue_opposite(HardwareMovement direction) {
+    return (direction == HARDWARE_MOVEMENT_DOWN) ? HARDWARE_MOVEMENT_UP : HARDWARE_MOVEMENT_DOWN;
+}
+
+
+// The floor @p policy picks among the orders at floors other than @p floor
+static int queue_next_away(const queue_t* p_queue, queue_policy_t policy, int floor, HardwareMovement direction) {
+    switch(policy) {
+        case QUEUE_POLICY_FIFO:
+            for(int slot = p_queue->oldest; slot >= 0; slot = p_queue->next[slot]) {
+                if(slot % HARDWARE_NUMBER_OF_FLOORS != floor) {
+                    return slot % HARDWARE_NUMBER_OF_FLOORS;
                 }
             }
+            return FLOOR_NOT_INIT;
+
+        case QUEUE_POLICY_LOOK:
+            if(direction != HARDWARE_MOVEMENT_STOP) {
+                int ahead = queue_farthest_stop(p_queue, floor, direction);
+                return (ahead != FLOOR_NOT_INIT) ? ahead : queue_farthest_stop(p_queue, floor, queue_opposite(direction));
+            }
+            // A car that has not moved yet starts its sweep towards the nearest order
+            // Fall through
+        default: {
+            int above = queue_nearest_stop(p_queue, floor, HARDWARE_MOVEMENT_UP);
+            int below = queue_nearest_stop(p_queue, floor, HARDWARE_MOVEMENT_DOWN);
+            if(above == FLOOR_NOT_INIT || below == FLOOR_NOT_INIT) {
+                return (above == FLOOR_NOT_INIT) ? below : above;
+            }
+            if(above - floor == floor - below) {
+                return (direction == HARDWARE_MOVEMENT_DOWN) ? below : above;
+            }
+            return (above - floor < floor - below) ? above : below;
         }
     }
 }
 
 
-int queue_check_order_match(int current_floor, HardwareOrder order_type) {
-    if(QUEUE[0].target_floor == current_floor) {
+/**
+ * @brief The hall order an elevator at @p floor serves: the one for the direction it leaves in
+ */
+static HardwareOrder queue_leaving_order(const queue_t* p_queue, queue_policy_t policy, int floor, HardwareMovement direction) {
+    int away = queue_next_away(p_queue, policy, floor, direction);
+    if(away != FLOOR_NOT_INIT) {
+        return (away > floor) ? HARDWARE_ORDER_UP : HARDWARE_ORDER_DOWN;
+    }
+
+    // Nothing to do elsewhere, so the elevator may leave either way
+    HardwareOrder order_type = queue_hall_order(direction);
+    if(!queue_test(p_queue, order_type, floor)) {
+        order_type = (order_type == HARDWARE_ORDER_UP) ? HARDWARE_ORDER_DOWN : HARDWARE_ORDER_UP;
+    }
+    return order_type;
+}
+
+
+void queue_clear_served_orders(queue_t* p_queue, queue_policy_t policy, int current_floor, HardwareMovement direction) {
+    if(current_floor < MIN_FLOOR || current_floor >= HARDWARE_NUMBER_OF_FLOORS) {
+        return;
+    }
+
+    queue_remove(p_queue, current_floor, HARDWARE_ORDER_INSIDE);
+    queue_remove(p_queue, current_floor, queue_leaving_order(p_queue, policy, current_floor, direction));
+}
+
+
+int queue_next_target(const queue_t* p_queue, queue_policy_t policy, int current_floor, HardwareMovement direction) {
+    if(queue_empty(p_queue)) {
+        return FLOOR_NOT_INIT;
+    }
+    if(current_floor < MIN_FLOOR || current_floor >= HARDWARE_NUMBER_OF_FLOORS) {
+        return queue_front(p_queue).target_floor;
+    }
+
+    // Stop here only for orders that would be cleared here, or the elevator never leaves
+    if(queue_test(p_queue, HARDWARE_ORDER_INSIDE, current_floor) ||
+       queue_test(p_queue, queue_leaving_order(p_queue, policy, current_floor, direction), current_floor)) {
+        return current_floor;
+    }
+    return queue_next_away(p_queue, policy, current_floor, direction);
+}
+
+
+int queue_check_order_match(const queue_t* p_queue, int current_floor, int target_floor, HardwareMovement direction) {
+    if(current_floor < MIN_FLOOR || current_floor >= HARDWARE_NUMBER_OF_FLOORS) {
+        return 0;
+    }
+
+    if(target_floor == current_floor) {
         return 1;
     }
 
-    for(int order = 1; order < QUEUE_SIZE; order++) {
-        Order current_order = QUEUE[order];
-        if(current_order.target_floor == current_floor && (current_order.order_type == order_type || current_order.order_type == HARDWARE_ORDER_INSIDE)) {
-            return 1;
-        }
+    if(direction == HARDWARE_MOVEMENT_STOP) {
+        return 0;
     }
 
-    return 0;
+    // Nothing is left ahead, for instance because the order was given to another car
+    return queue_nearest_stop(p_queue, current_floor, direction) == FLOOR_NOT_INIT;
 }
 
 
-void queue_update(){
-    if(get_current_floor() == BETWEEN_FLOORS){
-        return;
+int queue_has_order(const queue_t* p_queue, int floor, HardwareOrder order_type) {
+    return queue_test(p_queue, order_type, floor);
+}
+
+
+Order queue_front(const queue_t* p_queue) {
+    Order front = { .target_floor = FLOOR_NOT_INIT, .order_type = HARDWARE_ORDER_NOT_INIT };
+
+    if(p_queue->oldest >= 0) {
+        front.target_floor = p_queue->oldest % HARDWARE_NUMBER_OF_FLOORS;
+        front.order_type = p_queue->oldest / HARDWARE_NUMBER_OF_FLOORS;
+    }
+    return front;
+}
+
+
+int queue_get_orders(const queue_t* p_queue, Order* p_orders) {
+    int count = 0;
+    for(int slot = p_queue->oldest; slot >= 0; slot = p_queue->next[slot]) {
+        p_orders[count].target_floor = slot % HARDWARE_NUMBER_OF_FLOORS;
+        p_orders[count].order_type = slot / HARDWARE_NUMBER_OF_FLOORS;
+        count++;
     }
-    queue_refactor();
+    return count;
+}
+
+
+// Floors of a word with an order an elevator passing in @p direction stops for: inside, or a hall call its way
+static uint64_t queue_passing_word(const queue_t* p_queue, int word, HardwareMovement direction) {
+    return p_queue->pending[HARDWARE_ORDER_INSIDE][word] | p_queue->pending[queue_hall_order(direction)][word];
+}
 
-    if(QUEUE[0].target_floor == FLOOR_NOT_INIT){  // In the usual case this is true, as we call the update function whenever we clear the first element of the queue
-        for (int ord = 0; ord < QUEUE_SIZE; ord++){
-            if (ord < QUEUE_SIZE - 1){
-                queue_set_order(ord, QUEUE[ord + 1].target_floor, QUEUE[ord + 1].order_type);
+
+// The floor with an order beyond @p floor in @p direction that is farthest away, or nearest if @p farthest is 0.
+// With @p passing set, only the orders an elevator passing in @p direction stops for count
+static int queue_find_stop(const queue_t* p_queue, int floor, HardwareMovement direction, int farthest, int passing) {
+    if(direction == HARDWARE_MOVEMENT_UP && floor + 1 < HARDWARE_NUMBER_OF_FLOORS) {
+        int first_word = (floor + 1) / QUEUE_WORD_BITS;
+        for(int i = 0; i < QUEUE_WORDS - first_word; i++) {
+            int word = farthest ? QUEUE_WORDS - 1 - i : first_word + i;
+            uint64_t stops = passing ? queue_passing_word(p_queue, word, direction) : queue_stops_word(p_queue, word);
+            if(word == first_word) {
+                stops &= queue_bit_range((floor + 1) % QUEUE_WORD_BITS, QUEUE_WORD_BITS - 1);
+            }
+            if(stops) {
+                return word * QUEUE_WORD_BITS + (farthest ? QUEUE_WORD_BITS - 1 - __builtin_clzll(stops) : __builtin_ctzll(stops));
+            }
+        }
+    }
+    if(direction == HARDWARE_MOVEMENT_DOWN && floor > MIN_FLOOR) {
+        int last_word = (floor - 1) / QUEUE_WORD_BITS;
+        for(int i = 0; i <= last_word; i++) {
+            int word = farthest ? i : last_word - i;
+            uint64_t stops = passing ? queue_passing_word(p_queue, word, direction) : queue_stops_word(p_queue, word);
+            if(word == last_word) {
+                stops &= queue_bit_range(0, (floor - 1) % QUEUE_WORD_BITS);
             }
-            else if (ord == QUEUE_SIZE - 1){
-                queue_set_order(ord, FLOOR_NOT_INIT, HARDWARE_ORDER_NOT_INIT);
+            if(stops) {
+                return word * QUEUE_WORD_BITS + (farthest ? __builtin_ctzll(stops) : QUEUE_WORD_BITS - 1 - __builtin_clzll(stops));
             }
         }
     }
-}
\ No newline at end of file
+    return FLOOR_NOT_INIT;
+}
+
+
+int queue_farthest_stop(const queue_t* p_queue, int floor, HardwareMovement direction) {
+    return queue_find_stop(p_queue, floor, direction, 1, 0);
+}
+
+
+int queue_nearest_stop(const queue_t* p_queue, int floor, HardwareMovement direction) {
+    return queue_find_stop(p_queue, floor, direction, 0, 0);
+}
+
+
+int queue_nearest_passing_stop(const queue_t* p_queue, int floor, HardwareMovement direction) {
+    return queue_find_stop(p_queue, floor, direction, 0, 1);
+}
+
+
+const char* queue_policy_name(queue_policy_t policy) {
+    switch(policy) {
+        case QUEUE_POLICY_FIFO:
+            return "fifo";
+        case QUEUE_POLICY_LOOK:
+            return "look";
+        case QUEUE_POLICY_NEAREST:
+            return "nearest";
+    }
+    return "unknown";
+}
+
+
+int queue_policy_from_name(const char* name, queue_policy_t* p_policy) {
+    for(int policy = 0; policy < QUEUE_POLICY_COUNT; policy++) {
+        if(strcmp(name, queue_policy_name(policy)) == 0) {
+            *p_policy = policy;
+            return 0;
+        }
+    }
+    return -1;
+}
@@ -1,17 +1,43 @@
 /**
  * @file
- * @brief Library for managing the elevator's QUEUE system
+ * @brief Library for managing the elevator's order queue
+ *
+ * Pending orders are kept as one bit per floor and order type, so adding, matching and
+ * clearing orders are single word operations. Next to the bits, the pending orders are
+ * threaded into a doubly linked list in the order they were accepted, which keeps the
+ * first-come first-served target selection of the elevator without shifting any arrays.
+ *
+ * Which order the elevator drives to next is decided by a @c queue_policy_t .
 */
 #ifndef QUEUE_H
 #define QUEUE_H
 
+#include <stdint.h>
+
 #include "driver/hardware.h"
 #include "globals.h"
 
 
+#define QUEUE_ORDER_TYPES 3                         /**< Number of real order types: up, inside and down */
+#define QUEUE_SIZE (QUEUE_ORDER_TYPES * HARDWARE_NUMBER_OF_FLOORS)  /**< Number of distinct orders, which bounds the queue */
+#define QUEUE_WORD_BITS 64                          /**< Number of floors per bitset word */
+#define QUEUE_WORDS ((HARDWARE_NUMBER_OF_FLOORS + QUEUE_WORD_BITS - 1) / QUEUE_WORD_BITS) /**< Number of words per order type */
+
+
+/**
+ * Enum for the ways the elevator can pick the floor it drives to next
+ */
+typedef enum{
+    QUEUE_POLICY_FIFO,          /**< The oldest order, picking up orders on the way*/
+    QUEUE_POLICY_LOOK,          /**< Collective control: keep going while there are orders ahead, then turn*/
+    QUEUE_POLICY_NEAREST,       /**< The nearest order, picking up orders on the way*/
+    QUEUE_POLICY_COUNT          /**< Number of policies, not a policy*/
+} queue_policy_t;
+
+
 /**
  * @struct Order
- * 
+ *
  * @brief  A struct for holding information about an order
  */
 typedef struct{
@@ -20,110 +46,208 @@ typedef struct{
 } Order;
 
 
-Order QUEUE[QUEUE_SIZE];                /**< The elevator's queue */
-
-
 /**
- * @brief Check if the @c QUEUE is empty
- * 
- * @return 1 if the @c QUEUE is empty and 0 if not
- * 
- * @warning We assume that the first element in the queue is always updated! If not, the return value is invalid
+ * @brief The elevator's queue of pending orders
  */
-int queue_empty();
+typedef struct{
+    uint64_t pending[QUEUE_ORDER_TYPES][QUEUE_WORDS];   /**< One bit per floor for every order type, indexed by @c HardwareOrder */
+    uint64_t lit[QUEUE_ORDER_TYPES][QUEUE_WORDS];       /**< The pending bits as last shown on the button lights */
+    int16_t next[QUEUE_SIZE];                           /**< Next younger pending order, by slot, or -1 */
+    int16_t prev[QUEUE_SIZE];                           /**< Next older pending order, by slot, or -1 */
+    int16_t oldest;                                     /**< Slot of the oldest pending order, or -1 if the queue is empty */
+    int16_t youngest;                                   /**< Slot of the youngest pending order, or -1 if the queue is empty */
+} queue_t;
 
 
 /**
- * @brief Initialize the @c QUEUE with all invalid orders
+ * @brief Check if the queue is empty
+ *
+ * @param[in] p_queue   The queue to check
+ *
+ * @return 1 if the queue is empty and 0 if not
  */
-void queue_init();
+int queue_empty(const queue_t* p_queue);
 
 
 /**
- * @brief Sets a single order in the queue
- * 
- * @param[in] idx               The index of the element in the queue we wish to modify
- * @param[in] target_floor      The new target_floor for the queue element
- * @param[in] order_type        The new order type for the queue element
- * 
- * Set an @c Order in the @c QUEUE at index @p idx to the values of @p target_floor and @p order_type
- * regardless of what the @c QUEUE contains at the given @p idx .
+ * @brief Initialize the queue with no orders
+ *
+ * @param[out] p_queue  The queue to initialize
  */
-void queue_set_order(int idx, int target_floor, HardwareOrder order_type);
+void queue_init(queue_t* p_queue);
 
 
 /**
- * @brief Empty the @c QUEUE by removing all elements
- * 
- * @param[out] p_orders_cab     A pointer to the array containing the cab button states
- * @param[out] p_orders_up      A pointer to the array containing the up-button button states
- * @param[out] p_orders_down    A pointer to the array containing the down-buttons button states
- * 
- * @warning This function invalidates every element in the queue unconditionally.
+ * @brief Empty the queue by removing all orders
+ *
+ * @param[out] p_queue  The queue to empty
+ *
+ * @warning This function removes every order in the queue unconditionally.
  */
-void queue_erase(int* p_orders_up, int* p_orders_down, int* p_orders_cab);
+void queue_erase(queue_t* p_queue);
 
 
 /**
- * @brief Add orders to the @c QUEUE if an existing order with the same parameters is not in it
- * 
+ * @brief Add an order to the queue if an identical order is not in it already
+ *
+ * @param[in, out] p_queue  The queue to add the order to
  * @param[in] target_floor  The floor for the new @c Order
  * @param[in] order_type    The order_type for the new @c Order
- * 
- * The function uses @c check_queue_for_order() to add an @c Order
- * to the @c QUEUE with values given by @p target_floor and @p order_type if
- * and only if the queue does not contain an identical order already.
+ *
+ * A new order is placed behind every order already in the queue.
  */
-void queue_push_back(int target_floor, HardwareOrder order_type);
+void queue_push_back(queue_t* p_queue, int target_floor, HardwareOrder order_type);
+
 
 /**
- * @brief Clear all orders in the @c QUEUE for the @p current_floor
- * 
- * @param[out] p_orders_up      A pointer to the array containing the up-button button states
- * @param[out] p_orders_down    A pointer to the array containing the down-buttons button states
- * @param[out] p_orders_cab     A pointer to the array containing the cab button states
- * @param[in]  current_floor    The current floor the elevator is at
- * 
- * The function clears all @c Order elements in the queue whos target_floor is equal to @p current_floor .
- * And clears the values of the button arrays at index @p current_floor
+ * @brief Remove one order from the queue, if it is in it
+ *
+ * @param[in, out] p_queue  The queue to remove the order from
+ * @param[in] floor         The floor of the order
+ * @param[in] order_type    The type of the order
  */
-void queue_clear_order_at_floor(int* p_orders_up, int* p_orders_down, int* p_orders_cab, int current_floor);
+void queue_remove(queue_t* p_queue, int floor, HardwareOrder order_type);
 
 
 /**
- * @brief Delete all occurencec of "holes" in the @c QUEUE
- * 
- * The function will left-shift orders until the @c QUEUE contains no holes. A hole is defined as
- * an empty order that splits apart an otherwise connected part of the queue, starting from the leftmost
- * element at index 0
+ * @brief Clear the orders that an elevator with its door open at @p current_floor serves
+ *
+ * @param[in, out] p_queue  The queue to clear orders from
+ * @param[in] policy        The policy that picks the elevator's next target
+ * @param[in] current_floor The current floor the elevator is at
+ * @param[in] direction     The direction the elevator arrived in
+ *
+ * The cab order at @p current_floor is cleared, and of the up and down orders only the one for the
+ * direction the elevator leaves in, as found by @p policy from the orders at other floors. If
+ * there are none, the order for @p direction is preferred. Nothing happens if @p current_floor is
+ * not a valid floor.
  */
-void queue_refactor();
+void queue_clear_served_orders(queue_t* p_queue, queue_policy_t policy, int current_floor, HardwareMovement direction);
 
 
 /**
- * @brief Check if the QUEUE has a valid order to handle at a floor
+ * @brief Find the floor the elevator should drive to next
+ *
+ * @param[in] p_queue       The queue to look in
+ * @param[in] policy        How to pick the floor
+ * @param[in] current_floor The last floor the elevator was at
+ * @param[in] direction     The direction the elevator last moved in
+ *
+ * @return The target floor, or @c FLOOR_NOT_INIT if the queue is empty
+ *
+ * The target is @p current_floor if @c queue_clear_served_orders() would clear an order there.
+ * Otherwise @p policy picks one of the other floors with orders.
+ */
+int queue_next_target(const queue_t* p_queue, queue_policy_t policy, int current_floor, HardwareMovement direction);
+
+
+/**
+ * @brief Check if an elevator moving past a floor should stop there
+ *
+ * @param[in] p_queue       The queue to check
+ * @param[in] current_floor The floor used in the queue check
+ * @param[in] target_floor  The floor the elevator is driving to, from @c queue_next_target()
+ * @param[in] direction     The direction the elevator is moving in
+ *
+ * @return 1 if the elevator should stop at the floor, and 0 if not.
+ *
+ * The elevator stops at @p target_floor , which is the floor itself when it has an order to
+ * serve there. It also stops if there are no orders left beyond @p current_floor in @p direction .
+ */
+int queue_check_order_match(const queue_t* p_queue, int current_floor, int target_floor, HardwareMovement direction);
+
+
+/**
+ * @brief Check if a specific order is pending
+ *
+ * @param[in] p_queue   The queue to check
+ * @param[in] floor     The floor of the order
+ * @param[in] order_type The type of the order
  *
- * @param[in] target_floor  The floor used in the @c QUEUE check
- * @param[in] order_type    The type of order we check for
- * 
- * @return 1 if any @c Order in @c QUEUE has a valid order at the floor, and 0 if not.
- * 
- * The function determines if the @c QUEUE contains an order with matching @p target_floor and @p order_type . 
- * Note that a cab order only needs a matching @p target_floor to count as matching, while an up/down order will
- * require both parameters matching.
+ * @return 1 if the order is in the queue, and 0 if not
  */
-int queue_check_order_match(int target_floor, HardwareOrder order_type);
+int queue_has_order(const queue_t* p_queue, int floor, HardwareOrder order_type);
 
 
 /**
- * @brief Update the @c QUEUE by removing the first element.
- * 
- * @warning Will only work if the elevator is at a defined floor
- * 
- * The function will both refactor and shift the entire queue one element to the left,
- * thereby deleting the first element; effectively "handling" an order.
+ * @brief Find the pending order farthest away from a floor in one direction
+ *
+ * @param[in] p_queue   The queue to look in
+ * @param[in] floor     The floor to look from
+ * @param[in] direction @c HARDWARE_MOVEMENT_UP to look above @p floor , @c HARDWARE_MOVEMENT_DOWN to look below it
+ *
+ * @return The floor farthest from @p floor , in @p direction , with a pending order of any type,
+ * or @c FLOOR_NOT_INIT if there is none
+ */
+int queue_farthest_stop(const queue_t* p_queue, int floor, HardwareMovement direction);
+
+
+/**
+ * @brief Find the pending order nearest to a floor in one direction
+ *
+ * @param[in] p_queue   The queue to look in
+ * @param[in] floor     The floor to look from
+ * @param[in] direction @c HARDWARE_MOVEMENT_UP to look above @p floor , @c HARDWARE_MOVEMENT_DOWN to look below it
+ *
+ * @return The floor nearest to @p floor , in @p direction , with a pending order of any type,
+ * or @c FLOOR_NOT_INIT if there is none
+ */
+int queue_nearest_stop(const queue_t* p_queue, int floor, HardwareMovement direction);
+
+
+/**
+ * @brief Find the nearest floor an elevator moving on from a floor stops at on its way, before its target
+ *
+ * @param[in] p_queue   The queue to look in
+ * @param[in] floor     The floor to look from
+ * @param[in] direction The direction the elevator moves in
+ *
+ * @return The floor nearest to @p floor , in @p direction , with an order from inside or a hall call in
+ * @p direction , or @c FLOOR_NOT_INIT if there is none
+ */
+int queue_nearest_passing_stop(const queue_t* p_queue, int floor, HardwareMovement direction);
+
+
+/**
+ * @brief Name of a policy
+ *
+ * @param[in] policy    The policy
+ *
+ * @return A short lowercase name
+ */
+const char* queue_policy_name(queue_policy_t policy);
+
+
+/**
+ * @brief Look up a policy by its name
+ *
+ * @param[in] name          The name, as returned by @c queue_policy_name()
+ * @param[out] p_policy     The policy, left alone if there is none by that name
+ *
+ * @return 0 if @p name is a policy, and -1 otherwise
+ */
+int queue_policy_from_name(const char* name, queue_policy_t* p_policy);
+
+
+/**
+ * @brief Get the first order in the queue
+ *
+ * @param[in] p_queue   The queue to look in
+ *
+ * @return The oldest pending order, or an order with target floor @c FLOOR_NOT_INIT if the queue is empty
+ */
+Order queue_front(const queue_t* p_queue);
+
+
+/**
+ * @brief Get every pending order, in the order they were accepted
+ *
+ * @param[in] p_queue   The queue to look in
+ * @param[out] p_orders Array of at least @c QUEUE_SIZE orders, filled from the oldest pending order on
+ *
+ * @return Number of pending orders
  */
-void queue_update();
+int queue_get_orders(const queue_t* p_queue, Order* p_orders);
 
 
-#endif //QUEUE_H
\ No newline at end of file
+#endif //QUEUE_H
@@ -0,0 +1,169 @@
+/**
+ * @file
+ * @brief Replays a recording of hardware I/O into the controller, as fast as the CPU allows.
+ *
+ * The controller is the same as in elevator and elevator_sim; only its driver is linked against
+ * io_replay.c , which answers its reads from the recording. The control loop of
+ * @c scheduler_run() is reproduced on the recording's virtual clock: a tick at every control
+ * period, at every timer deadline in between, and at every time an input was recorded, which is
+ * when the recorded controller sampled it. The same recording therefore always gives the same run.
+ * A replay does not park idle cars, so the replay of a controller run with a demand model (-D)
+ * departs from the recording at the first time a car parked. Nor does it restart from a snapshot,
+ * so the replay of a warm restart (-S) starts without the orders the recorded controller took back.
+ *
+ * Usage: elevator_replay [-m cruise_speed] [-p fifo|look|nearest] [-d fixed|adaptive] [-j journal_file] [-R recording_of_replay] recording
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "driver/io_record.h"
+#include "driver/replay.h"
+#include "elevator_fsm.h"
+#include "globals.h"
+#include "group.h"
+#include "journal.h"
+#include "latency.h"
+#include "timer.h"
+
+
+static long long replay_wall_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+
+int main(int argc, char** argv) {
+    queue_policy_t policy = QUEUE_POLICY_LOOK;
+    door_policy_t door_policy = DOOR_POLICY_ADAPTIVE;
+    int cruise_speed = MOTOR_CRUISE_SPEED;
+    const char* journal_path = NULL;
+    const char* record_path = NULL;
+    int opt;
+    while((opt = getopt(argc, argv, "m:p:d:j:R:")) != -1) {
+        if(opt == 'm' && atoi(optarg) > 0 && atoi(optarg) <= MOTOR_SPEED_MAX) {
+            cruise_speed = atoi(optarg);
+        }
+        else if(opt == 'd' && door_policy_from_name(optarg, &door_policy) == 0) {
+            continue;
+        }
+        else if(opt == 'j') {
+            journal_path = optarg;
+        }
+        else if(opt == 'R') {
+            record_path = optarg;
+        }
+        else if(opt != 'p' || queue_policy_from_name(optarg, &policy) != 0) {
+            optind = argc;
+            break;
+        }
+    }
+    if(optind != argc - 1) {
+        fprintf(stderr, "Usage: %s [-m cruise_speed] [-p fifo|look|nearest] [-d fixed|adaptive] [-j journal_file] [-R recording_of_replay] recording\n", argv[0]);
+        exit(1);
+    }
+
+    if(replay_open(argv[optind]) != 0) {
+        fprintf(stderr, "%s is not a recording\n", argv[optind]);
+        exit(1);
+    }
+    int rate_hz = replay_rate_hz();
+    int car_count = replay_cars();
+    if(rate_hz <= 0 || car_count < 1 || car_count > GROUP_MAX_CARS) {
+        fprintf(stderr, "%s records %d cars at %d Hz, which cannot be replayed\n", argv[optind], car_count, rate_hz);
+        exit(1);
+    }
+
+    timer_set_clock(replay_now_ns);
+    io_record_set_clock(replay_now_ns);
+    if(record_path != NULL && io_record_open(record_path, rate_hz, car_count) != 0) {
+        fprintf(stderr, "Unable to create recording %s\n", record_path);
+        exit(1);
+    }
+    if(journal_path != NULL && journal_open(journal_path) != 0) {
+        fprintf(stderr, "Unable to open journal %s\n", journal_path);
+        exit(1);
+    }
+
+    static group_t group;
+    elevator_data_t elevator_data;
+    if(car_count > 1) {
+        if(group_init(&group, car_count, GROUP_POLICY_ETA) != 0) {
+            fprintf(stderr, "Unable to initialize hardware for %d cars\n", car_count);
+            exit(1);
+        }
+        for(int car = 0; car < car_count; car++) {
+            group.cars[car].policy = policy;
+            group.cars[car].motion.profile.cruise_speed = cruise_speed;
+            group.cars[car].door.policy = door_policy;
+        }
+    }
+    else {
+        if(hardware_init() != 0) {
+            fprintf(stderr, "Unable to initialize hardware\n");
+            exit(1);
+        }
+        elevator_data = elevator_init();
+        elevator_data.policy = policy;
+        elevator_data.motion.profile.cruise_speed = cruise_speed;
+        elevator_data.door.policy = door_policy;
+    }
+
+    long long period_ns = 1000000000LL / rate_hz;
+    long long end_ns = replay_end_ns();
+    long long ticks = 0;
+    long long wall_start_ns = replay_wall_ns();
+
+    while(replay_now_ns() <= end_ns) {
+        long long until_deadline;
+        if(car_count > 1) {
+            group_tick(&group);
+            until_deadline = group_until_next_deadline(&group);
+        }
+        else {
+            elevator_tick(&elevator_data);
+            until_deadline = timer_until_next_deadline(&elevator_data.timers);
+        }
+        ticks++;
+
+        long long now = replay_now_ns();
+        long long next = (now / period_ns + 1) * period_ns;
+        if(until_deadline > 0 && now + until_deadline < next) {
+            next = now + until_deadline;
+        }
+        long long next_input = replay_next_input_ns();
+        if(next_input > now && next_input < next) {
+            next = next_input;
+        }
+        replay_advance_to(next);
+    }
+
+    if(car_count > 1) {
+        group_stop(&group);
+    }
+    else {
+        hardware_command_movement(HARDWARE_MOVEMENT_STOP);
+        hardware_flush_outputs();
+    }
+    long long wall_ns = replay_wall_ns() - wall_start_ns;
+
+    printf("Replayed %lld records, %.1f s of %d car(s) at %d Hz, in %lld ticks and %.3f s (%.0fx real time)\n",
+           replay_records(), end_ns * 1e-9, car_count, rate_hz, ticks, wall_ns * 1e-9,
+           (wall_ns > 0) ? (double)end_ns / wall_ns : 0.0);
+    for(int car = 0; car < car_count; car++) {
+        elevator_print_homing((car_count > 1) ? &group.cars[car] : &elevator_data, stdout);
+    }
+    if(car_count > 1) {
+        group_print_stats(&group, stdout);
+    }
+    LATENCY_PRINT(stdout);
+
+    journal_close();
+    io_record_close();
+    replay_close();
+    return 0;
+}
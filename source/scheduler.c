@@ -0,0 +1,173 @@
+#define _GNU_SOURCE
+
+#include <math.h>
+#include <signal.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/signalfd.h>
+#include <sys/timerfd.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "latency.h"
+#include "scheduler.h"
+
+
+static long long scheduler_clock_ns(clockid_t clock) {
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+
+static void scheduler_record_jitter(scheduler_stats_t* p_stats, long long jitter_ns) {
+    if(p_stats->ticks == 0 || jitter_ns < p_stats->jitter_min_ns) {
+        p_stats->jitter_min_ns = jitter_ns;
+    }
+    if(p_stats->ticks == 0 || jitter_ns > p_stats->jitter_max_ns) {
+        p_stats->jitter_max_ns = jitter_ns;
+    }
+    p_stats->jitter_sum_ns += jitter_ns;
+    p_stats->jitter_sum_sq_ns += (double)jitter_ns * jitter_ns;
+}
+
+
+static struct timespec scheduler_timespec(long long ns) {
+    struct timespec ts = { .tv_sec = ns / 1000000000LL, .tv_nsec = ns % 1000000000LL };
+    return ts;
+}
+
+
+static void scheduler_arm_deadline(int deadline_fd, long long (*until_deadline)(void*), void* arg, long long next_tick_ns) {
+    struct itimerspec wake = { 0 };
+
+    long long until = (until_deadline != NULL) ? until_deadline(arg) : -1;
+    if(until >= 0) {
+        long long deadline_ns = scheduler_clock_ns(CLOCK_MONOTONIC) + until;
+        if(deadline_ns < next_tick_ns) {
+            // A deadline that is already due is in the past, so the timer expires at once
+            wake.it_value = scheduler_timespec(deadline_ns);
+        }
+    }
+    timerfd_settime(deadline_fd, TFD_TIMER_ABSTIME, &wake, NULL);
+}
+
+
+int scheduler_run(int rate_hz, void (*tick)(void*), long long (*until_deadline)(void*), void* arg, scheduler_stats_t* p_stats,
+                  sigset_t* p_previous_mask) {
+    memset(p_stats, 0, sizeof(*p_stats));
+    p_stats->period_ns = 1000000000LL / rate_hz;
+
+    // Signals are taken through the signalfd instead of a handler, so shutdown happens between ticks
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    sigaddset(&signals, SIGUSR1);
+    sigprocmask(SIG_BLOCK, &signals, p_previous_mask);
+
+    int signal_fd = signalfd(-1, &signals, SFD_CLOEXEC | SFD_NONBLOCK);
+    int timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+    int deadline_fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+    int epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if(signal_fd < 0 || timer_fd < 0 || deadline_fd < 0 || epoll_fd < 0) {
+        // Leave the process as it was, so the caller can still be stopped by the signals
+        int fds[] = { signal_fd, timer_fd, deadline_fd, epoll_fd };
+        for(size_t i = 0; i < sizeof(fds) / sizeof(fds[0]); i++) {
+            if(fds[i] >= 0) {
+                close(fds[i]);
+            }
+        }
+        sigprocmask(SIG_SETMASK, p_previous_mask, NULL);
+        return -1;
+    }
+
+    struct epoll_event event = { .events = EPOLLIN, .data.fd = timer_fd };
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, timer_fd, &event);
+    event.data.fd = deadline_fd;
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, deadline_fd, &event);
+    event.data.fd = signal_fd;
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, signal_fd, &event);
+
+    long long start_ns = scheduler_clock_ns(CLOCK_MONOTONIC);
+    long long start_cpu_ns = scheduler_clock_ns(CLOCK_PROCESS_CPUTIME_ID);
+    long long deadline_ns = start_ns + p_stats->period_ns;
+
+    struct itimerspec period = {
+        .it_interval = scheduler_timespec(p_stats->period_ns),
+        .it_value    = scheduler_timespec(deadline_ns)
+    };
+    timerfd_settime(timer_fd, TFD_TIMER_ABSTIME, &period, NULL);
+
+    int running = 1;
+    while(running) {
+        struct epoll_event ready[3];
+        int n = epoll_wait(epoll_fd, ready, 3, -1);
+
+        for(int i = 0; i < n; i++) {
+            int fd = ready[i].data.fd;
+            if(fd == signal_fd) {
+                // Every pending signal is taken, so none is left to act once the loop has ended
+                struct signalfd_siginfo info;
+                while(read(signal_fd, &info, sizeof(info)) == sizeof(info)) {
+                    if(info.ssi_signo == SIGUSR1) {
+                        LATENCY_PRINT(stderr);
+                    }
+                    else {
+                        running = 0;
+                    }
+                }
+                continue;
+            }
+
+            uint64_t expirations = 0;
+            if(read(fd, &expirations, sizeof(expirations)) != sizeof(expirations)) {
+                continue;
+            }
+
+            if(fd == timer_fd) {
+                // The wake-up belongs to the most recent expiration; earlier ones were missed
+                deadline_ns += (long long)(expirations - 1) * p_stats->period_ns;
+                scheduler_record_jitter(p_stats, scheduler_clock_ns(CLOCK_MONOTONIC) - deadline_ns);
+                p_stats->missed += expirations - 1;
+                deadline_ns += p_stats->period_ns;
+                p_stats->ticks++;
+            }
+            else {
+                p_stats->deadline_ticks++;
+            }
+
+            tick(arg);
+            scheduler_arm_deadline(deadline_fd, until_deadline, arg, deadline_ns);
+        }
+    }
+
+    p_stats->wall_ns = scheduler_clock_ns(CLOCK_MONOTONIC) - start_ns;
+    p_stats->cpu_ns = scheduler_clock_ns(CLOCK_PROCESS_CPUTIME_ID) - start_cpu_ns;
+
+    close(epoll_fd);
+    close(deadline_fd);
+    close(timer_fd);
+    close(signal_fd);
+
+    return 0;
+}
+
+
+void scheduler_print_stats(const scheduler_stats_t* p_stats, FILE* stream) {
+    double mean = 0.0;
+    double stddev = 0.0;
+    if(p_stats->ticks > 0) {
+        mean = p_stats->jitter_sum_ns / p_stats->ticks;
+        stddev = sqrt(fmax(0.0, p_stats->jitter_sum_sq_ns / p_stats->ticks - mean * mean));
+    }
+
+    fprintf(stream, "Control loop: %lld ticks at %.1f Hz, %lld missed, %lld extra ticks on timer deadlines\n",
+            p_stats->ticks, 1e9 / p_stats->period_ns, p_stats->missed, p_stats->deadline_ticks);
+    fprintf(stream, "Tick jitter [us]: mean %.1f, stddev %.1f, min %.1f, max %.1f\n",
+            mean / 1e3, stddev / 1e3, p_stats->jitter_min_ns / 1e3, p_stats->jitter_max_ns / 1e3);
+    if(p_stats->wall_ns > 0) {
+        fprintf(stream, "CPU usage: %.2f %%\n", 100.0 * p_stats->cpu_ns / p_stats->wall_ns);
+    }
+}
@@ -0,0 +1,69 @@
+/**
+ * @file
+ * @brief Fixed-rate event loop for the elevator's control cycle.
+ */
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <signal.h>
+#include <stdio.h>
+
+
+/**
+ * A struct holding the measured timing of the control loop
+ */
+typedef struct{
+    long long period_ns;            /**< The requested tick period, in nanoseconds*/
+    long long ticks;                /**< Number of periodic ticks that have been run*/
+    long long deadline_ticks;       /**< Number of extra ticks run because a timer expired between periodic ticks*/
+    long long missed;               /**< Number of timer expirations that were skipped because a tick ran late*/
+    long long jitter_min_ns;        /**< Smallest observed wake-up lateness*/
+    long long jitter_max_ns;        /**< Largest observed wake-up lateness*/
+    double jitter_sum_ns;           /**< Sum of wake-up lateness, for the mean*/
+    double jitter_sum_sq_ns;        /**< Sum of squared wake-up lateness, for the standard deviation*/
+    long long wall_ns;              /**< Wall-clock time spent in the loop*/
+    long long cpu_ns;               /**< Process CPU time spent in the loop*/
+} scheduler_stats_t;
+
+
+/**
+ * @brief Run @p tick at a fixed rate until the process receives SIGINT or SIGTERM
+ *
+ * @param[in] rate_hz       Number of ticks per second
+ * @param[in] tick          Function called once per tick
+ * @param[in] until_deadline Function returning the nanoseconds until the next timer deadline of the
+ *                          controller, or -1 if none. May be NULL.
+ * @param[in, out] arg      Passed unchanged to @p tick and @p until_deadline
+ * @param[out] p_stats      Timing statistics for the run
+ * @param[out] p_previous_mask The signal mask from before the call
+ *
+ * @return 0 on a clean shutdown, and -1 if the timer or signal descriptors could not be set up
+ *
+ * The loop sleeps in @c epoll_wait() on a @c timerfd armed at @p rate_hz and a @c signalfd
+ * for SIGINT and SIGTERM, so no CPU is used between ticks. SIGUSR1 prints the latency
+ * histograms of latency.h to stderr, between ticks, and the loop carries on. Each wake-up is compared against
+ * its deadline to measure the jitter of the loop. If a tick overruns its period, the missed
+ * expirations are counted and the loop carries on from the next deadline.
+ *
+ * After every tick the loop asks @p until_deadline how long it may sleep. If a timer of the
+ * controller expires before the next periodic tick, a one-shot @c timerfd wakes the loop at
+ * exactly that deadline and runs an extra tick, so timer resolution is not bound to the control rate.
+ *
+ * On a clean shutdown SIGINT, SIGTERM and SIGUSR1 are left blocked, so a second signal cannot
+ * kill the process before the caller has stopped the motor. The caller restores
+ * @p p_previous_mask once it has. If the loop cannot be set up, the mask is restored before returning.
+ */
+int scheduler_run(int rate_hz, void (*tick)(void*), long long (*until_deadline)(void*), void* arg, scheduler_stats_t* p_stats,
+                  sigset_t* p_previous_mask);
+
+
+/**
+ * @brief Print a summary of @p p_stats to @p stream
+ *
+ * @param[in] p_stats   Statistics filled in by @c scheduler_run()
+ * @param[in] stream    Where to print the summary
+ */
+void scheduler_print_stats(const scheduler_stats_t* p_stats, FILE* stream);
+
+
+#endif //SCHEDULER_H
@@ -0,0 +1,401 @@
+/**
+ * @file
+ * @brief Simulator process that serves the plant of one building to several controllers.
+ *
+ * Controllers built with io_socket.c ( @c make socket ) connect over a Unix domain socket and
+ * exchange the batched messages of driver/sim_protocol.h. Every car of a controller is given a
+ * shaft of the building when the controller first uses it, the lowest free one, and keeps it
+ * until the controller disconnects, when its motor is stopped and the shaft is freed for the
+ * next controller, at the position the car was left at. A controller that is restarted thus
+ * finds its cars where they were. The plant is the one of io_sim.c , on the wall clock.
+ *
+ * Commands are read from stdin, one per line:
+ * - @c u, @c d or @c c followed by a floor and optionally a shaft: press the up, down or cab
+ *   button of the floor in the shaft, 0 if none is given. The hall buttons of a controller's
+ *   cars are read from its first car, so press them in the shaft of that car.
+ * - @c s or @c o, optionally followed by a shaft: toggle the stop switch or the obstruction.
+ * - @c p: print every shaft in use.
+ *
+ * On SIGINT or SIGTERM, and for every controller that disconnects, the messages served and the
+ * time taken to serve them are printed.
+ *
+ * Usage: elevator_simd [-s socket], with the socket by default the one of ELEVATOR_SIM_SOCKET,
+ * or @c SIM_SOCKET_PATH
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "driver/channels.h"
+#include "driver/io.h"
+#include "driver/sim.h"
+#include "driver/sim_protocol.h"
+
+
+#define SIM_SERVER_MAX_CONTROLLERS 16   /**< Controllers connected at once */
+
+
+/**
+ * A connected controller
+ */
+typedef struct{
+    int fd;                                 /**< The connection, or -1 for a free slot*/
+    int number;                             /**< Number of the controller, counted from 1 in the order they connected*/
+    int hello;                              /**< 1 once the controller has said hello*/
+    int shafts[HARDWARE_MAX_CARS];          /**< Shaft of every car of the controller, or -1 if it has not used the car*/
+    long long exchanges;                    /**< Exchanges answered*/
+    long long write_batches;                /**< Messages of writes only*/
+    long long writes;                       /**< Writes in all messages*/
+    long long serve_sum_ns;                 /**< Time spent serving the messages*/
+    long long serve_max_ns;                 /**< Longest time spent serving a message*/
+} controller_t;
+
+
+static controller_t controllers[SIM_SERVER_MAX_CONTROLLERS];
+static int shaft_owner[HARDWARE_MAX_CARS];     /**< Slot of the controller that has every shaft, or -1 */
+static int shaft_started[HARDWARE_MAX_CARS];   /**< 1 for a shaft the plant has a car in */
+static volatile sig_atomic_t stopping = 0;
+
+
+static long long sim_server_now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+
+static void sim_server_on_signal(int signal_number) {
+    stopping = 1;
+}
+
+
+/**
+ * @brief Shaft of a car of a controller, given the lowest free shaft on first use
+ *
+ * @return The shaft, or -1 if the car does not exist or every shaft is taken
+ */
+static int sim_server_shaft(controller_t* p_controller, int car) {
+    if(car < 0 || car >= HARDWARE_MAX_CARS) {
+        return -1;
+    }
+    if(p_controller->shafts[car] >= 0) {
+        return p_controller->shafts[car];
+    }
+
+    for(int shaft = 0; shaft < HARDWARE_MAX_CARS; shaft++) {
+        if(shaft_owner[shaft] < 0) {
+            shaft_owner[shaft] = p_controller - controllers;
+            p_controller->shafts[car] = shaft;
+            io_select_car(shaft);
+            if(!shaft_started[shaft]) {
+                io_init();
+                shaft_started[shaft] = 1;
+            }
+            printf("Controller %d car %d is in shaft %d\n", p_controller->number, car, shaft);
+            return shaft;
+        }
+    }
+    return -1;
+}
+
+
+static void sim_server_print_controller(const controller_t* p_controller, FILE* stream) {
+    long long messages = p_controller->exchanges + p_controller->write_batches;
+    fprintf(stream, "Controller %d: %lld exchanges, %lld write batches, %lld writes, served in mean %.1f us max %.1f us\n",
+            p_controller->number, p_controller->exchanges, p_controller->write_batches, p_controller->writes,
+            messages > 0 ? p_controller->serve_sum_ns * 1e-3 / messages : 0.0, p_controller->serve_max_ns * 1e-3);
+}
+
+
+/**
+ * @brief Stop the cars of a controller, free its shafts and close its connection
+ */
+static void sim_server_disconnect(controller_t* p_controller) {
+    for(int car = 0; car < HARDWARE_MAX_CARS; car++) {
+        int shaft = p_controller->shafts[car];
+        if(shaft >= 0) {
+            io_select_car(shaft);
+            io_write_analog(MOTOR, 0);
+            shaft_owner[shaft] = -1;
+        }
+    }
+    sim_server_print_controller(p_controller, stdout);
+    fflush(stdout);
+    close(p_controller->fd);
+    p_controller->fd = -1;
+}
+
+
+static int sim_server_apply(controller_t* p_controller, const SimWrite* p_write) {
+    int shaft = sim_server_shaft(p_controller, p_write->car);
+    if(shaft < 0) {
+        return -1;
+    }
+    io_select_car(shaft);
+
+    switch(p_write->kind) {
+        case SIM_WRITE_DIGITAL:
+            if(p_write->index >= SIM_WORDS_PER_CAR) {
+                return -1;
+            }
+            io_write_bitfield(p_write->index / SIM_WORDS_PER_SUBDEVICE, p_write->mask, p_write->value,
+                              (p_write->index % SIM_WORDS_PER_SUBDEVICE) * 32);
+            return 0;
+        case SIM_WRITE_ANALOG:
+            io_write_analog(p_write->index, p_write->value);
+            return 0;
+    }
+    return -1;
+}
+
+
+/**
+ * @brief Serve one message of a controller
+ *
+ * @return 0 on success, and -1 if the controller is to be disconnected
+ */
+static int sim_server_serve(controller_t* p_controller) {
+    static SimRequest request;
+    static SimInputs inputs;
+
+    ssize_t received = recv(p_controller->fd, &request, sizeof(request), 0);
+    if(received < (ssize_t)sizeof(SimHeader) || request.header.writes > SIM_MAX_WRITES
+       || received != (ssize_t)(sizeof(SimHeader) + request.header.writes * sizeof(SimWrite))) {
+        return -1;
+    }
+    long long start = sim_server_now_ns();
+
+    if(request.header.type == SIM_MESSAGE_HELLO) {
+        if(request.header.version != SIM_PROTOCOL_VERSION || request.header.floors != HARDWARE_NUMBER_OF_FLOORS) {
+            fprintf(stderr, "Controller %d is of another building or version\n", p_controller->number);
+            return -1;
+        }
+        p_controller->hello = 1;
+        SimHeader answer = request.header;
+        return (send(p_controller->fd, &answer, sizeof(answer), MSG_NOSIGNAL) == sizeof(answer)) ? 0 : -1;
+    }
+    if(!p_controller->hello) {
+        return -1;
+    }
+
+    for(unsigned int i = 0; i < request.header.writes; i++) {
+        if(sim_server_apply(p_controller, &request.writes[i]) != 0) {
+            return -1;
+        }
+    }
+    p_controller->writes += request.header.writes;
+
+    switch(request.header.type) {
+        case SIM_MESSAGE_WRITE:
+            p_controller->write_batches++;
+            break;
+
+        case SIM_MESSAGE_EXCHANGE:
+            if(request.header.cars > HARDWARE_MAX_CARS) {
+                return -1;
+            }
+            for(unsigned int car = 0; car < request.header.cars; car++) {
+                int shaft = sim_server_shaft(p_controller, car);
+                if(shaft < 0) {
+                    return -1;
+                }
+                io_select_car(shaft);
+                for(int word = 0; word < SIM_WORDS_PER_CAR; word++) {
+                    inputs.words[car][word] = io_read_bitfield(word / SIM_WORDS_PER_SUBDEVICE, (word % SIM_WORDS_PER_SUBDEVICE) * 32);
+                }
+            }
+            inputs.header = request.header;
+            inputs.header.writes = 0;
+            size_t bytes = sizeof(SimHeader) + request.header.cars * sizeof(inputs.words[0]);
+            if(send(p_controller->fd, &inputs, bytes, MSG_NOSIGNAL) != (ssize_t)bytes) {
+                return -1;
+            }
+            p_controller->exchanges++;
+            break;
+
+        default:
+            return -1;
+    }
+
+    long long served = sim_server_now_ns() - start;
+    p_controller->serve_sum_ns += served;
+    if(served > p_controller->serve_max_ns) {
+        p_controller->serve_max_ns = served;
+    }
+    return 0;
+}
+
+
+static void sim_server_accept(int listener, int number) {
+    int fd = accept(listener, NULL, NULL);
+    if(fd < 0) {
+        return;
+    }
+    for(int slot = 0; slot < SIM_SERVER_MAX_CONTROLLERS; slot++) {
+        if(controllers[slot].fd < 0) {
+            controllers[slot] = (controller_t){ .fd = fd, .number = number };
+            memset(controllers[slot].shafts, -1, sizeof(controllers[slot].shafts));
+            printf("Controller %d connected\n", number);
+            fflush(stdout);
+            return;
+        }
+    }
+    fprintf(stderr, "Turned a controller away: %d are connected\n", SIM_SERVER_MAX_CONTROLLERS);
+    close(fd);
+}
+
+
+/**
+ * @brief Run the console commands in what was read from stdin
+ */
+static void sim_server_console(char* text) {
+    for(char* line = strtok(text, "\n"); line != NULL; line = strtok(NULL, "\n")) {
+        int first = 0;
+        int second = 0;
+        int given = sscanf(line + 1, "%d %d", &first, &second);
+        int shaft = (line[0] == 's' || line[0] == 'o') ? ((given >= 1) ? first : 0) : ((given >= 2) ? second : 0);
+        if(line[0] != 'p' && (shaft < 0 || shaft >= HARDWARE_MAX_CARS || !shaft_started[shaft])) {
+            printf("No car in shaft %d\n", shaft);
+            continue;
+        }
+        io_select_car(shaft);
+
+        switch(line[0]) {
+            case 'u':
+                sim_press_order(first, HARDWARE_ORDER_UP);
+                break;
+            case 'd':
+                sim_press_order(first, HARDWARE_ORDER_DOWN);
+                break;
+            case 'c':
+                sim_press_order(first, HARDWARE_ORDER_INSIDE);
+                break;
+            case 's':
+                sim_set_stop(!io_read_bit(STOP));
+                break;
+            case 'o':
+                sim_set_obstruction(!io_read_bit(OBSTRUCTION));
+                break;
+            case 'p':
+                for(int s = 0; s < HARDWARE_MAX_CARS; s++) {
+                    if(shaft_started[s]) {
+                        io_select_car(s);
+                        printf("t=%.3f shaft=%d controller=%d pos=%.3f vel=%.3f motor=%d door=%d\n", sim_now_ns() * 1e-9, s,
+                               shaft_owner[s] >= 0 ? controllers[shaft_owner[s]].number : 0,
+                               sim_get_position(), sim_get_velocity(), io_read_analog(MOTOR), sim_get_door_open());
+                    }
+                }
+                break;
+        }
+    }
+    fflush(stdout);
+}
+
+
+int main(int argc, char** argv) {
+    const char* path = getenv("ELEVATOR_SIM_SOCKET");
+    if(path == NULL) {
+        path = SIM_SOCKET_PATH;
+    }
+    int opt;
+    while((opt = getopt(argc, argv, "s:")) != -1) {
+        if(opt == 's') {
+            path = optarg;
+        }
+        else {
+            fprintf(stderr, "Usage: %s [-s socket]\n", argv[0]);
+            exit(1);
+        }
+    }
+
+    struct sockaddr_un address = { .sun_family = AF_UNIX };
+    if(strlen(path) >= sizeof(address.sun_path)) {
+        fprintf(stderr, "Socket path %s is too long\n", path);
+        exit(1);
+    }
+    strcpy(address.sun_path, path);
+    int listener = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    unlink(path);
+    if(listener < 0 || bind(listener, (struct sockaddr*)&address, sizeof(address)) != 0 || listen(listener, SIM_SERVER_MAX_CONTROLLERS) != 0) {
+        fprintf(stderr, "Unable to listen on %s\n", path);
+        exit(1);
+    }
+
+    // Without SA_RESTART, so a signal ends the poll below
+    struct sigaction action = { .sa_handler = sim_server_on_signal };
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+
+    sim_close_console();
+    for(int slot = 0; slot < SIM_SERVER_MAX_CONTROLLERS; slot++) {
+        controllers[slot].fd = -1;
+    }
+    for(int shaft = 0; shaft < HARDWARE_MAX_CARS; shaft++) {
+        shaft_owner[shaft] = -1;
+    }
+    printf("Simulating %s, %d floors, on %s\n", BUILDING_NAME, HARDWARE_NUMBER_OF_FLOORS, path);
+    fflush(stdout);
+
+    int connected = 0;
+    int console_open = 1;
+    while(!stopping) {
+        struct pollfd fds[SIM_SERVER_MAX_CONTROLLERS + 2];
+        int slots[SIM_SERVER_MAX_CONTROLLERS];
+        int count = 0;
+        fds[count++] = (struct pollfd){ .fd = listener, .events = POLLIN };
+        fds[count++] = (struct pollfd){ .fd = console_open ? STDIN_FILENO : -1, .events = POLLIN };
+        for(int slot = 0; slot < SIM_SERVER_MAX_CONTROLLERS; slot++) {
+            if(controllers[slot].fd >= 0) {
+                slots[count - 2] = slot;
+                fds[count++] = (struct pollfd){ .fd = controllers[slot].fd, .events = POLLIN };
+            }
+        }
+
+        if(poll(fds, count, -1) < 0) {
+            if(errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+
+        for(int i = 2; i < count; i++) {
+            controller_t* p_controller = &controllers[slots[i - 2]];
+            if(fds[i].revents != 0 && sim_server_serve(p_controller) != 0) {
+                sim_server_disconnect(p_controller);
+            }
+        }
+        if(fds[1].revents != 0) {
+            char text[256];
+            ssize_t n = read(STDIN_FILENO, text, sizeof(text) - 1);
+            if(n <= 0) {
+                console_open = 0;
+            }
+            else {
+                text[n] = '\0';
+                sim_server_console(text);
+            }
+        }
+        if(fds[0].revents & POLLIN) {
+            sim_server_accept(listener, ++connected);
+        }
+    }
+
+    printf("Terminating simulator\n");
+    for(int slot = 0; slot < SIM_SERVER_MAX_CONTROLLERS; slot++) {
+        if(controllers[slot].fd >= 0) {
+            sim_server_disconnect(&controllers[slot]);
+        }
+    }
+    close(listener);
+    unlink(path);
+    return 0;
+}
@@ -0,0 +1,132 @@
+#define _DEFAULT_SOURCE
+
+#include <fcntl.h>
+#include <stdatomic.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "snapshot.h"
+#include "timer.h"
+
+
+// The checksum runs over whole words
+_Static_assert(sizeof(snapshot_state_t) % sizeof(uint64_t) == 0, "snapshot_state_t must be a whole number of words");
+
+
+static int snapshot_valid(const snapshot_file_t* p_file) {
+    return p_file->magic == SNAPSHOT_MAGIC && p_file->version == SNAPSHOT_VERSION
+        && p_file->floors == HARDWARE_NUMBER_OF_FLOORS && p_file->record_size == (int32_t)sizeof(snapshot_record_t);
+}
+
+
+/**
+ * @brief FNV-1a over the words of @p p_state , started from @p seq
+ */
+static uint64_t snapshot_checksum(uint64_t seq, const snapshot_state_t* p_state) {
+    uint64_t hash = 0xcbf29ce484222325ULL ^ seq;
+    const uint64_t* p_word = (const uint64_t*)p_state;
+    for(size_t i = 0; i < sizeof(snapshot_state_t) / sizeof(uint64_t); i++) {
+        hash = (hash ^ p_word[i]) * 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+
+static int snapshot_record_valid(const snapshot_record_t* p_record) {
+    return p_record->seq != 0 && p_record->checksum == snapshot_checksum(p_record->seq, &p_record->state);
+}
+
+
+int snapshot_open(snapshot_t* p_snapshot, const char* path, long long wall_offset_ns) {
+    int fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if(fd < 0) {
+        return -1;
+    }
+    if(ftruncate(fd, sizeof(snapshot_file_t)) != 0) {
+        close(fd);
+        return -1;
+    }
+    // The mapping keeps the file open
+    snapshot_file_t* p_file = mmap(NULL, sizeof(snapshot_file_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if(p_file == MAP_FAILED) {
+        return -1;
+    }
+
+    if(!snapshot_valid(p_file)) {
+        memset(p_file, 0, sizeof(snapshot_file_t));
+        p_file->version = SNAPSHOT_VERSION;
+        p_file->floors = HARDWARE_NUMBER_OF_FLOORS;
+        p_file->record_size = sizeof(snapshot_record_t);
+        // Marked valid last, so a crash while it is set up leaves a file that is set up again
+        p_file->magic = SNAPSHOT_MAGIC;
+    }
+
+    p_snapshot->p_file = p_file;
+    p_snapshot->wall_offset_ns = wall_offset_ns;
+    p_snapshot->saves = 0;
+    for(int car = 0; car < HARDWARE_MAX_CARS; car++) {
+        // The current record is the valid one of the latest save
+        const snapshot_record_t* p_current = NULL;
+        for(int r = 0; r < 2; r++) {
+            const snapshot_record_t* p_record = &p_file->records[car][r];
+            if(snapshot_record_valid(p_record) && (p_current == NULL || p_record->seq > p_current->seq)) {
+                p_current = p_record;
+            }
+        }
+
+        p_snapshot->restored[car] = (p_current != NULL);
+        p_snapshot->seq[car] = (p_current != NULL) ? p_current->seq : 0;
+        if(p_current != NULL) {
+            p_snapshot->saved[car] = p_current->state;
+        }
+        else {
+            memset(&p_snapshot->saved[car], 0, sizeof(snapshot_state_t));
+        }
+    }
+    return 0;
+}
+
+
+void snapshot_close(snapshot_t* p_snapshot) {
+    if(p_snapshot->p_file != NULL) {
+        munmap(p_snapshot->p_file, sizeof(snapshot_file_t));
+        p_snapshot->p_file = NULL;
+    }
+}
+
+
+const snapshot_state_t* snapshot_restored(const snapshot_t* p_snapshot, int car) {
+    return p_snapshot->restored[car] ? &p_snapshot->saved[car] : NULL;
+}
+
+
+void snapshot_save(snapshot_t* p_snapshot, int car, snapshot_state_t* p_state) {
+    const snapshot_state_t* p_saved = &p_snapshot->saved[car];
+    long long now = timer_now_ns() + p_snapshot->wall_offset_ns;
+    for(int i = 0; i < p_state->order_count; i++) {
+        int slot = p_state->orders[i];
+        p_state->accepted_ns[slot] = (p_saved->accepted_ns[slot] != 0) ? p_saved->accepted_ns[slot] : now;
+    }
+    if(memcmp(p_state, p_saved, sizeof(snapshot_state_t)) == 0) {
+        return;
+    }
+
+    // Written to the record of the older save, which stays the current one until the new sequence number is in
+    uint64_t seq = p_snapshot->seq[car] + 1;
+    snapshot_record_t* p_record = &p_snapshot->p_file->records[car][seq & 1];
+    p_record->state = *p_state;
+    p_record->checksum = snapshot_checksum(seq, p_state);
+    atomic_thread_fence(memory_order_release);
+    p_record->seq = seq;
+
+    p_snapshot->saved[car] = *p_state;
+    p_snapshot->seq[car] = seq;
+    p_snapshot->saves++;
+}
+
+
+long long snapshot_timer_ns(const snapshot_t* p_snapshot, long long wall_ns) {
+    return wall_ns - p_snapshot->wall_offset_ns;
+}
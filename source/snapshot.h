@@ -0,0 +1,134 @@
+/**
+ * @file
+ * @brief Snapshot of the controller's state, kept in a memory-mapped file for a warm restart.
+ *
+ * For every car the snapshot holds where the car last was, the orders it had accepted with when
+ * each was accepted, and what it has learned about its travel times and its hall stops. A car
+ * saves its snapshot at the end of every control cycle, and the file is only written when the
+ * snapshot has changed since the last save, which is at a floor, at a tenth of a floor travelled,
+ * and when an order is accepted or served.
+ *
+ * Every car has two records in the file, which its saves alternate between. A record is complete
+ * once its sequence number is written, after the state and a checksum of both, so a controller
+ * that crashes in the middle of a save leaves the previous record to restart from.
+ *
+ * On a restart, a car that stands at the floor its snapshot was saved at takes its orders back and
+ * skips homing. A car anywhere else starts without orders, and one between floors homes towards the
+ * floor nearest to the position of its snapshot. Either way, it keeps what it had learned.
+ */
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <stdint.h>
+
+#include "driver/hardware.h"
+#include "queue.h"
+
+
+#define SNAPSHOT_MAGIC 0x50414e53u      /**< "SNAP", which a snapshot file starts with */
+#define SNAPSHOT_VERSION 1              /**< Layout of the snapshot file */
+#define SNAPSHOT_POSITION_STEPS 10      /**< Steps per floor the position is saved in */
+
+
+/**
+ * What a car saves, as laid out in the snapshot file. Fields are ordered so the struct has no padding.
+ */
+typedef struct{
+    int32_t last_floor;                         /**< The floor whose sensor the car was last at*/
+    int32_t last_dir;                           /**< The @c HardwareMovement the car last moved in*/
+    int32_t position_steps;                     /**< Estimated position, in @c SNAPSHOT_POSITION_STEPS per floor*/
+    int32_t order_count;                        /**< Number of accepted orders*/
+    int64_t accepted_ns[QUEUE_SIZE];            /**< When every accepted order was accepted, on the wall clock, by slot; 0 for no order*/
+    int16_t orders[QUEUE_SIZE];                 /**< Slots of the accepted orders, oldest first. The slot of an order is its
+                                                     @c HardwareOrder times @c HARDWARE_NUMBER_OF_FLOORS plus its floor*/
+    int16_t orders_pad[4 - QUEUE_SIZE % 4];     /**< Keeps the next field aligned; always 0*/
+    double gain;                                /**< @c position_t::gain */
+    int64_t gain_samples;                       /**< @c position_t::gain_samples */
+    int64_t pass_ns[HARDWARE_NUMBER_OF_FLOORS]; /**< @c position_t::pass_ns */
+    int64_t floor_ns;                           /**< @c position_t::floor_ns */
+    int64_t landing_ns[2];                      /**< @c position_t::landing_ns */
+    double hall_stops[HARDWARE_NUMBER_OF_FLOORS];   /**< @c door_t::hall_stops */
+    double hall_total;                          /**< @c door_t::hall_total */
+} snapshot_state_t;
+
+
+/**
+ * One of the two records of a car
+ */
+typedef struct{
+    uint64_t seq;                               /**< Number of the save, written last; the record with the highest valid one is current*/
+    uint64_t checksum;                          /**< Checksum of @c seq and @c state*/
+    snapshot_state_t state;                     /**< The saved state*/
+} snapshot_record_t;
+
+
+/**
+ * The snapshot file
+ */
+typedef struct{
+    uint32_t magic;                             /**< @c SNAPSHOT_MAGIC in a file that holds snapshots*/
+    uint32_t version;                           /**< Layout of the file*/
+    int32_t floors;                             /**< Floors of the building the snapshots are of*/
+    int32_t record_size;                        /**< Size of a record, in bytes*/
+    snapshot_record_t records[HARDWARE_MAX_CARS][2];    /**< The two records of every car*/
+} snapshot_file_t;
+
+
+/**
+ * The snapshots of a controller
+ */
+typedef struct{
+    snapshot_file_t* p_file;                    /**< The mapped file*/
+    long long wall_offset_ns;                   /**< Wall clock time when @c timer_now_ns() is 0*/
+    int restored[HARDWARE_MAX_CARS];            /**< 1 if the file held a valid snapshot of the car when it was opened*/
+    snapshot_state_t saved[HARDWARE_MAX_CARS];  /**< The last snapshot of every car in the file*/
+    uint64_t seq[HARDWARE_MAX_CARS];            /**< Sequence number of the last save of every car*/
+    long long saves;                            /**< Snapshots written since the file was opened*/
+} snapshot_t;
+
+
+/**
+ * @brief Open a snapshot file, and read the last valid snapshot of every car from it
+ *
+ * @param[out] p_snapshot       The snapshots
+ * @param[in] path              The file, which is created if it does not hold snapshots of this building
+ * @param[in] wall_offset_ns    Wall clock time when @c timer_now_ns() is 0, in nanoseconds since the epoch
+ *
+ * @return 0 on success, and -1 if the file could not be opened or mapped
+ */
+int snapshot_open(snapshot_t* p_snapshot, const char* path, long long wall_offset_ns);
+
+
+/**
+ * @brief Unmap the snapshot file, and with it close it
+ */
+void snapshot_close(snapshot_t* p_snapshot);
+
+
+/**
+ * @brief The snapshot of a car the file held when it was opened
+ *
+ * @return The snapshot, or NULL if the file held none of @p car . It stays valid until @p car saves.
+ */
+const snapshot_state_t* snapshot_restored(const snapshot_t* p_snapshot, int car);
+
+
+/**
+ * @brief Save the snapshot of a car, if it has changed
+ *
+ * @param[in, out] p_snapshot   The snapshots
+ * @param[in] car               The car
+ * @param[in, out] p_state      The car's state, with every field but @c accepted_ns filled in and
+ *                              every padding byte 0. Orders that were in the last snapshot keep
+ *                              when they were accepted; new orders are stamped with the time now.
+ */
+void snapshot_save(snapshot_t* p_snapshot, int car, snapshot_state_t* p_state);
+
+
+/**
+ * @brief Time on the timer clock of a time on the wall clock, such as @c snapshot_state_t::accepted_ns
+ */
+long long snapshot_timer_ns(const snapshot_t* p_snapshot, long long wall_ns);
+
+
+#endif //SNAPSHOT_H
@@ -1,13 +1,144 @@
-#include <stdio.h>
-#include <sys/time.h>
+#define _POSIX_C_SOURCE 200809L
+
+#include <stddef.h>
+#include <time.h>
 
 #include "timer.h"
 
 
-void timer_start(){
-    DOOR_TIMER = time(NULL);
+static long long (*timer_clock)() = NULL;
+
+
+static void timer_heap_swap(timer_set_t* p_timers, int a, int b) {
+    timer_id_t tmp = p_timers->heap[a];
+    p_timers->heap[a] = p_timers->heap[b];
+    p_timers->heap[b] = tmp;
+
+    p_timers->heap_index[p_timers->heap[a]] = a;
+    p_timers->heap_index[p_timers->heap[b]] = b;
+}
+
+
+static int timer_heap_less(timer_set_t* p_timers, int a, int b) {
+    return p_timers->deadline_ns[p_timers->heap[a]] < p_timers->deadline_ns[p_timers->heap[b]];
+}
+
+
+static void timer_heap_sift(timer_set_t* p_timers, int idx) {
+    while(idx > 0 && timer_heap_less(p_timers, idx, (idx - 1) / 2)) {
+        timer_heap_swap(p_timers, idx, (idx - 1) / 2);
+        idx = (idx - 1) / 2;
+    }
+
+    while(1) {
+        int smallest = idx;
+        int left = 2 * idx + 1;
+        int right = 2 * idx + 2;
+        if(left < p_timers->heap_size && timer_heap_less(p_timers, left, smallest)) {
+            smallest = left;
+        }
+        if(right < p_timers->heap_size && timer_heap_less(p_timers, right, smallest)) {
+            smallest = right;
+        }
+        if(smallest == idx) {
+            return;
+        }
+        timer_heap_swap(p_timers, idx, smallest);
+        idx = smallest;
+    }
 }
 
-int timer_check(double time_req){
-    return (difftime(time(NULL), DOOR_TIMER) >= time_req);
-}
\ No newline at end of file
+
+void timer_init(timer_set_t* p_timers) {
+    for(int id = 0; id < TIMER_COUNT; id++) {
+        p_timers->deadline_ns[id] = -1;
+        p_timers->heap_index[id] = -1;
+    }
+    p_timers->heap_size = 0;
+}
+
+
+void timer_start(timer_set_t* p_timers, timer_id_t id, long long duration_ns) {
+    p_timers->deadline_ns[id] = timer_now_ns() + duration_ns;
+
+    if(p_timers->heap_index[id] < 0) {
+        p_timers->heap[p_timers->heap_size] = id;
+        p_timers->heap_index[id] = p_timers->heap_size;
+        p_timers->heap_size++;
+    }
+    timer_heap_sift(p_timers, p_timers->heap_index[id]);
+}
+
+
+void timer_cancel(timer_set_t* p_timers, timer_id_t id) {
+    int idx = p_timers->heap_index[id];
+    if(idx < 0) {
+        return;
+    }
+
+    p_timers->heap_size--;
+    if(idx != p_timers->heap_size) {
+        timer_heap_swap(p_timers, idx, p_timers->heap_size);
+        timer_heap_sift(p_timers, idx);
+    }
+
+    p_timers->heap_index[id] = -1;
+    p_timers->deadline_ns[id] = -1;
+}
+
+
+int timer_check(timer_set_t* p_timers, timer_id_t id) {
+    if(p_timers->deadline_ns[id] < 0) {
+        return 1;
+    }
+    if(timer_now_ns() >= p_timers->deadline_ns[id]) {
+        timer_cancel(p_timers, id);
+        return 1;
+    }
+    return 0;
+}
+
+
+int timer_running(const timer_set_t* p_timers, timer_id_t id) {
+    return p_timers->deadline_ns[id] >= 0;
+}
+
+
+long long timer_remaining_ns(const timer_set_t* p_timers, timer_id_t id) {
+    if(p_timers->deadline_ns[id] < 0) {
+        return 0;
+    }
+    long long remaining = p_timers->deadline_ns[id] - timer_now_ns();
+    return (remaining > 0) ? remaining : 0;
+}
+
+
+long long timer_until_next_deadline(timer_set_t* p_timers) {
+    long long now = timer_now_ns();
+
+    // Expired timers read as done either way; dropping them keeps the heap top meaningful
+    while(p_timers->heap_size > 0 && p_timers->deadline_ns[p_timers->heap[0]] <= now) {
+        timer_cancel(p_timers, p_timers->heap[0]);
+    }
+
+    if(p_timers->heap_size == 0) {
+        return -1;
+    }
+    return p_timers->deadline_ns[p_timers->heap[0]] - now;
+}
+
+
+long long timer_now_ns() {
+    if(timer_clock != NULL) {
+        return timer_clock();
+    }
+
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+
+void timer_set_clock(long long (*clock_ns)()) {
+    timer_clock = clock_ns;
+}
@@ -1,34 +1,124 @@
 /**
 * @file
-* @brief Library for the elevator's timer.
+* @brief Library for the elevator's timers.
+*
+* All timers run on @c CLOCK_MONOTONIC with nanosecond deadlines. Every armed timer
+* sits in a small min-heap ordered by deadline, so the control loop can ask how long
+* it may sleep before the next timer expires.
 */
 #ifndef TIMER_H
 #define TIMER_H
 
-#include <time.h>
+
+/**
+ * Enum for the named timers of an elevator
+ */
+typedef enum{
+    TIMER_DOOR,                 /**< How long the door has been held open at a floor*/
+    TIMER_MOTOR_TIMEOUT,        /**< Watchdog for the motor; restarted at every floor sensor while moving*/
+    TIMER_STOP_HOLD,            /**< How long since the stop button was last held in*/
+    TIMER_IDLE_PARK,            /**< How long the elevator has been idle, for parking decisions*/
+    TIMER_COUNT                 /**< Number of timers, not a timer*/
+} timer_id_t;
+
+
+/**
+ * A struct holding a set of named timers
+ */
+typedef struct{
+    long long deadline_ns[TIMER_COUNT];     /**< Deadline of every timer, or -1 if the timer is not running*/
+    timer_id_t heap[TIMER_COUNT];           /**< Running timers, as a binary min-heap on the deadline*/
+    int heap_index[TIMER_COUNT];            /**< Position of every timer in @c heap , or -1 if not running*/
+    int heap_size;                          /**< Number of running timers*/
+} timer_set_t;
+
+
+/**
+ * @brief Initialize @p p_timers with every timer stopped
+ *
+ * @param[out] p_timers     The timers to initialize
+ */
+void timer_init(timer_set_t* p_timers);
+
+
+/**
+ * @brief Start, or restart, a timer
+ *
+ * @param[in, out] p_timers     The set the timer belongs to
+ * @param[in] id                The timer to start
+ * @param[in] duration_ns       Nanoseconds from now until the timer expires
+ */
+void timer_start(timer_set_t* p_timers, timer_id_t id, long long duration_ns);
+
+
+/**
+ * @brief Stop a timer without letting it expire
+ *
+ * @param[in, out] p_timers     The set the timer belongs to
+ * @param[in] id                The timer to stop
+ */
+void timer_cancel(timer_set_t* p_timers, timer_id_t id);
+
+
+/**
+ * @brief Check if a timer is done
+ *
+ * @param[in, out] p_timers     The set the timer belongs to
+ * @param[in] id                The timer to check
+ *
+ * @return 1 if the timer has expired or was never started, 0 if it is still running.
+ */
+int timer_check(timer_set_t* p_timers, timer_id_t id);
+
+
+/**
+ * @brief Check if a timer is running
+ *
+ * @param[in] p_timers  The set the timer belongs to
+ * @param[in] id        The timer to check
+ *
+ * @return 1 if the timer has been started and has not been cancelled or found expired, 0 if not.
+ */
+int timer_running(const timer_set_t* p_timers, timer_id_t id);
+
+
+/**
+ * @brief Find the time until a timer expires
+ *
+ * @param[in] p_timers  The set the timer belongs to
+ * @param[in] id        The timer to look at
+ *
+ * @return Nanoseconds until the timer expires, or 0 if it is done or not running.
+ */
+long long timer_remaining_ns(const timer_set_t* p_timers, timer_id_t id);
 
 
 /**
- * A global timer for the door. This will be reset by @c timer_start() and used by
- * @c timer_check() to compare against a given time reference. 
+ * @brief Find the time until the first running timer expires
+ *
+ * @param[in, out] p_timers     The timers to look through. Timers found to be expired are stopped.
+ *
+ * @return Nanoseconds until the next deadline, or -1 if no timer is running.
  */
-time_t DOOR_TIMER;
+long long timer_until_next_deadline(timer_set_t* p_timers);
 
 
 /**
- * @brief Start the timer by setting the global variable @c DOOR_TIMER to the current time
+ * @brief The current time of the clock the timers run on
+ *
+ * @return Nanoseconds on @c CLOCK_MONOTONIC, or on the clock given to @c timer_set_clock()
  */
-void timer_start();
+long long timer_now_ns();
 
 
 /**
- * @brief Check if a certain amount of time has passed
- * 
- * @param[in] time_req  The time requirement to which we compare time passed.
- * 
- * @return 1 if @p time_req amount of time has passed since @c timer_start() was called, 0 if not.
+ * @brief Replace the clock the timers run on
+ *
+ * @param[in] clock_ns  Function returning the current time in nanoseconds, or NULL for @c CLOCK_MONOTONIC
+ *
+ * This allows simulations on a virtual clock to run the timers faster than real time.
  */
-int timer_check(double time_req);
+void timer_set_clock(long long (*clock_ns)());
 
 
-#endif //TIMER_H
\ No newline at end of file
+#endif //TIMER_H
@@ -0,0 +1,164 @@
+#!/usr/bin/env python3
+"""Generate building.h from a building description.
+
+A building description (see buildings/*.building) gives the number of floors
+and the channel of every per-floor sensor, button and lamp. The lab rig lists
+its channels by their names in source/driver/channels.h; simulated shafts use
+"channels auto", which places the per-floor channels on subdevices that only
+the simulated driver has.
+
+Usage: gen_building.py <description> <output header>
+"""
+
+import math
+import sys
+
+CHANNELS_PER_SUBDEVICE = 256
+FIRST_AUTO_SUBDEVICE = 4   # Subdevices 0-3 belong to the lab rig
+
+PER_FLOOR_KEYS = ["sensor", "button_up", "button_down", "button_cab",
+                  "light_up", "light_down", "light_cab"]
+
+
+def fail(path, lineno, message):
+    sys.exit("%s:%d: %s" % (path, lineno, message))
+
+
+def parse(path):
+    spec = {}
+    with open(path) as f:
+        for lineno, line in enumerate(f, 1):
+            words = line.split("#", 1)[0].split()
+            if not words:
+                continue
+            key, values = words[0], words[1:]
+            if key in spec:
+                fail(path, lineno, "'%s' given twice" % key)
+            if key in ("name", "channels") and len(values) != 1:
+                fail(path, lineno, "'%s' takes one value" % key)
+            if key == "floors":
+                if len(values) != 1 or not values[0].isdigit() or int(values[0]) < 2:
+                    fail(path, lineno, "'floors' takes a number of at least 2")
+                values = int(values[0])
+            elif key in ("name", "channels"):
+                values = values[0]
+            elif key not in PER_FLOOR_KEYS + ["floor_indicator"]:
+                fail(path, lineno, "unknown key '%s'" % key)
+            spec[key] = values
+    if "floors" not in spec:
+        sys.exit("%s: 'floors' is missing" % path)
+    return spec
+
+
+class Allocator:
+    def __init__(self, subdevice):
+        self.subdevice = subdevice
+        self.channel = 0
+
+    def take(self):
+        if self.channel == CHANNELS_PER_SUBDEVICE:
+            self.subdevice += 1
+            self.channel = 0
+        value = "(0x%x+%d)" % (self.subdevice << 8, self.channel)
+        self.channel += 1
+        return value
+
+    def next_subdevice(self):
+        return self.subdevice + (1 if self.channel else 0)
+
+
+def auto_layout(floors):
+    top = floors - 1
+    indicator_bits = max(1, math.ceil(math.log2(floors)))
+    inputs = Allocator(FIRST_AUTO_SUBDEVICE)
+    layout = {
+        "sensor":      [inputs.take() for _ in range(floors)],
+        "button_up":   [inputs.take() if f != top else "-1" for f in range(floors)],
+        "button_down": [inputs.take() if f != 0 else "-1" for f in range(floors)],
+        "button_cab":  [inputs.take() for _ in range(floors)],
+    }
+    outputs = Allocator(inputs.next_subdevice())
+    layout.update({
+        "light_up":   [outputs.take() if f != top else "-1" for f in range(floors)],
+        "light_down": [outputs.take() if f != 0 else "-1" for f in range(floors)],
+        "light_cab":  [outputs.take() for _ in range(floors)],
+        "floor_indicator": [outputs.take() for _ in range(indicator_bits)],
+    })
+    return layout, outputs.next_subdevice()
+
+
+def listed_layout(spec, path):
+    floors = spec["floors"]
+    layout = {}
+    for key in PER_FLOOR_KEYS:
+        if key not in spec:
+            sys.exit("%s: '%s' is missing" % (path, key))
+        if len(spec[key]) != floors:
+            sys.exit("%s: '%s' lists %d channels for %d floors" % (path, key, len(spec[key]), floors))
+        layout[key] = ["-1" if c == "-" else c for c in spec[key]]
+    indicator = spec.get("floor_indicator", [])
+    if 2 ** len(indicator) < floors:
+        sys.exit("%s: %d floor indicator bits cannot show %d floors" % (path, len(indicator), floors))
+    layout["floor_indicator"] = indicator
+    return layout, FIRST_AUTO_SUBDEVICE
+
+
+def table(rows):
+    return "{ \\\n    " + ", \\\n    ".join(rows) + " \\\n}"
+
+
+def main():
+    if len(sys.argv) != 3:
+        sys.exit(__doc__)
+    path, out = sys.argv[1], sys.argv[2]
+    spec = parse(path)
+    floors = spec["floors"]
+    simulated = spec.get("channels") == "auto"
+    if simulated:
+        layout, subdevices = auto_layout(floors)
+    elif "channels" in spec:
+        sys.exit("%s: 'channels' must be 'auto' or left out" % path)
+    else:
+        layout, subdevices = listed_layout(spec, path)
+
+    # Column order follows hardware_order_type_bit(): up, down, cab
+    orders = ["{%s, %s, %s}" % c for c in zip(layout["button_up"], layout["button_down"], layout["button_cab"])]
+    lights = ["{%s, %s, %s}" % c for c in zip(layout["light_up"], layout["light_down"], layout["light_cab"])]
+
+    text = """/* Generated by tools/gen_building.py from {path}. Do not edit. */
+#ifndef BUILDING_H
+#define BUILDING_H
+
+#define BUILDING_NAME "{name}"
+#define HARDWARE_NUMBER_OF_FLOORS {floors}
+
+/* 1 if the channels only exist in the simulated driver */
+#define BUILDING_SIMULATED_ONLY {simulated}
+
+/* Number of digital subdevices the channels below are spread over */
+#define BUILDING_SUBDEVICES {subdevices}
+
+/* Channel tables, indexed by floor. Order columns are {{up, down, cab}} */
+#define BUILDING_SENSOR_CHANNELS {sensors}
+
+#define BUILDING_ORDER_CHANNELS {orders}
+
+#define BUILDING_LIGHT_CHANNELS {lights}
+
+/* Binary floor indicator, most significant bit first */
+#define BUILDING_FLOOR_INDICATOR_BITS {indicator_bits}
+#define BUILDING_FLOOR_INDICATOR_CHANNELS {{ {indicator} }}
+
+#endif //BUILDING_H
+""".format(path=path, name=spec.get("name", "building"), floors=floors, simulated=int(simulated),
+           subdevices=subdevices,
+           sensors="{ " + ", ".join(layout["sensor"]) + " }",
+           orders=table(orders), lights=table(lights),
+           indicator_bits=len(layout["floor_indicator"]), indicator=", ".join(layout["floor_indicator"]))
+
+    with open(out, "w") as f:
+        f.write(text)
+
+
+if __name__ == "__main__":
+    main()
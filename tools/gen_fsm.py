@@ -0,0 +1,158 @@
+#!/usr/bin/env python3
+"""Generate the elevator's transition table from its state diagram.
+
+Every state in the diagram is a box whose title is a STATE_* name. Transitions
+are the edges between the boxes, labelled one trigger per line as
+
+    EVENT_<name> [<guard>, !<guard>, ...] / ACTION_<name>
+
+where the guard list is optional and "-" stands for ACTION_DO_NOTHING. Lines of
+the same form inside a state box are transitions back into that state. The
+enter/exit lines of the boxes are not read; they are implemented by hand in
+elevator_fsm.c.
+
+Within one state and event, transitions are tried with the most guards first,
+and the first one whose guards all hold is taken. If none holds, the elevator
+stays in its state and does nothing.
+
+Names are checked against the enums in elevator_fsm.h, so a label that the
+code does not know about fails the build.
+
+Usage: gen_fsm.py <diagram.drawio> <elevator_fsm.h> <output header>
+"""
+
+import base64
+import html
+import re
+import sys
+import urllib.parse
+import xml.etree.ElementTree as ET
+import zlib
+
+TRIGGER = re.compile(r"(EVENT_\w+)\s*(?:\[([^\]]*)\])?\s*/\s*(ACTION_\w+|-)")
+
+
+def read_model(path):
+    diagram = ET.parse(path).getroot().find("diagram")
+    if diagram is None:
+        sys.exit("%s: no diagram" % path)
+    if diagram.find("mxGraphModel") is not None:
+        return diagram.find("mxGraphModel")
+    # Compressed diagrams are deflated, base64 encoded and URL encoded
+    text = zlib.decompress(base64.b64decode(diagram.text), -15).decode()
+    return ET.fromstring(urllib.parse.unquote(text))
+
+
+def plain_text(value):
+    value = re.sub(r"<br\s*/?>|</?div>|</?p[^>]*>|<hr\s*/?>", "\n", value or "")
+    value = html.unescape(re.sub(r"<[^>]+>", "", value))
+    return value.replace("\xa0", " ")
+
+
+def read_enum(header, typedef):
+    match = re.search(r"typedef enum\s*\{([^{}]*)\}\s*%s;" % typedef, header)
+    if match is None:
+        sys.exit("elevator_fsm.h: enum %s not found" % typedef)
+    body = re.sub(r"/\*.*?\*/|//[^\n]*", "", match.group(1), flags=re.S)
+    return [entry.split("=")[0].strip() for entry in body.split(",") if entry.strip()]
+
+
+def parse_triggers(text, where, names):
+    triggers = []
+    for event, guards, action in TRIGGER.findall(text):
+        action = "ACTION_DO_NOTHING" if action == "-" else action
+        required, forbidden = [], []
+        for guard in filter(None, (g.strip() for g in (guards or "").split(","))):
+            negated = guard.startswith("!")
+            guard = "GUARD_" + guard.lstrip("!").strip()
+            (forbidden if negated else required).append(guard)
+        for name in [event, action] + required + forbidden:
+            if name not in names:
+                sys.exit("%s: '%s' is not declared in elevator_fsm.h" % (where, name))
+        triggers.append((event, required, forbidden, action))
+    return triggers
+
+
+def mask(guards):
+    return " | ".join(guards) if guards else "0"
+
+
+def main():
+    if len(sys.argv) != 4:
+        sys.exit(__doc__)
+    diagram_path, header_path, out = sys.argv[1:]
+    with open(header_path) as f:
+        header = f.read()
+    states = read_enum(header, "elevator_state_t")
+    events = read_enum(header, "elevator_event_t")
+    names = set(states + events + read_enum(header, "elevator_action_t") +
+                read_enum(header, "elevator_guard_bit_t"))
+
+    model = read_model(diagram_path)
+    boxes = {}
+    transitions = {}   # (state, event) -> [(required, forbidden, next state, action)]
+    for cell in model.iter("mxCell"):
+        text = plain_text(cell.get("value"))
+        title = text.strip().split("\n")[0].strip()
+        if cell.get("vertex") and title in states:
+            boxes[cell.get("id")] = title
+    for cell in model.iter("mxCell"):
+        text = plain_text(cell.get("value"))
+        if cell.get("id") in boxes:
+            state = boxes[cell.get("id")]
+            source, target, where = state, state, "state %s" % state
+        elif cell.get("edge") and TRIGGER.search(text):
+            source, target = boxes.get(cell.get("source")), boxes.get(cell.get("target"))
+            where = "edge '%s'" % " ".join(text.split())
+            if source is None or target is None:
+                sys.exit("%s: %s is not connected to two states" % (diagram_path, where))
+        elif TRIGGER.search(text):
+            sys.exit("%s: label '%s' is not attached to an edge" % (diagram_path, " ".join(text.split())))
+        else:
+            continue
+        for event, required, forbidden, action in parse_triggers(text, "%s: %s" % (diagram_path, where), names):
+            transitions.setdefault((source, event), []).append((required, forbidden, target, action))
+
+    missing = [s for s in states if s not in boxes.values() and s != "STATE_COUNT"]
+    if missing:
+        sys.exit("%s: no box for %s" % (diagram_path, ", ".join(missing)))
+
+    rows, index = [], []
+    for state in states:
+        if state == "STATE_COUNT":
+            continue
+        cells = []
+        rows.append("/* %s */" % state)
+        for event in events:
+            if event == "EVENT_COUNT":
+                continue
+            candidates = sorted(transitions.get((state, event), []), key=lambda t: -(len(t[0]) + len(t[1])))
+            first = sum(1 for r in rows if not r.startswith("/*"))
+            cells.append("{%d, %d}" % (first, len(candidates)))
+            for required, forbidden, target, action in candidates:
+                rows.append("{%s, %s, %s, %s}," % (mask(required), mask(forbidden), target, action))
+        index.append("{ " + ", ".join(cells) + " }")
+
+    text = """/* Generated by tools/gen_fsm.py from {diagram}. Do not edit. */
+#ifndef ELEVATOR_FSM_TABLE_H
+#define ELEVATOR_FSM_TABLE_H
+
+/* Transitions grouped by state and event, most guards first: {{required, forbidden, next state, action}} */
+#define ELEVATOR_FSM_TRANSITIONS {{ \\
+    {rows} \\
+}}
+
+/* {{first transition, number of transitions}} for every [state][event] */
+#define ELEVATOR_FSM_INDEX {{ \\
+    {index} \\
+}}
+
+#endif //ELEVATOR_FSM_TABLE_H
+""".format(diagram=diagram_path, rows=" \\\n    ".join(rows), index=", \\\n    ".join(index))
+
+    with open(out, "w") as f:
+        f.write(text)
+
+
+if __name__ == "__main__":
+    main()
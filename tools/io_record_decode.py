@@ -0,0 +1,100 @@
+#!/usr/bin/env python3
+"""Print the records of a hardware I/O recording made with -R.
+
+The layout is described in source/driver/io_record.h. Every record is printed
+with its time, car and kind, and for digital words the bits that changed, one
+line per bit, named after the channel if source/driver/channels.h names it.
+To compare a replay with the original, decode both with --outputs and diff.
+
+Usage: io_record_decode.py [--inputs | --outputs] [--car <n>] <recording>
+"""
+
+import argparse
+import os
+import re
+import struct
+import sys
+
+MAGIC = b"ELVIORC\0"
+VERSION = 1
+HEADER = struct.Struct("<8sIIIIqQ")
+KINDS = ("in", "out", "analog")
+
+
+def read_channel_names(path):
+    names = {}
+    with open(path) as channels:
+        for name, subdevice, channel in re.findall(r"#define\s+(\w+)\s+\(0x(\w+)\+(\d+)\)", channels.read()):
+            names[int(subdevice, 16) + int(channel)] = name
+    return names
+
+
+def read_varint(data, cursor):
+    value = 0
+    shift = 0
+    while True:
+        byte = data[cursor]
+        cursor += 1
+        value |= (byte & 0x7F) << shift
+        shift += 7
+        if not byte & 0x80:
+            return value, cursor
+
+
+def read_records(data):
+    magic, version, rate_hz, cars, _, start_ns, length = HEADER.unpack_from(data)
+    if magic != MAGIC or version != VERSION:
+        sys.exit("not a version %d recording" % VERSION)
+    records = data[HEADER.size:HEADER.size + length]
+
+    cursor = 0
+    time_us = 0
+    try:
+        while cursor < len(records):
+            tag, cursor = read_varint(records, cursor)
+            car = records[cursor]
+            channel, cursor = read_varint(records, cursor + 1)
+            value, cursor = read_varint(records, cursor)
+            time_us += tag >> 2
+            yield time_us, KINDS[tag & 3], car, channel, value
+    except (IndexError, KeyError):
+        print("recording ends in a partial record", file=sys.stderr)
+
+
+def main():
+    parser = argparse.ArgumentParser(usage=__doc__.split("\n\n")[2][len("Usage: "):])
+    parser.add_argument("recording")
+    parser.add_argument("--car", type=int)
+    parser.add_argument("--inputs", action="store_true")
+    parser.add_argument("--outputs", action="store_true")
+    args = parser.parse_args()
+
+    names = read_channel_names(os.path.join(os.path.dirname(__file__), "..", "source", "driver", "channels.h"))
+    with open(args.recording, "rb") as recording:
+        data = recording.read()
+    _, _, rate_hz, cars, _, _, length = HEADER.unpack_from(data)
+    print("# %d car(s) at %d Hz, %d bytes of records" % (cars, rate_hz, length))
+
+    words = {}
+    for time_us, kind, car, channel, value in read_records(data):
+        if args.car is not None and car != args.car:
+            continue
+        if (args.inputs and kind != "in") or (args.outputs and kind == "in"):
+            continue
+
+        if kind == "analog":
+            print("%12.6f car %-2d %-6s %-16s %d" % (time_us * 1e-6, car, kind, names.get(channel, hex(channel)), value))
+            continue
+
+        # Words hold the changed bits; the current value is kept to print the new state of each bit
+        word = words.get((kind, car, channel), 0) ^ value
+        words[(kind, car, channel)] = word
+        base = (channel >> 8) * 0x100 + (channel & 0xFF)
+        for bit in range(32):
+            if value >> bit & 1:
+                print("%12.6f car %-2d %-6s %-16s %d" % (time_us * 1e-6, car, kind, names.get(base + bit, hex(base + bit)),
+                                                       word >> bit & 1))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,116 @@
+#!/usr/bin/env python3
+"""Print the records of elevator journal files, optionally filtered.
+
+The journal is written by the controller when it is started with -j <file>.
+Its layout is journal_record_t in source/journal.h, and the names of states,
+events, actions and guards are read from source/elevator_fsm.h, so the output
+follows the code. Files are read in the order given; pass rotated files oldest
+first, e.g. journal.3 journal.2 journal.1 journal.
+
+Usage: journal_decode.py [options] <journal file>...
+
+  --header <elevator_fsm.h>   where to read the names from
+  --car <n>                   only records of car n
+  --state <STATE_x>           only records entering or leaving the state
+  --event <EVENT_x>           only records with the event
+  --action <ACTION_x>         only records with the action
+  --since <s> / --until <s>   only records in this span of the timer clock
+  --transitions               only records where the state changes
+"""
+
+import argparse
+import os
+import re
+import struct
+import sys
+
+from gen_fsm import read_enum
+
+MAGIC = b"ELVJRNL\0"
+VERSION = 1
+HEADER = struct.Struct("<8sII")
+RECORD = struct.Struct("<qIIBBBBBBBbhhI")
+
+
+def read_guards(header):
+    match = re.search(r"typedef enum\s*\{([^{}]*)\}\s*elevator_guard_bit_t;", header)
+    if match is None:
+        sys.exit("elevator_fsm.h: enum elevator_guard_bit_t not found")
+    body = re.sub(r"/\*.*?\*/|//[^\n]*", "", match.group(1), flags=re.S)
+    guards = {}
+    for name, shift in re.findall(r"(GUARD_\w+)\s*=\s*1\s*<<\s*(\d+)", body):
+        guards[1 << int(shift)] = name[len("GUARD_"):]
+    return guards
+
+
+def read_records(path):
+    with open(path, "rb") as journal:
+        magic, version, record_size = HEADER.unpack(journal.read(HEADER.size))
+        if magic != MAGIC or version != VERSION or record_size != RECORD.size:
+            sys.exit("%s: not a version %d journal" % (path, VERSION))
+        while True:
+            data = journal.read(RECORD.size)
+            if len(data) < RECORD.size:
+                return
+            yield RECORD.unpack(data)
+
+
+def describe_guards(guards, consulted, names):
+    held = [names[bit] for bit in sorted(names) if consulted & bit and guards & bit]
+    failed = ["!" + names[bit] for bit in sorted(names) if consulted & bit and not guards & bit]
+    return "[%s]" % ", ".join(held + failed) if consulted else ""
+
+
+def main():
+    parser = argparse.ArgumentParser(usage=__doc__.split("\n\n")[2].split("\n")[0][len("Usage: "):])
+    parser.add_argument("files", nargs="+")
+    parser.add_argument("--header", default=os.path.join(os.path.dirname(__file__), "..", "source", "elevator_fsm.h"))
+    parser.add_argument("--car", type=int)
+    parser.add_argument("--state")
+    parser.add_argument("--event")
+    parser.add_argument("--action")
+    parser.add_argument("--since", type=float)
+    parser.add_argument("--until", type=float)
+    parser.add_argument("--transitions", action="store_true")
+    args = parser.parse_args()
+
+    with open(args.header) as header_file:
+        header = header_file.read()
+    states = read_enum(header, "elevator_state_t")
+    events = read_enum(header, "elevator_event_t")
+    actions = read_enum(header, "elevator_action_t")
+    guards = read_guards(header)
+
+    def name(names, index):
+        return names[index] if index < len(names) else "#%d" % index
+
+    for path in args.files:
+        for (time_ns, sequence, dropped, car, event, from_state, to_state, action,
+             guard_mask, consulted, direction, floor, last_floor, _) in read_records(path):
+            seconds = time_ns / 1e9
+            if args.car is not None and car != args.car:
+                continue
+            if args.state and args.state not in (name(states, from_state), name(states, to_state)):
+                continue
+            if args.event and name(events, event) != args.event:
+                continue
+            if args.action and name(actions, action) != args.action:
+                continue
+            if args.since is not None and seconds < args.since:
+                continue
+            if args.until is not None and seconds > args.until:
+                continue
+            if args.transitions and from_state == to_state:
+                continue
+
+            if dropped:
+                print("%14s  ... %d records dropped" % ("", dropped))
+            arrow = "->" if from_state != to_state else "  "
+            print("%14.6f car %-2d #%-8d %-17s %s %-17s %-23s %-23s floor %2d last %2d dir %+d %s" % (
+                seconds, car, sequence, name(states, from_state), arrow, name(states, to_state),
+                name(events, event), name(actions, action), floor, last_floor, direction,
+                describe_guards(guard_mask, consulted, guards)))
+
+
+if __name__ == "__main__":
+    main()